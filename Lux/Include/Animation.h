@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class AnimationPath : uint8_t
+{
+	Translation,
+	Rotation,
+	Scale
+};
+
+// Same order as glTF samplers.
+enum class AnimationInterpolation : uint8_t
+{
+	Linear,
+	Step,
+	CubicSpline
+};
+
+// Keys of one property of one scene graph node. Rotations are x, y, z, w
+// quaternions, translations and scales leave w unused. Cubic spline
+// channels store an in tangent, the value and an out tangent per key.
+struct AnimationChannel
+{
+	uint32_t node;
+	AnimationPath path;
+	AnimationInterpolation interpolation;
+	std::vector<float> times;
+	std::vector<glm::vec4> values;
+};
+
+struct Animation
+{
+	std::string name;
+	std::vector<AnimationChannel> channels;
+	// Time of the last key of any channel.
+	float duration{ 0.0f };
+};
+
+// Value of the channel at time in seconds, held at the first and last key
+// outside of them. Rotations come back normalized.
+const glm::vec4 SampleChannel(const AnimationChannel& channel, float time) noexcept;
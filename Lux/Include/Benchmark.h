@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+// Builds the mesh hierarchies of the Lantern and of large synthetic meshes,
+// one of them on a ground made of two huge triangles, with every build mode
+// and node layout. Prints the build time next to the time it takes to trace
+// one primary ray per pixel, so a fast build can be weighed against a fast
+// trace, followed by the memory footprint of each hierarchy. Timings are
+// the median over repetitions. Ends with RunLeakTest, and returns false when
+// it leaks or when a hierarchy hits a different number of primary rays than
+// the SAH one.
+const bool RunBvhBenchmark(int32_t width, int32_t height, uint32_t repetitions);
+
+// Fires rays through the shared edges and vertices of a closed mesh with both
+// triangle tests and counts the rays that leak through. Returns false when
+// any leaks through the watertight test.
+const bool RunLeakTest();
+
+// Renders each reference scene, lit by a procedural sky with a small sun,
+// with every sampler at 1, 2, 4, ... up to maxSamples samples per pixel and
+// prints the root mean square error against a converged Sobol image of
+// 16 * maxSamples samples, with the slope of the error over sample count on
+// a log-log scale. The same numbers go to Lux.convergence.csv for plotting.
+void RunSamplerBenchmark(int32_t width, int32_t height, uint32_t maxSamples);
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <limits>
+
+struct Bounds
+{
+	glm::vec3 minimum{ std::numeric_limits<float>::max() };
+	glm::vec3 maximum{ -std::numeric_limits<float>::max() };
+};
+
+inline void Grow(Bounds& bounds, glm::vec3 point) noexcept
+{
+	bounds.minimum = glm::min(bounds.minimum, point);
+	bounds.maximum = glm::max(bounds.maximum, point);
+}
+
+inline void Grow(Bounds& bounds, const Bounds& other) noexcept
+{
+	bounds.minimum = glm::min(bounds.minimum, other.minimum);
+	bounds.maximum = glm::max(bounds.maximum, other.maximum);
+}
+
+// Empty when the boxes do not overlap.
+inline const Bounds Intersection(const Bounds& a, const Bounds& b) noexcept
+{
+	return Bounds{ glm::max(a.minimum, b.minimum), glm::min(a.maximum, b.maximum) };
+}
+
+inline const bool IsEmpty(const Bounds& bounds) noexcept
+{
+	return bounds.minimum.x > bounds.maximum.x || bounds.minimum.y > bounds.maximum.y || bounds.minimum.z > bounds.maximum.z;
+}
+
+inline const glm::vec3 Centroid(const Bounds& bounds) noexcept
+{
+	return 0.5f * (bounds.minimum + bounds.maximum);
+}
+
+inline const float SurfaceArea(const Bounds& bounds) noexcept
+{
+	if (IsEmpty(bounds))
+	{
+		return 0.0f;
+	}
+
+	glm::vec3 extent = bounds.maximum - bounds.minimum;
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// Box moving linearly from start at time 0 to end at time 1.
+inline const Bounds Interpolate(const Bounds& start, const Bounds& end, float time) noexcept
+{
+	return Bounds{ start.minimum + time * (end.minimum - start.minimum), start.maximum + time * (end.maximum - start.maximum) };
+}
+
+inline const Bounds Transform(const Bounds& bounds, const glm::mat4& matrix) noexcept
+{
+	if (IsEmpty(bounds))
+	{
+		return bounds;
+	}
+
+	Bounds transformed{};
+	for (int corner{ 0 }; corner < 8; ++corner)
+	{
+		glm::vec3 point
+		{
+			corner & 1 ? bounds.maximum.x : bounds.minimum.x,
+			corner & 2 ? bounds.maximum.y : bounds.minimum.y,
+			corner & 4 ? bounds.maximum.z : bounds.minimum.z
+		};
+		Grow(transformed, glm::vec3{ matrix * glm::vec4{ point, 1.0f } });
+	}
+	return transformed;
+}
+
+// Exit distances of slab tests are scaled by 1 + 2 * gamma(3) to cover the
+// rounding of the subtraction and multiplication (Ize, "Robust BVH Ray
+// Traversal"). Otherwise rays through a vertex or edge lying on a box face
+// can miss the box and leak through a watertight mesh.
+constexpr float slabExitScale = 1.0f + 2.0f * (3.0f * 0x1p-24f) / (1.0f - 3.0f * 0x1p-24f);
+
+// Slab test. Returns the entry distance, or infinity when the box is missed
+// or lies entirely beyond maxDistance.
+inline const float IntersectBounds(const Bounds& bounds, glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance) noexcept
+{
+	float entry{ 0.0f };
+	float exit{ maxDistance };
+	for (int axis{ 0 }; axis < 3; ++axis)
+	{
+		const bool negative = inverseDirection[axis] < 0.0f;
+		const float nearPlane = negative ? bounds.maximum[axis] : bounds.minimum[axis];
+		const float farPlane = negative ? bounds.minimum[axis] : bounds.maximum[axis];
+
+		// A ray parallel to and inside a face plane makes 0 * infinity, the
+		// NaN is ignored because it is the second argument.
+		entry = std::max(entry, (nearPlane - origin[axis]) * inverseDirection[axis]);
+		exit = std::min(exit, slabExitScale * ((farPlane - origin[axis]) * inverseDirection[axis]));
+	}
+
+	return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
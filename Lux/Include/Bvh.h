@@ -0,0 +1,198 @@
+#pragma once
+#include "Bounds.h"
+#include "Statistics.h"
+
+#include <glm/vec3.hpp>
+#include <gsl/span>
+
+#include <array>
+#include <utility>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class ThreadPool;
+
+// Interior nodes store the index of their left child in offset, the right
+// child always directly follows it. Leaves store the first entry in
+// primitiveIndices and a non-zero primitiveCount.
+struct BvhNode
+{
+	Bounds bounds;
+	uint32_t offset;
+	uint32_t primitiveCount;
+};
+
+struct Bvh
+{
+	std::vector<BvhNode> nodes;
+	std::vector<uint32_t> primitiveIndices;
+	// SAH cost right after the last full build, refits are measured against it.
+	float builtSahCost{ 0.0f };
+	// Empty unless built for motion blur by RefitMotionBvh. Node bounds then
+	// hold the bounds at time 0 and these the ones at time 1, parallel to
+	// nodes, and traversal interpolates between them.
+	std::vector<Bounds> endBounds;
+};
+
+enum class BvhBuildMode
+{
+	// Binned surface area heuristic, slower to build but cheaper to trace.
+	Sah,
+	// Sorts centroids along a Morton curve, for hierarchies rebuilt every frame.
+	Linear,
+	// SAH with spatial splits (Stich et al. 2009), primitives straddling a
+	// split are referenced by both children so nodes overlap less.
+	Spatial
+};
+
+struct BvhBuildSettings
+{
+	uint32_t maxLeafSize{ 4 };
+	uint32_t binCount{ 16 };
+	float traversalCost{ 1.0f };
+	float intersectionCost{ 1.0f };
+	BvhBuildMode mode{ BvhBuildMode::Sah };
+	// Linear builds only: 30 or 63 bit Morton codes.
+	uint32_t mortonBits{ 30 };
+	// Linear builds run their sort and emission on these workers when set,
+	// they must not be built from inside one of its jobs.
+	ThreadPool* threadPool{ nullptr };
+	// Spatial builds only try spatial splits when the children of the best
+	// object split overlap by more than this fraction of the root area.
+	float spatialSplitAlpha{ 1e-5f };
+	// Spatial builds stop splitting once they added this fraction of the
+	// primitive count as extra references.
+	float spatialSplitBudget{ 0.3f };
+};
+
+// Parent links and the leaf holding every primitive, needed to refit only
+// the paths above primitives that moved. Spatial builds reference primitives
+// from more than one leaf and can only be refit as a whole.
+struct BvhTopology
+{
+	std::vector<uint32_t> parents;
+	std::vector<uint32_t> primitiveLeaves;
+};
+
+// Once refitting made a tree this much more expensive than it was when it
+// was built, rebuilding pays off.
+constexpr float bvhRebuildThreshold = 1.5f;
+
+const Bvh BuildBvh(gsl::span<const Bounds> primitiveBounds, const BvhBuildSettings& settings = {});
+// Karras style builder, every leaf holds a single primitive.
+const Bvh BuildLinearBvh(gsl::span<const Bounds> primitiveBounds, const BvhBuildSettings& settings = {});
+// trianglePositions holds three corners per primitive and lets spatial
+// splits clip triangles exactly, without it the bounds are split as boxes.
+// primitiveIndices can hold a primitive more than once.
+const Bvh BuildSpatialBvh(gsl::span<const Bounds> primitiveBounds, gsl::span<const glm::vec3> trianglePositions, const BvhBuildSettings& settings = {});
+const BvhTopology ComputeTopology(const Bvh& bvh);
+
+// Expected cost of a random ray relative to the root, using the build cost model.
+const float ComputeSahCost(const Bvh& bvh, const BvhBuildSettings& settings = {}) noexcept;
+
+// Recomputes all node bounds bottom up while keeping the tree structure.
+void RefitBvh(Bvh& bvh, gsl::span<const Bounds> primitiveBounds) noexcept;
+// Only touches the leaves of changedPrimitives and their ancestors, and stops
+// walking up as soon as a node's bounds come out unchanged.
+void RefitBvh(Bvh& bvh, const BvhTopology& topology, gsl::span<const Bounds> primitiveBounds, gsl::span<const uint32_t> changedPrimitives) noexcept;
+
+// Keeps the tree and fits its nodes to primitives moving linearly from
+// startBounds at time 0 to endBounds at time 1. A node interpolated between
+// its two boxes contains its primitives at any time in between, and stays
+// much smaller than a box around their whole sweep.
+void RefitMotionBvh(Bvh& bvh, gsl::span<const Bounds> startBounds, gsl::span<const Bounds> endBounds);
+
+// Linear builds can go as deep as the Morton code plus the index bits that
+// separate duplicate codes.
+constexpr uint32_t bvhMaxDepth = 96;
+
+// Visits the leaves whose bounds the ray enters before maxDistance, nearest
+// child first. intersectPrimitive(primitiveIndex, maxDistance) may shorten
+// maxDistance when it finds a closer hit and returns true to stop early.
+// Motion hierarchies are traversed as they are at time.
+template <typename IntersectPrimitive>
+void TraverseBvh(const Bvh& bvh, glm::vec3 origin, glm::vec3 direction, float& maxDistance, IntersectPrimitive&& intersectPrimitive, float time = 0.0f) noexcept
+{
+	if (bvh.nodes.empty())
+	{
+		return;
+	}
+
+	struct StackEntry
+	{
+		uint32_t nodeIndex;
+		float distance;
+	};
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	const bool moving = !bvh.endBounds.empty();
+	const auto intersectNode = [&](uint32_t nodeIndex)
+	{
+		if (moving)
+		{
+			return IntersectBounds(Interpolate(bvh.nodes[nodeIndex].bounds, bvh.endBounds[nodeIndex], time), origin, inverseDirection, maxDistance);
+		}
+		return IntersectBounds(bvh.nodes[nodeIndex].bounds, origin, inverseDirection, maxDistance);
+	};
+
+	std::array<StackEntry, bvhMaxDepth> stack;
+	size_t stackSize{ 0 };
+
+	float rootDistance = intersectNode(0);
+	if (rootDistance == std::numeric_limits<float>::infinity())
+	{
+		return;
+	}
+	stack[stackSize++] = StackEntry{ 0, rootDistance };
+
+	while (stackSize > 0)
+	{
+		const StackEntry entry = stack[--stackSize];
+		if (entry.distance > maxDistance)
+		{
+			continue;
+		}
+
+		uint32_t nodeIndex = entry.nodeIndex;
+		while (true)
+		{
+			LUX_STATISTIC_INCREMENT(NodeVisits);
+			const BvhNode& node = bvh.nodes[nodeIndex];
+
+			if (node.primitiveCount > 0)
+			{
+				for (uint32_t i{ 0 }; i < node.primitiveCount; ++i)
+				{
+					if (intersectPrimitive(bvh.primitiveIndices[node.offset + i], maxDistance))
+					{
+						return;
+					}
+				}
+				break;
+			}
+
+			uint32_t nearChild = node.offset;
+			uint32_t farChild = node.offset + 1;
+			float nearDistance = intersectNode(nearChild);
+			float farDistance = intersectNode(farChild);
+
+			if (farDistance < nearDistance)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(nearDistance, farDistance);
+			}
+
+			if (nearDistance == std::numeric_limits<float>::infinity())
+			{
+				break;
+			}
+
+			if (farDistance != std::numeric_limits<float>::infinity())
+			{
+				stack[stackSize++] = StackEntry{ farChild, farDistance };
+			}
+			nodeIndex = nearChild;
+		}
+	}
+}
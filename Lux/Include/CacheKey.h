@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// What a file in the cache directory was built from. Cached files store it
+// in their header and are only used while it still matches, so neither a
+// hash collision of the file names nor a changed source goes unnoticed.
+struct CacheKey
+{
+	// Canonical path of the source, followed by anything else that went
+	// into the cached file.
+	std::string identity;
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+
+	bool operator==(const CacheKey&) const = default;
+};
+
+// Nullopt when the source does not exist.
+const std::optional<CacheKey> MakeCacheKey(const std::filesystem::path& sourcePath, std::string_view suffix = {});
+// Named after the hash of the identity.
+const std::filesystem::path CachePath(const std::filesystem::path& cacheDirectory, const CacheKey& key, std::string_view extension);
+
+void WriteCacheKey(std::ostream& file, const CacheKey& key);
+const std::optional<CacheKey> ReadCacheKey(std::istream& file);
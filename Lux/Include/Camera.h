@@ -1,13 +1,93 @@
 #pragma once
 
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <gsl/span>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+enum class CameraModel
+{
+	Pinhole,
+	// Depth of field: rays start on a lens disc and meet on the image plane,
+	// which lies at the focus distance.
+	ThinLens,
+	// Parallel rays from an image plane through the camera position.
+	Orthographic,
+	// The full sphere around the camera, 360 degrees across the image and
+	// 180 degrees up it.
+	Equirectangular
+};
 
 struct Camera
 {
 	Camera(glm::vec3 position, glm::vec3 lookat, float vfov, float aspect);
 
-    glm::vec3 position;
-    glm::vec3 lower_left_corner;
-    glm::vec3 horizontal;
-    glm::vec3 vertical;
-};
\ No newline at end of file
+	CameraModel model{ CameraModel::Pinhole };
+	glm::vec3 position;
+	// Image plane, at distance one for a pinhole, at the focus distance for a
+	// thin lens and through position for orthographic cameras. Unused by
+	// equirectangular cameras.
+	glm::vec3 lower_left_corner;
+	glm::vec3 horizontal;
+	glm::vec3 vertical;
+	glm::vec3 right;
+	glm::vec3 up;
+	glm::vec3 forward;
+	// Half the image plane at distance one, in world units for orthographic
+	// cameras.
+	float halfWidth;
+	float halfHeight;
+	float focusDistance{ 1.0f };
+	float lensRadius{ 0.0f };
+	// Omnidirectional stereo: equirectangular rays start this far to the
+	// right of position, seen along their own direction. Half the eye
+	// distance, negative for the left eye.
+	float stereoOffset{ 0.0f };
+};
+
+const Camera MakeThinLensCamera(glm::vec3 position, glm::vec3 lookat, float vfov, float aspect, float lensRadius, float focusDistance);
+// viewHeight is the height of the image in world units.
+const Camera MakeOrthographicCamera(glm::vec3 position, glm::vec3 lookat, float viewHeight, float aspect);
+const Camera MakeEquirectangularCamera(glm::vec3 position, glm::vec3 lookat);
+// Left and right eye, eyeDistance apart. Planar cameras become two copies
+// moved sideways with parallel axes, equirectangular ones omnidirectional
+// stereo pairs.
+const std::array<Camera, 2> MakeStereoPair(const Camera& camera, float eyeDistance);
+// Moves and turns the camera, keeping its model and lens.
+void AimCamera(Camera& camera, glm::vec3 position, glm::vec3 lookat);
+
+// Ray cone of a pixel for texture filtering: the width at the camera and
+// how fast it widens with distance.
+const float PixelConeWidth(const Camera& camera, int32_t imageHeight) noexcept;
+const float PixelSpreadAngle(const Camera& camera, int32_t imageHeight) noexcept;
+
+// Block of pixels rendered as a unit.
+struct Tile
+{
+	int32_t x;
+	int32_t y;
+	int32_t width;
+	int32_t height;
+};
+
+// Rays through the pixels of a tile in row order, one array per component
+// so they are generated eight at a time. Directions are normalized.
+struct CameraRays
+{
+	std::vector<float> originX;
+	std::vector<float> originY;
+	std::vector<float> originZ;
+	std::vector<float> directionX;
+	std::vector<float> directionY;
+	std::vector<float> directionZ;
+};
+
+// Fills rays for the pixels of tile in an imageWidth by imageHeight image.
+// jitter holds the position within each pixel in [0, 1)^2, in the same
+// order as the rays, or is empty to go through the pixel centers. Thin lens
+// cameras pick a point on the lens from lensSamples the same way, the lens
+// center when it is empty. The camera model is dispatched once per call.
+void GenerateCameraRays(const Camera& camera, int32_t imageWidth, int32_t imageHeight, const Tile& tile, gsl::span<const glm::vec2> jitter, gsl::span<const glm::vec2> lensSamples, CameraRays& rays);
@@ -0,0 +1,45 @@
+#pragma once
+#include "Renderer.h"
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstdint>
+
+enum class DisplayFormat
+{
+	Srgb8,
+	Half
+};
+
+// Streams the framebuffer into an immutable display texture through a ring of
+// persistently mapped pixel buffer objects. Render workers pack their finished
+// tiles straight into the mapped buffer, the main thread only issues the copy.
+class DisplayUploader
+{
+public:
+	bool Initialize(int32_t width, int32_t height, DisplayFormat format);
+	void Shutdown();
+
+	// Waits until the GPU is done reading the buffer that is about to be written.
+	void BeginFrame();
+	// Safe to call from several threads at once as long as the tiles do not overlap.
+	void PackTile(const Framebuffer& framebuffer, const Tile& tile) noexcept;
+	void EndFrame();
+
+	GLuint GetTexture() const noexcept;
+
+private:
+	constexpr static uint32_t ringSize = 3;
+
+	int32_t width{ 0 };
+	int32_t height{ 0 };
+	DisplayFormat format{ DisplayFormat::Srgb8 };
+	size_t bytesPerPixel{ 0 };
+
+	GLuint texture{ 0 };
+	std::array<GLuint, ringSize> buffers{};
+	std::array<uint8_t*, ringSize> mappedData{};
+	std::array<GLsync, ringSize> fences{};
+	uint32_t currentSlot{ 0 };
+};
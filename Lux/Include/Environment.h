@@ -0,0 +1,52 @@
+#pragma once
+#include "CacheKey.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+// Equirectangular radiance around the scene, +Y up. Row 0 is the zenith,
+// u = 0.5 looks along -Z and grows towards +X. Directions are importance
+// sampled by a piecewise constant distribution over the pixels,
+// proportional to luminance times sin(theta): a marginal over rows and a
+// conditional over the pixels of each row.
+struct EnvironmentMap
+{
+	int32_t width;
+	int32_t height;
+	// Top row first.
+	std::vector<glm::vec3> radiance;
+	// height + 1 entries, 0 to 1.
+	std::vector<float> marginalCdf;
+	// width + 1 entries per row.
+	std::vector<float> conditionalCdfs;
+	// Pixel count over the sum of all weights, turns a weight into a density
+	// over the unit square.
+	float normalization;
+};
+
+struct EnvironmentSample
+{
+	glm::vec3 direction;
+	glm::vec3 radiance;
+	// Per solid angle, zero when the map has no light.
+	float pdf;
+};
+
+// Builds the sampling distribution, radiance is top row first.
+const EnvironmentMap MakeEnvironmentMap(int32_t width, int32_t height, std::vector<glm::vec3>&& radiance);
+// Radiance HDR or PFM files.
+const std::optional<EnvironmentMap> LoadEnvironmentMap(const std::filesystem::path& filePath);
+
+// The map with its distribution in one binary file, read back without
+// rebuilding anything as long as it was written with the same key.
+const bool WriteEnvironmentCache(const EnvironmentMap& environment, const CacheKey& key, const std::filesystem::path& filePath);
+const std::optional<EnvironmentMap> ReadEnvironmentCache(const std::filesystem::path& filePath, const CacheKey& key);
+
+const glm::vec3 EnvironmentRadiance(const EnvironmentMap& environment, glm::vec3 direction) noexcept;
+const EnvironmentSample SampleEnvironment(const EnvironmentMap& environment, glm::vec2 u) noexcept;
+const float EnvironmentPdf(const EnvironmentMap& environment, glm::vec3 direction) noexcept;
@@ -0,0 +1,35 @@
+#pragma once
+#include "Renderer.h"
+
+#include <gsl/span>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+// Eight bit RGBA, top row first.
+struct Rgba8Image
+{
+	int32_t width;
+	int32_t height;
+	std::vector<uint8_t> pixels;
+};
+
+// Portable float map (.pfm) files store the linear framebuffer bit-exact,
+// bottom row first, which matches the framebuffer layout.
+bool WritePfm(const std::filesystem::path& filePath, const Framebuffer& framebuffer);
+const std::optional<Framebuffer> ReadPfm(const std::filesystem::path& filePath);
+// Radiance RGBE (.hdr) files, flat or run length encoded, in the usual
+// -Y height +X width orientation. Rows are flipped to bottom first like PFM.
+const std::optional<Framebuffer> ReadHdr(const std::filesystem::path& filePath);
+
+// Root mean square error over all channels, with each channel clamped to
+// [0, 1] first so a few very bright pixels can't dominate the result.
+const float RootMeanSquareError(const Framebuffer& a, const Framebuffer& b) noexcept;
+
+// Decodes every non-interlaced PNG: grayscale, RGB and palette images with
+// or without alpha, at every bit depth the format allows for them. Sixteen
+// bit samples keep their high byte. Returns nullopt for files it can't read.
+const std::optional<Rgba8Image> DecodePng(gsl::span<const uint8_t> bytes);
+const std::optional<Rgba8Image> ReadPng(const std::filesystem::path& filePath);
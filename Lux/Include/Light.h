@@ -1,9 +1,36 @@
 #pragma once
 
 #include <glm/vec3.hpp>
+#include <gsl/span>
+
+#include <cstdint>
+#include <vector>
 
 struct PointLight
 {
 	glm::vec3 position;
 	glm::vec3 color;
-};
\ No newline at end of file
+};
+
+// A triangle of an object with an emissive material. The vertices are
+// read from the mesh when sampling, so lights follow their object.
+struct TriangleLight
+{
+	uint32_t objectIndex;
+	uint32_t triangleIndex;
+};
+
+// Walker's alias method as built by Vose: a discrete distribution sampled
+// in constant time with one uniform number.
+struct AliasTable
+{
+	// Chance to keep the slot instead of taking its alias.
+	std::vector<float> probabilities;
+	std::vector<uint32_t> aliases;
+	// Probability of each index, weights divided by their sum.
+	std::vector<float> pdfs;
+};
+
+// Empty when no weight is above zero.
+const AliasTable BuildAliasTable(gsl::span<const float> weights);
+const uint32_t SampleAliasTable(const AliasTable& table, float u) noexcept;
@@ -2,8 +2,88 @@
 
 #include <glm/vec3.hpp>
 
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct Texture;
+
+enum class AlphaMode : uint8_t
+{
+	Opaque,
+	Mask,
+	Blend
+};
+
+// A glTF metallic-roughness material as authored. Textures multiply their
+// factors. Scenes shade from the MaterialTable built from these.
 struct Material
 {
 	glm::vec3 albedoColor;
 	float metalicness;
+	float roughness{ 1.0f };
+	const Texture* baseColorTexture{ nullptr };
+	// Roughness in green, metalness in blue.
+	const Texture* metallicRoughnessTexture{ nullptr };
+	const Texture* normalTexture{ nullptr };
+	float normalScale{ 1.0f };
+	const Texture* occlusionTexture{ nullptr };
+	float occlusionStrength{ 1.0f };
+	const Texture* emissiveTexture{ nullptr };
+	glm::vec3 emissiveColor{ 0.0f };
+	float alpha{ 1.0f };
+	AlphaMode alphaMode{ AlphaMode::Opaque };
+	float alphaCutoff{ 0.5f };
+	bool doubleSided{ false };
 };
+
+using MaterialID = uint32_t;
+using TextureID = uint16_t;
+
+constexpr TextureID noTexture = std::numeric_limits<TextureID>::max();
+
+constexpr uint32_t materialEmissive = 1u << 0;
+constexpr uint32_t materialAlphaTested = 1u << 1;
+constexpr uint32_t materialDoubleSided = 1u << 2;
+
+// What shading reads for every hit, two materials per cache line.
+struct MaterialShading
+{
+	glm::vec3 baseColor;
+	float metalness;
+	float roughness;
+	uint32_t flags;
+	TextureID baseColorTexture;
+	TextureID metallicRoughnessTexture;
+	TextureID normalTexture;
+	TextureID emissiveTexture;
+};
+
+static_assert(sizeof(MaterialShading) == 32, "MaterialShading should pack two to a cache line");
+
+// Read only by the features flags or a texture enable.
+struct MaterialExtras
+{
+	glm::vec3 emissiveColor;
+	float normalScale;
+	float occlusionStrength;
+	float alpha;
+	float alphaCutoff;
+	TextureID occlusionTexture;
+	AlphaMode alphaMode;
+};
+
+// Contiguous materials of a scene. A MaterialID indexes shading, extras
+// and sources, a TextureID indexes textures.
+struct MaterialTable
+{
+	std::vector<MaterialShading> shading;
+	std::vector<MaterialExtras> extras;
+	// Material each entry was built from, so each is added once.
+	std::vector<const Material*> sources;
+	std::vector<const Texture*> textures;
+};
+
+// Adds material and its textures unless they are in the table already.
+// Textures past the 16 bit range are left out.
+const MaterialID AddMaterial(MaterialTable& table, const Material& material);
@@ -1,12 +1,84 @@
 #pragma once
+#include "Bvh.h"
+#include "WideBvh.h"
+
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 #include <gsl/span>
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+// Three corners per triangle. Vertex attributes are stored per corner like
+// posistions, each one is either empty or complete, and either in full
+// precision or packed by QuantizeAttributes.
 struct Mesh
 {
 	std::vector<glm::vec3> posistions;
 	std::vector<glm::vec3> normals;
-};
\ No newline at end of file
+	// Tangent in xyz, sign of the bitangent in w.
+	std::vector<glm::vec4> tangents;
+	std::vector<glm::vec2> texcoords;
+	// Octahedral 2x16 bit normals and tangents, the lowest bit of a tangent
+	// holds the bitangent sign. Zero vectors stay zero. Texcoords are two half
+	// floats.
+	std::vector<uint32_t> packedNormals;
+	std::vector<uint32_t> packedTangents;
+	std::vector<uint32_t> packedTexcoords;
+	Bvh bvh;
+	// Collapsed from bvh, used for tracing.
+	WideBvh wideBvh;
+	// Of the last BuildMeshBvh, RefitMeshBvh rebuilds with them. The thread
+	// pool is not kept.
+	BvhBuildSettings bvhSettings;
+};
+
+// Builds the triangle hierarchy and its wide collapse, call again after
+// changing posistions.
+void BuildMeshBvh(Mesh& mesh, const BvhBuildSettings& settings = {}, WideBvhLayout layout = WideBvhLayout::DepthFirst);
+// Stores the triangles in the order the leaves reference them, so a leaf
+// reads consecutive memory. This renumbers the triangles. Meshes from
+// spatial builds, whose leaves share triangles, are left as they are.
+void ReorderTriangles(Mesh& mesh);
+// Cheaper alternative for deforming meshes whose triangles stay the same:
+// refits the hierarchy to the new posistions and only rebuilds it, with the
+// settings it was built with, once refitting degraded its SAH cost past
+// bvhRebuildThreshold. Spatial split trees are refit as a whole, their
+// leaves then bound whole triangles instead of the clipped parts they were
+// split into. Returns true when it rebuilt.
+const bool RefitMeshBvh(Mesh& mesh);
+const Bounds ComputeBounds(const Mesh& mesh) noexcept;
+
+// Replaces the full precision attributes by their packed form, which takes
+// a third of the memory for normals and tangents and half for texcoords.
+void QuantizeAttributes(Mesh& mesh);
+
+// Attributes at barycentric (u, v) of a triangle, from whichever form the
+// mesh stores. Zero when the mesh has no such attribute. Normals and
+// tangents are not renormalized.
+const glm::vec3 InterpolateNormal(const Mesh& mesh, uint32_t triangleIndex, float u, float v) noexcept;
+const glm::vec4 InterpolateTangent(const Mesh& mesh, uint32_t triangleIndex, float u, float v) noexcept;
+const glm::vec2 InterpolateTexcoord(const Mesh& mesh, uint32_t triangleIndex, float u, float v) noexcept;
+
+struct MeshMemoryReport
+{
+	size_t triangleCount;
+	size_t binaryNodeCount;
+	size_t wideNodeCount;
+	size_t leafCount;
+	// Leaves holding 1, 2, ... 7 and 8 or more primitives.
+	std::array<size_t, 8> leafSizeHistogram;
+	// Wide nodes and primitive indices, the memory traversal touches.
+	size_t traversalBytes;
+	// Normals, tangents and texcoords in the form they are stored.
+	size_t attributeBytes;
+	// Everything the mesh owns, including the binary tree kept for refits.
+	size_t totalBytes;
+	float sahCost;
+};
+
+const MeshMemoryReport ReportMemory(const Mesh& mesh) noexcept;
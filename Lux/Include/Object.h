@@ -1,10 +1,42 @@
 #pragma once
 
-#include "Mesh.h"
-#include "Material.h"
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
 
+#include <cstdint>
+#include <limits>
+
+// Translation, rotation and scale, applied in reverse order. Interpolating
+// this form keeps rotations rigid, where blending matrices would shear.
+struct NodeTransform
+{
+	glm::vec3 translation{ 0.0f };
+	glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+	glm::vec3 scale{ 1.0f };
+};
+
+// World placement of an object when the shutter opens and closes. Rays
+// see it interpolated at their time, translation and scale linearly and
+// rotation by slerp.
+struct ObjectMotion
+{
+	NodeTransform start;
+	NodeTransform end;
+};
+
+constexpr uint32_t noMotion = std::numeric_limits<uint32_t>::max();
+
+// One placement of a mesh in the scene. Objects are stored contiguously in
+// Scene::objects, meshID indexes Scene::meshes and materialID the
+// Scene::materials table. Traversal only reads objectFromWorld, meshID and
+// motionID. Moving objects keep their placement at shutter open in the
+// matrices and index Scene::motions with motionID.
 struct Object
 {
-	const Mesh* geometry;
-	const Material* material;
-};
\ No newline at end of file
+	glm::mat4 worldFromObject;
+	glm::mat4 objectFromWorld;
+	uint32_t meshID;
+	uint32_t materialID;
+	uint32_t motionID{ noMotion };
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped timing zones exported as Chrome Trace Event JSON (loads in
+// chrome://tracing and Perfetto). Compiled out unless LUX_ENABLE_PROFILING
+// is set. Every thread records into its own ring buffer, so a zone costs two
+// clock reads and a store, and long runs keep only their most recent zones.
+#ifndef LUX_ENABLE_PROFILING
+#define LUX_ENABLE_PROFILING 0
+#endif
+
+struct ProfileEvent
+{
+	const char* name;
+	int64_t startMicroseconds;
+	int64_t durationMicroseconds;
+};
+
+// Zones kept per thread before the oldest ones are overwritten.
+constexpr size_t profileEventCapacity = size_t{ 1 } << 16;
+
+struct ThreadProfile
+{
+	uint32_t threadID;
+	std::string threadName;
+	// Allocated at profileEventCapacity when the thread registers, event i
+	// is stored at i % profileEventCapacity.
+	std::vector<ProfileEvent> events;
+	uint64_t eventCount{ 0 };
+};
+
+class Profiler
+{
+public:
+	static Profiler& Get() noexcept;
+
+	ThreadProfile& CurrentThread();
+	void SetThreadName(std::string name);
+	int64_t Now() const noexcept;
+
+	bool WriteChromeTrace(const std::filesystem::path& filePath);
+
+private:
+	Profiler();
+
+	std::chrono::steady_clock::time_point start;
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadProfile>> threads;
+};
+
+class ProfileZone
+{
+public:
+	// Registers the calling thread on its first zone, which allocates its
+	// buffer. Closing a zone never allocates.
+	explicit ProfileZone(const char* name);
+	~ProfileZone();
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	ThreadProfile& thread;
+	const char* name;
+	int64_t startMicroseconds;
+};
+
+#if LUX_ENABLE_PROFILING
+#define LUX_PROFILE_CONCATENATE_IMPL(a, b) a##b
+#define LUX_PROFILE_CONCATENATE(a, b) LUX_PROFILE_CONCATENATE_IMPL(a, b)
+#define LUX_PROFILE_ZONE(name) ProfileZone LUX_PROFILE_CONCATENATE(profileZone, __LINE__){ name }
+#define LUX_PROFILE_THREAD_NAME(name) Profiler::Get().SetThreadName(name)
+#else
+#define LUX_PROFILE_ZONE(name) ((void)0)
+#define LUX_PROFILE_THREAD_NAME(name) ((void)0)
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// PCG32 (O'Neill, "PCG: A Family of Simple Fast Space-Efficient
+// Statistically Good Algorithms for Random Number Generation"). Sixteen bytes
+// of state, so every pixel can own one.
+struct RandomGenerator
+{
+	uint64_t state;
+	uint64_t increment;
+};
+
+inline const uint32_t NextUint(RandomGenerator& random) noexcept
+{
+	const uint64_t state = random.state;
+	random.state = state * 6364136223846793005ull + random.increment;
+	const uint32_t xorShifted = static_cast<uint32_t>(((state >> 18) ^ state) >> 27);
+	const uint32_t rotation = static_cast<uint32_t>(state >> 59);
+	return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+}
+
+// Different sequences give independent streams from the same seed.
+inline const RandomGenerator SeedRandom(uint64_t seed, uint64_t sequence = 0) noexcept
+{
+	RandomGenerator random{ 0, sequence << 1 | 1 };
+	NextUint(random);
+	random.state += seed;
+	NextUint(random);
+	return random;
+}
+
+// Uniform in [0, 1).
+inline const float NextFloat(RandomGenerator& random) noexcept
+{
+	return static_cast<float>(NextUint(random) >> 8) * 0x1.0p-24f;
+}
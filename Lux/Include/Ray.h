@@ -1,17 +1,49 @@
 #pragma once
 #include "Scene.h"
 #include "Light.h"
+#include "Sampler.h"
 
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 #include <gsl/span>
 
+#include <cstdint>
 #include <optional>
 
+// All traversal keeps of the closest hit. The attributes needed for shading
+// are evaluated afterwards by ComputeHitAttributes, only for the hits that
+// are shaded.
+struct Hit
+{
+	float distance;
+	// Index into Scene::primitives, or planeInstance for planes.
+	uint32_t instanceID;
+	// Triangle of the mesh, plane index for planes, 0 for other shapes.
+	uint32_t primitiveID;
+	// Barycentric weights of the second and third triangle vertex.
+	float u;
+	float v;
+};
+
+constexpr uint32_t planeInstance = invalidPrimitive - 1;
+
 struct HitRecord
 {
 	float hitDistance;
+	glm::vec3 point;
+	// Interpolated from the vertex normals where the mesh has them, both
+	// normals face the ray.
 	glm::vec3 normal;
-	const Material* material;
+	glm::vec3 geometricNormal;
+	// Zero where the mesh has none, w is the sign of the bitangent.
+	glm::vec4 tangent;
+	glm::vec2 texcoord;
+	// See ConeLevelOfDetail, only meaningful where the mesh has texcoords.
+	float textureLevelOfDetail;
+	MaterialID material;
+	// Of the ray that hit, rays leaving the hit are sent at the same time.
+	float time;
 };
 
 
@@ -19,11 +51,22 @@ struct Ray
 {
 	glm::vec3 origin;
 	glm::vec3 direction;
+	// Ray cone for texture filtering, its width at the origin and how fast
+	// it grows per unit of distance.
+	float coneWidth{ 0.0f };
+	float coneSpreadAngle{ 0.0f };
+	// When during the shutter the ray is sent, from 0 at open to 1 at close.
+	float time{ 0.0f };
 };
 
-const glm::vec3 Trace(const Scene& scene, const Ray& ray) noexcept;
+const glm::vec3 Trace(const Scene& scene, const Ray& ray, Sampler& sampler) noexcept;
 const glm::vec3 PointAlongRay(const Ray& ray, float distance) noexcept;
-const std::optional<HitRecord> ClosestIntersection(const Scene& scene, const Ray& ray) noexcept;
-const glm::vec3 DirectIllumination(const Scene& scene, glm::vec3 hitPoint, glm::vec3 normal) noexcept;
-const bool IsOccluded(const Scene& scene, glm::vec3 hitPoint, glm::vec3 lightDirection, float distance) noexcept;
+const std::optional<Hit> ClosestIntersection(const Scene& scene, const Ray& ray) noexcept;
+const HitRecord ComputeHitAttributes(const Scene& scene, const Ray& ray, const Hit& hit) noexcept;
+const glm::vec3 DirectIllumination(const Scene& scene, glm::vec3 hitPoint, glm::vec3 normal, float time) noexcept;
+// Light from emissive triangles and the environment reaching a diffuse
+// surface, one sample of each light and one BSDF sample combined with the
+// power heuristic. Multiply by albedo.
+const glm::vec3 EmissiveIllumination(const Scene& scene, const HitRecord& hit, glm::vec3 normal, Sampler& sampler) noexcept;
+const bool IsOccluded(const Scene& scene, glm::vec3 hitPoint, glm::vec3 lightDirection, float distance, float time) noexcept;
 const glm::vec3 Reflect(glm::vec3 incoming, glm::vec3 normal);
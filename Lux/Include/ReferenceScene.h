@@ -0,0 +1,33 @@
+#pragma once
+#include "Scene.h"
+#include "ResourceManager.h"
+#include "SceneGraph.h"
+
+#include <glm/vec3.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+enum class ReferenceSceneID
+{
+	GroundAndQuad,
+	Lantern,
+	Spheres
+};
+
+struct ReferenceScene
+{
+	Scene scene;
+	glm::vec3 cameraPosition;
+	glm::vec3 cameraDirection;
+	float verticalFov;
+	SceneGraph sceneGraph{};
+};
+
+const std::optional<ReferenceSceneID> ParseReferenceSceneID(std::string_view name) noexcept;
+// Meshes and materials used by the scene are owned by resourceManager.
+const ReferenceScene LoadReferenceScene(ReferenceSceneID id, ResourceManager& resourceManager);
+// The default scene of a glTF file on a ground plane, lit from above and
+// framed by the camera from the front.
+const ReferenceScene LoadGltfScene(const std::filesystem::path& filePath, ResourceManager& resourceManager);
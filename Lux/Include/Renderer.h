@@ -0,0 +1,61 @@
+#pragma once
+#include "Scene.h"
+#include "Camera.h"
+#include "Sampler.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct Framebuffer
+{
+	Framebuffer(int32_t width, int32_t height);
+
+	int32_t width;
+	int32_t height;
+	std::vector<glm::vec3> pixels;
+#if LUX_ENABLE_STATISTICS
+	std::vector<PixelStatistics> statistics;
+#endif
+};
+
+constexpr int32_t tileSize = 32;
+
+const std::vector<Tile> MakeTiles(int32_t width, int32_t height, int32_t size = tileSize);
+
+// Per pixel buffers of RenderTile. Kept by the caller, one per worker of a
+// ParallelFor, so they are only allocated for the first tile of each.
+struct TileScratch
+{
+	std::vector<Sampler> samplers;
+	std::vector<glm::vec2> jitter;
+	std::vector<glm::vec2> lensSamples;
+	std::vector<float> times;
+	std::vector<glm::vec3> colors;
+	CameraRays rays;
+};
+
+// Averages sampling.samplesPerPixel samples spread over the area of each
+// pixel, a box filter.
+void RenderTile(const Scene& scene, const Camera& camera, const Tile& tile, Framebuffer& framebuffer, TileScratch& scratch, const SamplerSettings& sampling = {}) noexcept;
+
+// One image of a batch rendered by RenderViews.
+struct View
+{
+	Camera camera;
+	Framebuffer framebuffer;
+};
+
+// Renders all views in a single ParallelFor over the tiles of every view, so
+// they share the scene and its acceleration structures and workers move on
+// to the next view without waiting for the last tiles of the previous one.
+// Views may differ in size and camera model.
+void RenderViews(const Scene& scene, std::vector<View>& views, ThreadPool& threadPool, const SamplerSettings& sampling = {});
+
+#if LUX_ENABLE_STATISTICS
+void AccumulateStatistics(const Framebuffer& framebuffer, RayStatistics& totals, PixelStatistics& maximum) noexcept;
+void RenderDebugView(DebugView view, const PixelStatistics& maximum, const Tile& tile, Framebuffer& framebuffer) noexcept;
+#endif
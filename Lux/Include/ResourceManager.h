@@ -1,12 +1,19 @@
 #pragma once
+#include "Environment.h"
 #include "Mesh.h"
+#include "Material.h"
+#include "SceneGraph.h"
+#include "Texture.h"
+#include "TextureCache.h"
 
 #include <fx/gltf.h>
+#include <gsl/span>
 
 #include <cstdint>
 #include <string>
 #include <string_view>
 #include <memory>
+#include <optional>
 #include <filesystem>
 #include <vector>
 
@@ -20,17 +27,63 @@ struct Resource
 	std::string name;
 };
 
+struct MeshImportSettings
+{
+	// Stores imported normals, tangents and texcoords packed, see
+	// QuantizeAttributes.
+	bool quantizeAttributes{ false };
+	// Above zero, textures are paged through a TextureCache of this budget
+	// from pre-tiled copies in cacheDirectory.
+	size_t textureCacheBytes{ 0 };
+	// Holds pre-tiled textures and environment maps with their sampling
+	// tables. Files are written on first import and reused while newer than
+	// their source, an empty path caches nothing.
+	std::filesystem::path cacheDirectory;
+};
+
 class ResourceManager
 {
 public:
-	void ImportFromGltf(std::filesystem::path&& filePath);
+	ResourceManager(const MeshImportSettings& importSettings = {});
+
+	// Converts every mesh and material of the file once and returns the node
+	// hierarchy of its default scene with its node animations, referring to
+	// the converted meshes by index. Meshes whose primitives use several
+	// materials are split into one mesh per material, placed by extra child
+	// nodes. Textures that fail to load are left out of their material.
+	const SceneGraph ImportFromGltf(std::filesystem::path&& filePath);
+
+	const Mesh& AddMesh(Mesh&& mesh, std::string name);
+	const Material& AddMaterial(Material&& material, std::string name);
+	// Radiance HDR or PFM file, nullptr when it can't be read.
+	const EnvironmentMap* LoadEnvironment(const std::filesystem::path& filePath);
 
 	const Mesh& GetMeshByIndex(size_t index);
+	const size_t GetMeshCount() const noexcept;
 	const Mesh& GetMeshByResourceID(uint32_t id);
 	const Mesh& GetMeshByName(std::string_view name);
+	// Material imported with the mesh, nullptr for meshes without one.
+	const Material* GetMeshMaterial(size_t index) const noexcept;
+	const std::optional<TextureCacheReport> GetTextureCacheReport() const noexcept;
 
 private:
-	void ParseNode(const fx::gltf::Document& gltf, const fx::gltf::Node& node);
-	void ConvertMesh(const fx::gltf::Document& gltf, const fx::gltf::Mesh gltfMesh);
+	// Resource meshes [first, end) converted from one glTF mesh.
+	struct MeshRange
+	{
+		int32_t first;
+		int32_t end;
+	};
+
+	void ParseNode(const fx::gltf::Document& gltf, uint32_t nodeIndex, uint32_t parent, gsl::span<const MeshRange> meshRanges, gsl::span<uint32_t> graphNodes, SceneGraph& graph);
+	// Adds one mesh per material its triangle primitives use.
+	void ConvertMesh(const fx::gltf::Document& gltf, const fx::gltf::Mesh gltfMesh, gsl::span<const Material* const> gltfMaterials);
+	const Texture* ConvertTexture(const fx::gltf::Document& gltf, const std::filesystem::path& gltfPath, uint32_t textureIndex, bool srgb);
+	MeshImportSettings importSettings;
+	std::unique_ptr<TextureCache> textureCache;
 	std::vector<Resource<Mesh>> meshes;
+	// Parallel to meshes.
+	std::vector<const Material*> meshMaterials;
+	std::vector<Resource<Material>> materials;
+	std::vector<Resource<Texture>> textures;
+	std::vector<Resource<EnvironmentMap>> environments;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "Random.h"
+
+#include <glm/vec2.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+enum class SamplerType
+{
+	// PCG32 per sample.
+	Independent,
+	// Jittered strata, shuffled per dimension so dimensions don't correlate.
+	Stratified,
+	// Owen-scrambled Sobol (Burley, "Practical Hash-based Owen Scrambling"),
+	// padded from two dimensions by shuffling the sample index per pair.
+	Sobol,
+	// The same Sobol points in every pixel, rotated by a blue noise mask so
+	// the error of neighbouring pixels doesn't correlate (Heitz and Belcour,
+	// "Distributing Monte Carlo Errors as a Blue Noise in Screen Space").
+	BlueNoise
+};
+
+struct SamplerSettings
+{
+	SamplerType type{ SamplerType::Independent };
+	uint32_t samplesPerPixel{ 1 };
+	// Mixed into every pixel seed, a new one gives a new image of the same
+	// scene.
+	uint32_t seed{ 0 };
+};
+
+// One sample of one pixel, handing out its dimensions in order. Consumers
+// must draw the same dimensions in the same order for every sample of a
+// pixel, the low discrepancy sequences are only well distributed per
+// dimension.
+struct Sampler
+{
+	SamplerType type;
+	uint32_t sampleIndex;
+	uint32_t sampleCount;
+	uint32_t seed;
+	uint32_t dimension;
+	int32_t x;
+	int32_t y;
+	RandomGenerator random;
+};
+
+// Samples of a pixel are deterministic for a given seed, so the same
+// settings render the same image on any number of threads.
+const Sampler StartPixelSample(const SamplerSettings& settings, int32_t x, int32_t y, uint32_t sampleIndex) noexcept;
+// Uniform in [0, 1).
+const float NextSample1D(Sampler& sampler) noexcept;
+const glm::vec2 NextSample2D(Sampler& sampler) noexcept;
+
+const std::optional<SamplerType> ParseSamplerType(std::string_view name) noexcept;
+const char* SamplerTypeName(SamplerType type) noexcept;
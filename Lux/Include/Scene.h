@@ -1,12 +1,95 @@
 #pragma once
+#include "Environment.h"
 #include "Light.h"
 #include "Object.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Shape.h"
+#include "Bvh.h"
 #include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
 
+#include <gsl/span>
+
+#include <cstdint>
+#include <limits>
 #include <vector>
 
+enum class PrimitiveType : uint32_t
+{
+	Object,
+	Sphere,
+	Disc,
+	Box
+};
+
+// Leaf entry of the scene hierarchy, index points into the matching vector of the scene.
+struct PrimitiveReference
+{
+	PrimitiveType type;
+	uint32_t index;
+};
+
 struct Scene
 {
 	std::vector<PointLight> lights;
+	// Every triangle of objects with an emissive material, sampled in
+	// proportion to power times area through triangleLightTable.
+	std::vector<TriangleLight> triangleLights;
+	AliasTable triangleLightTable;
+	// First triangle light of every object, invalidLight for objects that
+	// do not emit. Light index is that plus the triangle index.
+	std::vector<uint32_t> objectLights;
+	// Lights rays that leave the scene, a flat sky without one. Owned by the
+	// ResourceManager.
+	const EnvironmentMap* environment{ nullptr };
+	std::vector<const Mesh*> meshes;
+	MaterialTable materials;
 	std::vector<Object> objects;
-};
\ No newline at end of file
+	// Indexed by Object::motionID.
+	std::vector<ObjectMotion> motions;
+	std::vector<Sphere> spheres;
+	std::vector<Plane> planes;
+	std::vector<Disc> discs;
+	std::vector<Box> boxes;
+
+	std::vector<PrimitiveReference> primitives;
+	std::vector<Bounds> primitiveBounds;
+	// Primitive index of every object, or invalidPrimitive for empty meshes.
+	std::vector<uint32_t> objectPrimitives;
+	Bvh bvh;
+	BvhTopology bvhTopology;
+	uint32_t refitPrimitivesSinceCheck{ 0 };
+};
+
+constexpr uint32_t invalidPrimitive = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t invalidLight = std::numeric_limits<uint32_t>::max();
+
+// Places mesh in the scene, adding mesh and material to the scene tables
+// when they are not referenced yet. Returns the object index.
+const uint32_t AddObject(Scene& scene, const Mesh& mesh, const Material& material, const glm::mat4& worldFromObject = glm::mat4{ 1.0f });
+// Also stops the object if it was moving.
+void SetObjectTransform(Scene& scene, uint32_t objectIndex, const glm::mat4& worldFromObject) noexcept;
+// Moves the object from the world placement start when the shutter opens to
+// end when it closes. Rays pick a time in between, which blurs it.
+void SetObjectMotion(Scene& scene, uint32_t objectIndex, const NodeTransform& start, const NodeTransform& end);
+// The object as placed at time, from 0 at shutter open to 1 at shutter close.
+const Object ObjectAtTime(const Scene& scene, uint32_t objectIndex, float time) noexcept;
+
+const glm::mat4 ToMatrix(const NodeTransform& transform) noexcept;
+const NodeTransform InterpolateTransform(const NodeTransform& start, const NodeTransform& end, float time) noexcept;
+
+// Rebuilds the hierarchy over objects and bounded shapes, and the triangle
+// lights. Must be called after adding or moving anything other than point
+// lights and planes. With moving objects the hierarchy is split by where
+// everything is halfway through the shutter and its nodes move along.
+void BuildAccelerationStructure(Scene& scene);
+// Collects the triangles of emissive objects and weighs each by its area
+// and average emission.
+void BuildTriangleLights(Scene& scene);
+// Refits the scene hierarchy above the objects that moved or whose mesh was
+// refit, so the cost scales with the number of changes. Falls back to a full
+// rebuild when objects were added or refitting degraded the tree too far,
+// and always when anything moves during the shutter. Returns true when it
+// rebuilt.
+const bool UpdateAccelerationStructure(Scene& scene, gsl::span<const uint32_t> changedObjects);
@@ -0,0 +1,60 @@
+#pragma once
+#include "Scene.h"
+#include "Animation.h"
+
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+class ResourceManager;
+
+constexpr uint32_t invalidNode = std::numeric_limits<uint32_t>::max();
+constexpr uint32_t invalidObject = std::numeric_limits<uint32_t>::max();
+
+// Node hierarchy flattened in depth first order: a parent always comes
+// before its children and the subtree of node i is the contiguous range
+// [i, subtreeEnds[i]). World transforms are resolved with one forward pass
+// over the dirty ranges only.
+struct SceneGraph
+{
+	std::vector<uint32_t> parents;
+	std::vector<uint32_t> subtreeEnds;
+	std::vector<NodeTransform> localTransforms;
+	std::vector<glm::mat4> worldMatrices;
+	std::vector<uint8_t> dirtyFlags;
+	// Resource mesh index placed by the node, -1 for none.
+	std::vector<int32_t> meshes;
+	// Scene object created for the node by InstantiateSceneGraph.
+	std::vector<uint32_t> objects;
+	std::vector<std::string> names;
+	// Animations targeting nodes of this graph, see AnimateSceneGraph.
+	std::vector<Animation> animations;
+};
+
+// Children have to be added after their parent and before any node outside
+// the parent's subtree, then CloseNode(parent) ends the subtree.
+const uint32_t AddNode(SceneGraph& graph, uint32_t parent, const NodeTransform& transform, int32_t mesh, std::string name);
+void CloseNode(SceneGraph& graph, uint32_t node) noexcept;
+
+const NodeTransform Decompose(const glm::mat4& matrix) noexcept;
+
+void SetLocalTransform(SceneGraph& graph, uint32_t node, const NodeTransform& transform) noexcept;
+// Poses the animated nodes as they are time seconds into all animations of
+// the graph, played together. Only nodes whose transform changed are marked
+// dirty, so UpdateWorldTransforms moves only those.
+void AnimateSceneGraph(SceneGraph& graph, float time) noexcept;
+
+// Recomputes world matrices of dirty subtrees and copies them into the
+// scene objects of those nodes. Returns the objects that moved, ready to be
+// passed to UpdateAccelerationStructure.
+const std::vector<uint32_t> UpdateWorldTransforms(SceneGraph& graph, Scene& scene);
+
+// Creates a scene object for every node that places a mesh, using resource
+// mesh indices from resourceManager. material is used for meshes that were
+// imported without one.
+void InstantiateSceneGraph(SceneGraph& graph, Scene& scene, ResourceManager& resourceManager, const Material& material);
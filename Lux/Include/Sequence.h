@@ -0,0 +1,45 @@
+#pragma once
+#include "Renderer.h"
+#include "SceneGraph.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct SequenceSettings
+{
+	uint32_t frameCount{ 1 };
+	float framesPerSecond{ 24.0f };
+	// Animation time of the first frame in seconds.
+	float startTime{ 0.0f };
+	// Fraction of the frame interval the shutter stays open. Objects moving
+	// while it is open are blurred, 0 renders every frame as an instant.
+	float shutter{ 0.0f };
+	SamplerSettings sampling;
+};
+
+struct SequenceFrame
+{
+	uint32_t index;
+	float time;
+	// Objects the update to this frame moved, and whether the scene
+	// hierarchy had to be rebuilt instead of refit for them.
+	size_t movedObjects;
+	bool rebuilt;
+	double updateMilliseconds;
+	double renderMilliseconds;
+};
+
+using SequenceFrameCallback = std::function<void(const SequenceFrame& frame, const std::vector<View>& views)>;
+
+// Renders consecutive frames of the animations of graph into views, and
+// hands every finished frame to onFrame before the next one starts. scene
+// has to be instantiated from graph. Frames only update the nodes that
+// moved and refit the hierarchy above their objects, unless the shutter is
+// open long enough for something to move.
+//
+// The update of a frame runs while the one before is traced, on one thread
+// kept for the whole sequence. Two copies of graph and scene take turns for
+// that, the meshes they point at are shared.
+void RenderSequence(const SceneGraph& graph, const Scene& scene, std::vector<View>& views, ThreadPool& threadPool, const SequenceSettings& settings, const SequenceFrameCallback& onFrame);
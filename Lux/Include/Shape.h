@@ -0,0 +1,55 @@
+#pragma once
+#include "Bounds.h"
+#include "Material.h"
+
+#include <glm/vec3.hpp>
+
+// Analytic primitives intersected in closed form. The intersection functions
+// return the hit distance along the ray, or infinity when there is no hit in
+// (minDistance, maxDistance).
+
+struct Sphere
+{
+	glm::vec3 center;
+	float radius;
+	MaterialID material;
+};
+
+// All points p with dot(normal, p) == distance. Planes are unbounded, so
+// they live next to the acceleration structure instead of inside it.
+struct Plane
+{
+	glm::vec3 normal;
+	float distance;
+	MaterialID material;
+};
+
+struct Disc
+{
+	glm::vec3 center;
+	glm::vec3 normal;
+	float radius;
+	MaterialID material;
+};
+
+// Axis aligned.
+struct Box
+{
+	glm::vec3 minimum;
+	glm::vec3 maximum;
+	MaterialID material;
+};
+
+const Bounds ComputeBounds(const Sphere& sphere) noexcept;
+const Bounds ComputeBounds(const Disc& disc) noexcept;
+const Bounds ComputeBounds(const Box& box) noexcept;
+
+const float Intersect(const Sphere& sphere, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept;
+const float Intersect(const Plane& plane, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept;
+const float Intersect(const Disc& disc, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept;
+const float Intersect(const Box& box, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept;
+
+const glm::vec3 NormalAt(const Sphere& sphere, glm::vec3 point) noexcept;
+const glm::vec3 NormalAt(const Plane& plane, glm::vec3 point) noexcept;
+const glm::vec3 NormalAt(const Disc& disc, glm::vec3 point) noexcept;
+const glm::vec3 NormalAt(const Box& box, glm::vec3 point) noexcept;
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+
+// Ray tracing counters. Only compiled in when LUX_ENABLE_STATISTICS is set,
+// otherwise the increment macro expands to nothing and the traversal code
+// is identical to an uninstrumented build.
+#ifndef LUX_ENABLE_STATISTICS
+#define LUX_ENABLE_STATISTICS 0
+#endif
+
+enum class StatisticCounter : uint32_t
+{
+	PrimaryRays,
+	ShadowRays,
+	BounceRays,
+	TriangleTests,
+	NodeVisits,
+	Count
+};
+
+constexpr size_t statisticCounterCount = static_cast<size_t>(StatisticCounter::Count);
+
+struct RayStatistics
+{
+	std::array<uint64_t, statisticCounterCount> counters{};
+};
+
+struct PixelStatistics
+{
+	std::array<uint32_t, statisticCounterCount> counters{};
+};
+
+enum class DebugView : uint32_t
+{
+	Shaded,
+	PrimaryRays,
+	ShadowRays,
+	BounceRays,
+	TriangleTests,
+	NodeVisits
+};
+
+RayStatistics& ThreadStatistics() noexcept;
+const PixelStatistics Difference(const RayStatistics& after, const RayStatistics& before) noexcept;
+const glm::vec3 Heatmap(uint32_t value, uint32_t maximum) noexcept;
+void PrintStatistics(const RayStatistics& totals, double renderSeconds, uint64_t frameCount) noexcept;
+
+#if LUX_ENABLE_STATISTICS
+#define LUX_STATISTIC_INCREMENT(counter) (++ThreadStatistics().counters[static_cast<size_t>(StatisticCounter::counter)])
+#else
+#define LUX_STATISTIC_INCREMENT(counter) ((void)0)
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+struct Rgba8Image;
+class TextureCache;
+
+enum class TextureWrap
+{
+	Repeat,
+	ClampToEdge,
+	MirroredRepeat
+};
+
+// Texels are stored in 8x8 tiles of 256 bytes, four cache lines, with the
+// tiles in row order and the texels of a tile in Morton order. A bilinear
+// footprint then mostly stays within one tile whichever way the rays run,
+// where neighbouring rows of a plain image are a whole row apart.
+constexpr uint32_t textureTileSize = 8;
+
+struct TextureLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t tileCountX;
+	// RGBA8, padded to whole tiles.
+	std::vector<uint32_t> texels;
+};
+
+struct Texture
+{
+	// Full resolution first, each level half the size of the previous one
+	// down to 1x1.
+	std::vector<TextureLevel> levels;
+	// Color textures are sRGB encoded and decoded before filtering.
+	bool srgb;
+	TextureWrap wrapS;
+	TextureWrap wrapT;
+	// Set for textures paged in by a TextureCache, their levels have sizes
+	// but no texels.
+	TextureCache* cache{ nullptr };
+	uint32_t cacheID{ 0 };
+};
+
+// Interleaves the bits of a coordinate below 2^16 with zeros, x | y << 1 of
+// two spread coordinates is their Morton code.
+constexpr uint32_t SpreadBits(uint32_t value) noexcept
+{
+	value = (value | value << 8) & 0x00ff00ff;
+	value = (value | value << 4) & 0x0f0f0f0f;
+	value = (value | value << 2) & 0x33333333;
+	return (value | value << 1) & 0x55555555;
+}
+
+inline const size_t TexelIndex(const TextureLevel& level, uint32_t x, uint32_t y) noexcept
+{
+	const size_t tile = static_cast<size_t>(y / textureTileSize) * level.tileCountX + x / textureTileSize;
+	return tile * textureTileSize * textureTileSize + (SpreadBits(x % textureTileSize) | SpreadBits(y % textureTileSize) << 1);
+}
+
+// Builds the mip chain with a box filter, in linear space for sRGB textures.
+const Texture MakeTexture(const Rgba8Image& image, bool srgb, TextureWrap wrapS = TextureWrap::Repeat, TextureWrap wrapT = TextureWrap::Repeat);
+const std::optional<Texture> LoadTexture(const std::filesystem::path& filePath, bool srgb, TextureWrap wrapS = TextureWrap::Repeat, TextureWrap wrapT = TextureWrap::Repeat);
+
+// Ray cone level of detail (Akenine-Moller et al., "Texture Level of Detail
+// Strategies for Real-Time Ray Tracing") without the texture resolution
+// term, so one value serves every texture of a hit. coneWidth is the width
+// of the ray cone at the hit, cosine the cosine between ray and surface,
+// the areas are those of the hit triangle in texcoord and world space.
+const float ConeLevelOfDetail(float coneWidth, float cosine, float texcoordArea, float worldArea) noexcept;
+
+// Trilinear sample in linear RGBA, at the mip level ConeLevelOfDetail picks
+// for this texture.
+const glm::vec4 SampleTexture(const Texture& texture, glm::vec2 texcoord, float levelOfDetail) noexcept;
@@ -0,0 +1,130 @@
+#pragma once
+#include "CacheKey.h"
+#include "Texture.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Cached textures are paged in squares of 32x32 texels, 4 KiB, in Morton
+// order. Aligned 8x8 blocks of a Morton square are contiguous, so a page
+// holds 16 tiles laid out like those of an in-memory level.
+constexpr uint32_t texturePageSize = 32;
+constexpr uint32_t texturePageTexels = texturePageSize * texturePageSize;
+
+// Writes the pre-tiled file TextureCache reads: a 4 KiB header with the
+// level sizes and the key of the source, then the pages of every level, full
+// resolution first and each level in row order. Pages past the edge of a
+// level are padded with zero texels. Fails for keys too long for the header.
+const bool WriteTiledTexture(const Texture& texture, const CacheKey& key, const std::filesystem::path& filePath);
+
+struct TextureCacheReport
+{
+	uint64_t lookups;
+	uint64_t misses;
+	uint64_t bytesLoaded;
+	uint64_t evictions;
+	// Misses served from a scratch page because every slot was pinned.
+	uint64_t uncachedLoads;
+	uint64_t readErrors;
+	size_t residentPages;
+	size_t capacityPages;
+};
+
+// Keeps the pages of pre-tiled texture files within a fixed memory budget.
+// Pages are loaded from disk the first time a sample touches them and
+// evicted with the CLOCK algorithm. Hits only use atomics, a miss picks a
+// slot under a lock shared by all misses and reads its page after releasing
+// it, readers of a page that is still loading wait for it.
+class TextureCache
+{
+public:
+	explicit TextureCache(size_t budgetBytes);
+
+	// Reads the header of a file written by WriteTiledTexture, the returned
+	// texture fetches its texels through this cache. Fails for files written
+	// with another key and for files shorter than their header says. Not safe
+	// while other threads sample.
+	const std::optional<Texture> Open(const std::filesystem::path& filePath, const CacheKey& key);
+
+	// Texels at (xs[0], ys[0]), (xs[1], ys[0]), (xs[0], ys[1]), (xs[1], ys[1])
+	// of a level, the four corners of a bilinear sample.
+	const std::array<uint32_t, 4> FetchQuad(uint32_t textureID, uint32_t level, std::array<uint32_t, 2> xs, std::array<uint32_t, 2> ys);
+
+	const TextureCacheReport Report() const noexcept;
+
+private:
+	static constexpr uint32_t noSlot = ~0u;
+	static constexpr uint64_t noPage = ~0ull;
+	static constexpr size_t lookupCounterCount = 16;
+
+	struct CachedTexture
+	{
+		std::ifstream file;
+		// Misses of different pages read the file at the same time.
+		std::unique_ptr<std::mutex> fileMutex;
+		// First page and pages per row of each level.
+		std::vector<uint32_t> levelPageOffsets;
+		std::vector<uint32_t> levelPageCountsX;
+		std::unique_ptr<std::atomic<uint32_t>[]> pageSlots;
+	};
+
+	// A slot holds one page. Readers pin it while they read its texels and
+	// eviction skips pinned slots. Padded so pins of different slots do not
+	// share a cache line.
+	struct alignas(64) Slot
+	{
+		std::atomic<uint64_t> page{ noPage };
+		std::atomic<uint32_t> pins{ 0 };
+		std::atomic<uint8_t> referenced{ 0 };
+		// Cleared while the page is read from disk.
+		std::atomic<uint8_t> loaded{ 0 };
+	};
+
+	// Texels of an acquired page, slot is noSlot for pages read into the
+	// scratch page of the thread, which need no unpinning.
+	struct PinnedPage
+	{
+		uint32_t slot;
+		const uint32_t* texels;
+	};
+
+	// Lookups are counted per thread group, one shared counter would make
+	// every hit write the same cache line.
+	struct alignas(64) LookupCounter
+	{
+		std::atomic<uint64_t> lookups{ 0 };
+	};
+
+	const PinnedPage AcquirePage(uint32_t textureID, uint32_t page);
+	const PinnedPage LoadPage(uint32_t textureID, uint32_t page);
+	void ReadPage(uint32_t textureID, uint32_t page, uint32_t* destination);
+	const bool TryPin(uint32_t slot, uint64_t page) noexcept;
+	void WaitUntilLoaded(uint32_t slot) noexcept;
+	void Unpin(uint32_t slot) noexcept;
+	const uint32_t EvictSlot();
+
+	size_t capacity;
+	std::unique_ptr<Slot[]> slots;
+	std::vector<uint32_t> texels;
+	std::vector<CachedTexture> textures;
+	std::array<LookupCounter, lookupCounterCount> lookupCounters;
+	std::atomic<uint64_t> readErrors{ 0 };
+
+	// Guards everything below and the assignment of pages to slots.
+	mutable std::mutex missMutex;
+	size_t clockHand{ 0 };
+	size_t residentPages{ 0 };
+	uint64_t misses{ 0 };
+	uint64_t bytesLoaded{ 0 };
+	uint64_t evictions{ 0 };
+	uint64_t uncachedLoads{ 0 };
+};
+
+void PrintTextureCacheReport(const TextureCacheReport& report) noexcept;
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split a batch of jobs between them.
+// Jobs are handed out through an atomic counter, so each call to
+// ParallelFor costs one wake-up per worker regardless of the job count.
+class ThreadPool
+{
+public:
+	using Job = std::function<void(uint32_t jobIndex, uint32_t workerIndex)>;
+
+	explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Runs job for every index in [0, jobCount) and blocks until all of them finished.
+	void ParallelFor(uint32_t jobCount, const Job& job);
+
+	uint32_t WorkerCount() const noexcept;
+
+private:
+	void WorkerLoop(uint32_t workerIndex);
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+
+	const Job* currentJob{ nullptr };
+	uint32_t currentJobCount{ 0 };
+	std::atomic<uint32_t> nextJobIndex{ 0 };
+	uint32_t activeWorkers{ 0 };
+	uint64_t generation{ 0 };
+	bool stopping{ false };
+};
@@ -0,0 +1,150 @@
+#pragma once
+#include "Statistics.h"
+
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+// Ray-triangle tests. The distance is infinity when there is no hit in
+// (minDistance, maxDistance) like for the analytic shapes, u and v are the
+// barycentric weights of the second and third vertex.
+struct TriangleHit
+{
+	float distance;
+	float u;
+	float v;
+};
+
+// The part of the watertight test that only depends on the ray. The axis the
+// ray travels along most becomes z, and the shear maps the ray onto the +z
+// axis through the origin, so each triangle is tested in 2D.
+struct TriangleRay
+{
+	glm::vec3 origin;
+	int kx;
+	int ky;
+	int kz;
+	glm::vec3 shear;
+};
+
+inline const TriangleRay PrepareTriangleRay(glm::vec3 origin, glm::vec3 direction) noexcept
+{
+	const glm::vec3 absoluteDirection = glm::abs(direction);
+	int kz = absoluteDirection.x > absoluteDirection.y ? (absoluteDirection.x > absoluteDirection.z ? 0 : 2) : (absoluteDirection.y > absoluteDirection.z ? 1 : 2);
+	int kx = (kz + 1) % 3;
+	int ky = (kx + 1) % 3;
+
+	// Keeps the winding, so the sign of the edge functions means the same
+	// for every ray.
+	if (direction[kz] < 0.0f)
+	{
+		std::swap(kx, ky);
+	}
+
+	return TriangleRay
+	{
+		origin,
+		kx,
+		ky,
+		kz,
+		glm::vec3{ direction[kx] / direction[kz], direction[ky] / direction[kz], 1.0f / direction[kz] }
+	};
+}
+
+// Woop, Benthin and Wald, "Watertight Ray/Triangle Intersection". Edges shared
+// by two triangles are evaluated with the same operations on the same
+// vertices, so a ray through an edge hits at least one of them and rays
+// never slip through a closed mesh. Hits from either side count.
+inline const TriangleHit IntersectTriangle(const TriangleRay& ray, glm::vec3 vertex0, glm::vec3 vertex1, glm::vec3 vertex2, float minDistance, float maxDistance) noexcept
+{
+	LUX_STATISTIC_INCREMENT(TriangleTests);
+
+	const glm::vec3 a = vertex0 - ray.origin;
+	const glm::vec3 b = vertex1 - ray.origin;
+	const glm::vec3 c = vertex2 - ray.origin;
+
+	const float ax = a[ray.kx] - ray.shear.x * a[ray.kz];
+	const float ay = a[ray.ky] - ray.shear.y * a[ray.kz];
+	const float bx = b[ray.kx] - ray.shear.x * b[ray.kz];
+	const float by = b[ray.ky] - ray.shear.y * b[ray.kz];
+	const float cx = c[ray.kx] - ray.shear.x * c[ray.kz];
+	const float cy = c[ray.ky] - ray.shear.y * c[ray.kz];
+
+	float u = cx * by - cy * bx;
+	float v = ax * cy - ay * cx;
+	float w = bx * ay - by * ax;
+
+	// A zero edge function may be rounding, recomputing it in double
+	// decides which side of the edge the ray really passes.
+	if (u == 0.0f || v == 0.0f || w == 0.0f)
+	{
+		u = static_cast<float>(static_cast<double>(cx) * static_cast<double>(by) - static_cast<double>(cy) * static_cast<double>(bx));
+		v = static_cast<float>(static_cast<double>(ax) * static_cast<double>(cy) - static_cast<double>(ay) * static_cast<double>(cx));
+		w = static_cast<float>(static_cast<double>(bx) * static_cast<double>(ay) - static_cast<double>(by) * static_cast<double>(ax));
+	}
+
+	if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+	{
+		return TriangleHit{ std::numeric_limits<float>::infinity() };
+	}
+
+	const float determinant = u + v + w;
+	if (determinant == 0.0f)
+	{
+		return TriangleHit{ std::numeric_limits<float>::infinity() };
+	}
+
+	// Compares before dividing, so only hits pay for the division.
+	const float scaledDistance = ray.shear.z * (u * a[ray.kz] + v * b[ray.kz] + w * c[ray.kz]);
+	const float sign = std::copysign(1.0f, determinant);
+	const float absoluteDeterminant = sign * determinant;
+	if (sign * scaledDistance <= minDistance * absoluteDeterminant || sign * scaledDistance >= maxDistance * absoluteDeterminant)
+	{
+		return TriangleHit{ std::numeric_limits<float>::infinity() };
+	}
+
+	const float inverseDeterminant = 1.0f / determinant;
+	return TriangleHit{ scaledDistance * inverseDeterminant, v * inverseDeterminant, w * inverseDeterminant };
+}
+
+// Moller-Trumbore. Cheaper to set up per ray but not watertight: the epsilon
+// and the rounding of u + v let rays through shared edges miss both
+// triangles. Kept to compare against.
+inline const TriangleHit IntersectTriangleMollerTrumbore(glm::vec3 origin, glm::vec3 direction, glm::vec3 vertex0, glm::vec3 vertex1, glm::vec3 vertex2, float minDistance, float maxDistance) noexcept
+{
+	constexpr float epsilon = 0.0000001f;
+	LUX_STATISTIC_INCREMENT(TriangleTests);
+
+	const glm::vec3 edge1 = vertex1 - vertex0;
+	const glm::vec3 edge2 = vertex2 - vertex0;
+	const glm::vec3 pvec = glm::cross(direction, edge2);
+	const float det = glm::dot(edge1, pvec);
+
+	if (det > -epsilon && det < epsilon)
+	{
+		return TriangleHit{ std::numeric_limits<float>::infinity() };
+	}
+
+	const float invDet = 1.0f / det;
+	const glm::vec3 tvec = origin - vertex0;
+	const float u = invDet * glm::dot(tvec, pvec);
+
+	if (u < 0.0f || u > 1.0f)
+	{
+		return TriangleHit{ std::numeric_limits<float>::infinity() };
+	}
+
+	const glm::vec3 qvec = glm::cross(tvec, edge1);
+	const float v = invDet * glm::dot(direction, qvec);
+
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return TriangleHit{ std::numeric_limits<float>::infinity() };
+	}
+
+	const float t = invDet * glm::dot(edge2, qvec);
+	return t > minDistance && t < maxDistance ? TriangleHit{ t, u, v } : TriangleHit{ std::numeric_limits<float>::infinity() };
+}
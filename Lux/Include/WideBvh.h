@@ -0,0 +1,193 @@
+#pragma once
+#include "Bvh.h"
+#include "Statistics.h"
+
+#include <glm/vec3.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+constexpr uint32_t wideBvhWidth = 8;
+// Nodes per treelet, one 4 KiB page. A single node already fills two cache
+// lines, so treelets are sized to pages instead.
+constexpr uint32_t wideBvhTreeletSize = 32;
+
+enum class WideBvhLayout
+{
+	// Preorder, the first interior child of a node directly follows it.
+	DepthFirst,
+	// Level by level, so the interior children of a node are adjacent.
+	BreadthFirst,
+	// Subtrees grown from their root by largest surface area, which is the
+	// most likely to be visited next, are stored together.
+	Treelets
+};
+
+// Eight children per node. Child bounds are quantized to 8 bits relative to
+// the node box, origin + q * 2^exponent, and stored SoA so all box tests
+// read the first cache line only. Children are packed at the front, a zero
+// primitive count marks an interior child whose index is in children.
+struct alignas(64) WideBvhNode
+{
+	glm::vec3 origin;
+	std::array<int8_t, 3> exponents;
+	uint8_t childCount;
+	std::array<std::array<uint8_t, wideBvhWidth>, 3> quantizedMinimum;
+	std::array<std::array<uint8_t, wideBvhWidth>, 3> quantizedMaximum;
+
+	std::array<uint32_t, wideBvhWidth> children;
+	std::array<uint32_t, wideBvhWidth> primitiveCounts;
+};
+
+static_assert(sizeof(WideBvhNode) == 128, "WideBvhNode should span two cache lines");
+
+struct WideBvh
+{
+	std::vector<WideBvhNode> nodes;
+	std::vector<uint32_t> primitiveIndices;
+	WideBvhLayout layout{ WideBvhLayout::DepthFirst };
+};
+
+// Pulls the largest grandchildren up into each node until it has eight
+// children, the binary hierarchy keeps its leaves. The root is always the
+// first node, layout orders the rest.
+const WideBvh CollapseBvh(const Bvh& bvh, WideBvhLayout layout = WideBvhLayout::DepthFirst);
+
+// Decoded child box, each corner rounded outwards when it was quantized.
+const Bounds ChildBounds(const WideBvhNode& node, uint32_t child) noexcept;
+
+inline const float ExponentScale(int8_t exponent) noexcept
+{
+	return std::bit_cast<float>(static_cast<uint32_t>(exponent + 127) << 23);
+}
+
+// Slab test against all children at once. Returns a bit per child that the
+// ray enters before maxDistance and writes its entry distance.
+inline const uint32_t IntersectChildren(const WideBvhNode& node, glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance, std::array<float, wideBvhWidth>& distances) noexcept
+{
+#if defined(__AVX2__)
+	__m256 entry = _mm256_setzero_ps();
+	__m256 exit = _mm256_set1_ps(maxDistance);
+	const __m256 exitScale = _mm256_set1_ps(slabExitScale);
+
+	for (int axis{ 0 }; axis < 3; ++axis)
+	{
+		const bool negative = inverseDirection[axis] < 0.0f;
+		const __m256 nodeOrigin = _mm256_set1_ps(node.origin[axis]);
+		const __m256 scale = _mm256_set1_ps(ExponentScale(node.exponents[axis]));
+		const __m256 rayOrigin = _mm256_set1_ps(origin[axis]);
+		const __m256 rayInverseDirection = _mm256_set1_ps(inverseDirection[axis]);
+
+		const auto decode = [&](const std::array<uint8_t, wideBvhWidth>& quantized)
+		{
+			const __m256 value = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(quantized.data()))));
+			return _mm256_add_ps(nodeOrigin, _mm256_mul_ps(value, scale));
+		};
+
+		const __m256 nearPlane = decode(negative ? node.quantizedMaximum[axis] : node.quantizedMinimum[axis]);
+		const __m256 farPlane = decode(negative ? node.quantizedMinimum[axis] : node.quantizedMaximum[axis]);
+		// Both return their second operand when one is NaN, which drops the
+		// 0 * infinity of a ray inside a face plane.
+		entry = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(nearPlane, rayOrigin), rayInverseDirection), entry);
+		exit = _mm256_min_ps(_mm256_mul_ps(exitScale, _mm256_mul_ps(_mm256_sub_ps(farPlane, rayOrigin), rayInverseDirection)), exit);
+	}
+
+	_mm256_storeu_ps(distances.data(), entry);
+	const uint32_t hitMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(entry, exit, _CMP_LE_OQ)));
+#else
+	uint32_t hitMask{ 0 };
+	for (uint32_t child{ 0 }; child < node.childCount; ++child)
+	{
+		distances[child] = IntersectBounds(ChildBounds(node, child), origin, inverseDirection, maxDistance);
+		if (distances[child] != std::numeric_limits<float>::infinity())
+		{
+			hitMask |= 1u << child;
+		}
+	}
+#endif
+
+	return hitMask & ((1u << node.childCount) - 1);
+}
+
+// Same contract as TraverseBvh.
+template <typename IntersectPrimitive>
+void TraverseWideBvh(const WideBvh& bvh, glm::vec3 origin, glm::vec3 direction, float& maxDistance, IntersectPrimitive&& intersectPrimitive) noexcept
+{
+	if (bvh.nodes.empty())
+	{
+		return;
+	}
+
+	struct StackEntry
+	{
+		uint32_t nodeIndex;
+		float distance;
+	};
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+
+	std::array<StackEntry, (wideBvhWidth - 1) * bvhMaxDepth + 1> stack;
+	size_t stackSize{ 0 };
+	stack[stackSize++] = StackEntry{ 0, 0.0f };
+
+	std::array<float, wideBvhWidth> distances;
+	std::array<uint32_t, wideBvhWidth> order;
+
+	while (stackSize > 0)
+	{
+		const StackEntry entry = stack[--stackSize];
+		if (entry.distance > maxDistance)
+		{
+			continue;
+		}
+
+		LUX_STATISTIC_INCREMENT(NodeVisits);
+		const WideBvhNode& node = bvh.nodes[entry.nodeIndex];
+
+		// Sorts the children that were hit nearest first.
+		uint32_t hitCount{ 0 };
+		for (uint32_t hitMask = IntersectChildren(node, origin, inverseDirection, maxDistance, distances); hitMask != 0; hitMask &= hitMask - 1)
+		{
+			const uint32_t child = static_cast<uint32_t>(std::countr_zero(hitMask));
+			uint32_t position{ hitCount++ };
+			for (; position > 0 && distances[order[position - 1]] > distances[child]; --position)
+			{
+				order[position] = order[position - 1];
+			}
+			order[position] = child;
+		}
+
+		for (uint32_t i{ 0 }; i < hitCount; ++i)
+		{
+			const uint32_t child = order[i];
+			if (node.primitiveCounts[child] == 0 || distances[child] > maxDistance)
+			{
+				continue;
+			}
+
+			for (uint32_t primitive{ 0 }; primitive < node.primitiveCounts[child]; ++primitive)
+			{
+				if (intersectPrimitive(bvh.primitiveIndices[node.children[child] + primitive], maxDistance))
+				{
+					return;
+				}
+			}
+		}
+
+		for (uint32_t i{ hitCount }; i-- > 0;)
+		{
+			const uint32_t child = order[i];
+			if (node.primitiveCounts[child] == 0)
+			{
+				stack[stackSize++] = StackEntry{ node.children[child], distances[child] };
+			}
+		}
+	}
+}
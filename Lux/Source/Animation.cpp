@@ -0,0 +1,72 @@
+#include "Animation.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+
+namespace
+{
+	const glm::vec4 Slerp(const glm::vec4& from, const glm::vec4& to, float fraction) noexcept
+	{
+		const glm::quat rotation = glm::slerp(glm::quat{ from.w, from.x, from.y, from.z }, glm::quat{ to.w, to.x, to.y, to.z }, fraction);
+		return glm::vec4{ rotation.x, rotation.y, rotation.z, rotation.w };
+	}
+}
+
+const glm::vec4 SampleChannel(const AnimationChannel& channel, float time) noexcept
+{
+	const bool cubic = channel.interpolation == AnimationInterpolation::CubicSpline;
+	const size_t keyStride = cubic ? 3 : 1;
+	const size_t valueOffset = cubic ? 1 : 0;
+	const auto keyValue = [&](size_t key)
+	{
+		return channel.values[key * keyStride + valueOffset];
+	};
+
+	const auto next = std::upper_bound(channel.times.begin(), channel.times.end(), time);
+	if (next == channel.times.begin())
+	{
+		return keyValue(0);
+	}
+	if (next == channel.times.end())
+	{
+		return keyValue(channel.times.size() - 1);
+	}
+
+	const size_t key = static_cast<size_t>(next - channel.times.begin()) - 1;
+	const float keyDuration = channel.times[key + 1] - channel.times[key];
+	const float fraction = (time - channel.times[key]) / keyDuration;
+
+	glm::vec4 value{};
+	switch (channel.interpolation)
+	{
+	case AnimationInterpolation::Step:
+		return keyValue(key);
+	case AnimationInterpolation::CubicSpline:
+	{
+		// Hermite spline between the values, tangents are scaled by the
+		// duration of the key.
+		const float fraction2 = fraction * fraction;
+		const float fraction3 = fraction2 * fraction;
+		const glm::vec4 outTangent = channel.values[3 * key + 2];
+		const glm::vec4 inTangent = channel.values[3 * (key + 1)];
+		value = (2.0f * fraction3 - 3.0f * fraction2 + 1.0f) * keyValue(key)
+			+ keyDuration * (fraction3 - 2.0f * fraction2 + fraction) * outTangent
+			+ (-2.0f * fraction3 + 3.0f * fraction2) * keyValue(key + 1)
+			+ keyDuration * (fraction3 - fraction2) * inTangent;
+		break;
+	}
+	case AnimationInterpolation::Linear:
+	default:
+		if (channel.path == AnimationPath::Rotation)
+		{
+			return Slerp(keyValue(key), keyValue(key + 1), fraction);
+		}
+		value = glm::mix(keyValue(key), keyValue(key + 1), fraction);
+		break;
+	}
+
+	return channel.path == AnimationPath::Rotation ? glm::normalize(value) : value;
+}
@@ -0,0 +1,524 @@
+#include "Benchmark.h"
+#include "ReferenceScene.h"
+#include "Renderer.h"
+#include "Ray.h"
+#include "Color.h"
+#include "Image.h"
+#include "ThreadPool.h"
+#include "Triangle.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct BenchmarkScene
+	{
+		std::string name;
+		ReferenceScene reference;
+	};
+
+	struct BuildVariant
+	{
+		const char* name;
+		BvhBuildSettings settings;
+		WideBvhLayout layout{ WideBvhLayout::DepthFirst };
+		// Stands in for assets exported in arbitrary order: the triangles are
+		// shuffled and not moved into leaf order afterwards.
+		bool shuffleTriangles{ false };
+	};
+
+	struct MemoryRow
+	{
+		std::string sceneName;
+		const char* variantName;
+		MeshMemoryReport report;
+	};
+
+	// Bumpy sphere with 2 * resolution^2 triangles, optionally standing on two
+	// huge ground triangles that overlap every node a plain SAH build makes.
+	Mesh MakeSyntheticMesh(uint32_t resolution, bool withGround)
+	{
+		const auto vertex = [resolution](uint32_t row, uint32_t column)
+		{
+			const float theta = glm::pi<float>() * static_cast<float>(row) / static_cast<float>(resolution);
+			const float phi = glm::two_pi<float>() * static_cast<float>(column) / static_cast<float>(resolution);
+			const float radius = 1.0f + 0.1f * glm::sin(12.0f * theta) * glm::sin(12.0f * phi);
+			return radius * glm::vec3{ glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi) };
+		};
+
+		Mesh mesh;
+		mesh.posistions.reserve(6 * static_cast<size_t>(resolution) * resolution);
+		for (uint32_t row{ 0 }; row < resolution; ++row)
+		{
+			for (uint32_t column{ 0 }; column < resolution; ++column)
+			{
+				const std::array<glm::vec3, 4> corners{ vertex(row, column), vertex(row, column + 1), vertex(row + 1, column), vertex(row + 1, column + 1) };
+				for (const uint32_t corner : { 0u, 1u, 2u, 1u, 3u, 2u })
+				{
+					mesh.posistions.push_back(corners[corner]);
+					mesh.normals.push_back(glm::normalize(corners[corner]));
+				}
+			}
+		}
+
+		if (withGround)
+		{
+			const std::array<glm::vec3, 4> corners{ glm::vec3{ -1000.0f, -1.1f, -1000.0f }, glm::vec3{ 1000.0f, -1.1f, -1000.0f }, glm::vec3{ -1000.0f, -1.1f, 1000.0f }, glm::vec3{ 1000.0f, -1.1f, 1000.0f } };
+			for (const uint32_t corner : { 0u, 2u, 1u, 1u, 2u, 3u })
+			{
+				mesh.posistions.push_back(corners[corner]);
+				mesh.normals.push_back(glm::vec3{ 0.0f, 1.0f, 0.0f });
+			}
+		}
+
+		return mesh;
+	}
+
+	const BenchmarkScene MakeSyntheticScene(ResourceManager& resourceManager, uint32_t resolution, bool withGround)
+	{
+		const std::string name = (withGround ? "Ground + " : "Synthetic ") + std::to_string(2 * resolution * resolution);
+		ReferenceScene reference
+		{
+			Scene{},
+			glm::vec3{ 0.0f, 0.5f, -3.0f },
+			glm::normalize(glm::vec3{ 0.0f, -0.15f, 1.0f }),
+			60.0f
+		};
+
+		AddObject(reference.scene, resourceManager.AddMesh(MakeSyntheticMesh(resolution, withGround), name), resourceManager.AddMaterial(Material{ Color::white, 0.0f }, name));
+		BuildAccelerationStructure(reference.scene);
+		return BenchmarkScene{ name, std::move(reference) };
+	}
+
+	void ShuffleTriangles(Mesh& mesh)
+	{
+		std::vector<uint32_t> order(mesh.posistions.size() / 3);
+		std::iota(order.begin(), order.end(), 0u);
+		std::shuffle(order.begin(), order.end(), std::mt19937{ 1 });
+
+		Mesh shuffled;
+		for (const uint32_t triangleIndex : order)
+		{
+			for (uint32_t corner{ 0 }; corner < 3; ++corner)
+			{
+				shuffled.posistions.push_back(mesh.posistions[3 * static_cast<size_t>(triangleIndex) + corner]);
+				if (mesh.normals.size() == mesh.posistions.size())
+				{
+					shuffled.normals.push_back(mesh.normals[3 * static_cast<size_t>(triangleIndex) + corner]);
+				}
+			}
+		}
+		mesh = std::move(shuffled);
+	}
+
+	// Cube subdivided into subdivisions^2 quads per face and pushed onto the
+	// unit sphere. Vertices come from integer grid points, so triangles that
+	// share an edge share its vertices bit for bit and the mesh is closed.
+	Mesh MakeClosedMesh(int32_t subdivisions)
+	{
+		Mesh mesh;
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			for (const int32_t side : { -subdivisions, subdivisions })
+			{
+				const auto vertex = [&](int32_t i, int32_t j)
+				{
+					glm::vec3 point{};
+					point[axis] = static_cast<float>(side);
+					point[(axis + 1) % 3] = static_cast<float>(2 * i - subdivisions);
+					point[(axis + 2) % 3] = static_cast<float>(2 * j - subdivisions);
+					return glm::normalize(point);
+				};
+
+				for (int32_t i{ 0 }; i < subdivisions; ++i)
+				{
+					for (int32_t j{ 0 }; j < subdivisions; ++j)
+					{
+						const std::array<glm::vec3, 4> corners{ vertex(i, j), vertex(i + 1, j), vertex(i, j + 1), vertex(i + 1, j + 1) };
+						for (const uint32_t corner : { 0u, 1u, 2u, 1u, 3u, 2u })
+						{
+							mesh.posistions.push_back(corners[corner]);
+							mesh.normals.push_back(corners[corner]);
+						}
+					}
+				}
+			}
+		}
+		return mesh;
+	}
+
+	struct LeakResult
+	{
+		uint64_t rayCount;
+		uint64_t misses;
+		double milliseconds;
+	};
+
+	// Fires rays from inside the closed mesh through every vertex and edge
+	// midpoint, where a triangle test that is not watertight lets them slip
+	// between two triangles. Every ray should hit.
+	template <typename IntersectPrimitive>
+	const LeakResult CountLeaks(const Mesh& mesh, IntersectPrimitive&& intersectPrimitive)
+	{
+		const std::array<glm::vec3, 4> origins{ glm::vec3{ 0.0f }, glm::vec3{ 0.1f, 0.2f, -0.3f }, glm::vec3{ -0.31f, 0.05f, 0.17f }, glm::vec3{ 0.23f, -0.29f, 0.11f } };
+
+		LeakResult result{ 0 };
+		const auto start = std::chrono::steady_clock::now();
+		for (const glm::vec3 origin : origins)
+		{
+			for (size_t triangle{ 0 }; triangle < mesh.posistions.size(); triangle += 3)
+			{
+				for (size_t corner{ 0 }; corner < 3; ++corner)
+				{
+					const glm::vec3 vertex = mesh.posistions[triangle + corner];
+					const glm::vec3 nextVertex = mesh.posistions[triangle + (corner + 1) % 3];
+					for (const glm::vec3 target : { vertex, 0.5f * (vertex + nextVertex) })
+					{
+						const glm::vec3 direction = glm::normalize(target - origin);
+						float maxDistance{ std::numeric_limits<float>::infinity() };
+						bool hit{ false };
+						intersectPrimitive(origin, direction, maxDistance, hit);
+						++result.rayCount;
+						result.misses += hit ? 0 : 1;
+					}
+				}
+			}
+		}
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+
+	const double Median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+
+	const uint64_t TracePrimaryRays(const Scene& scene, const Camera& camera, int32_t width, int32_t height, const std::vector<Tile>& tiles, ThreadPool& threadPool)
+	{
+		std::atomic<uint64_t> hits{ 0 };
+		std::vector<CameraRays> workerRays(threadPool.WorkerCount());
+		threadPool.ParallelFor(static_cast<uint32_t>(tiles.size()), [&](uint32_t tileIndex, uint32_t workerIndex)
+		{
+			CameraRays& rays = workerRays[workerIndex];
+			GenerateCameraRays(camera, width, height, tiles[tileIndex], {}, {}, rays);
+			uint64_t tileHits{ 0 };
+			for (size_t ray{ 0 }; ray < rays.directionX.size(); ++ray)
+			{
+				const glm::vec3 origin{ rays.originX[ray], rays.originY[ray], rays.originZ[ray] };
+				const glm::vec3 direction{ rays.directionX[ray], rays.directionY[ray], rays.directionZ[ray] };
+				tileHits += ClosestIntersection(scene, Ray{ origin, direction }) ? 1 : 0;
+			}
+			hits.fetch_add(tileHits, std::memory_order_relaxed);
+		});
+		return hits.load(std::memory_order_relaxed);
+	}
+
+	// Blue to white gradient over a dark ground and a sun 30 degrees up,
+	// bright enough to dominate the direct light.
+	const EnvironmentMap MakeSkyEnvironment()
+	{
+		constexpr int32_t width = 256;
+		constexpr int32_t height = 128;
+		constexpr int32_t sunX = 3 * width / 4;
+		constexpr int32_t sunY = height / 3;
+
+		std::vector<glm::vec3> radiance(static_cast<size_t>(width) * height);
+		for (int32_t y{ 0 }; y < height; ++y)
+		{
+			const float elevation = 1.0f - 2.0f * (static_cast<float>(y) + 0.5f) / static_cast<float>(height);
+			const glm::vec3 sky = elevation > 0.0f ? glm::mix(glm::vec3{ 1.0f, 1.0f, 1.0f }, glm::vec3{ 0.3f, 0.5f, 1.0f }, elevation) : glm::vec3{ 0.1f };
+			for (int32_t x{ 0 }; x < width; ++x)
+			{
+				const bool sun = std::abs(x - sunX) <= 1 && std::abs(y - sunY) <= 1;
+				radiance[static_cast<size_t>(y) * width + x] = sun ? glm::vec3{ 400.0f, 380.0f, 340.0f } : sky;
+			}
+		}
+		return MakeEnvironmentMap(width, height, std::move(radiance));
+	}
+}
+
+const bool RunBvhBenchmark(int32_t width, int32_t height, uint32_t repetitions)
+{
+	ResourceManager resourceManager;
+	ThreadPool threadPool;
+	const std::vector<Tile> tiles = MakeTiles(width, height);
+
+	std::vector<BenchmarkScene> scenes;
+	scenes.push_back(BenchmarkScene{ "Lantern", LoadReferenceScene(ReferenceSceneID::Lantern, resourceManager) });
+	scenes.push_back(MakeSyntheticScene(resourceManager, 256, false));
+	scenes.push_back(MakeSyntheticScene(resourceManager, 256, true));
+	scenes.push_back(MakeSyntheticScene(resourceManager, 724, false));
+
+	std::vector<BuildVariant> variants(7);
+	variants[0].name = "SAH";
+	variants[1].name = "LBVH-30";
+	variants[1].settings.mode = BvhBuildMode::Linear;
+	variants[1].settings.threadPool = &threadPool;
+	variants[2].name = "LBVH-63";
+	variants[2].settings = variants[1].settings;
+	variants[2].settings.mortonBits = 63;
+	variants[3].name = "SBVH";
+	variants[3].settings.mode = BvhBuildMode::Spatial;
+	variants[4].name = "SAH-BFS";
+	variants[4].layout = WideBvhLayout::BreadthFirst;
+	variants[5].name = "SAH-Treelet";
+	variants[5].layout = WideBvhLayout::Treelets;
+	variants[6].name = "SAH-Shuffle";
+	variants[6].shuffleTriangles = true;
+
+	std::vector<MemoryRow> memoryRows;
+	bool hitsMatch{ true };
+	std::printf("%-18s %-12s %10s %10s %10s %10s %10s %10s\n", "Scene", "Build", "Triangles", "References", "Build ms", "Trace ms", "Mrays/s", "SAH cost");
+
+	for (const BenchmarkScene& benchmarkScene : scenes)
+	{
+		const ReferenceScene& reference = benchmarkScene.reference;
+		const Camera camera{ reference.cameraPosition, reference.cameraPosition + reference.cameraDirection, reference.verticalFov, static_cast<float>(width) / static_cast<float>(height) };
+
+		// Every hierarchy must find the same primary hits as the first, SAH.
+		uint64_t sahHits{ 0 };
+		for (const BuildVariant& variant : variants)
+		{
+			std::vector<Mesh> meshes(reference.scene.meshes.size());
+			for (size_t meshIndex{ 0 }; meshIndex < meshes.size(); ++meshIndex)
+			{
+				meshes[meshIndex].posistions = reference.scene.meshes[meshIndex]->posistions;
+				meshes[meshIndex].normals = reference.scene.meshes[meshIndex]->normals;
+				if (variant.shuffleTriangles)
+				{
+					ShuffleTriangles(meshes[meshIndex]);
+				}
+			}
+
+			std::vector<double> buildMilliseconds;
+			for (uint32_t repetition{ 0 }; repetition < repetitions; ++repetition)
+			{
+				auto buildStart = std::chrono::steady_clock::now();
+				for (Mesh& mesh : meshes)
+				{
+					BuildMeshBvh(mesh, variant.settings, variant.layout);
+					if (!variant.shuffleTriangles)
+					{
+						ReorderTriangles(mesh);
+					}
+				}
+				buildMilliseconds.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count());
+			}
+
+			Scene scene = reference.scene;
+			size_t referenceCount{ 0 };
+			MeshMemoryReport memory{};
+			double weightedSahCost{ 0.0 };
+			for (size_t meshIndex{ 0 }; meshIndex < meshes.size(); ++meshIndex)
+			{
+				scene.meshes[meshIndex] = &meshes[meshIndex];
+				referenceCount += meshes[meshIndex].bvh.primitiveIndices.size();
+
+				const MeshMemoryReport meshMemory = ReportMemory(meshes[meshIndex]);
+				memory.triangleCount += meshMemory.triangleCount;
+				memory.binaryNodeCount += meshMemory.binaryNodeCount;
+				memory.wideNodeCount += meshMemory.wideNodeCount;
+				memory.leafCount += meshMemory.leafCount;
+				for (size_t bucket{ 0 }; bucket < memory.leafSizeHistogram.size(); ++bucket)
+				{
+					memory.leafSizeHistogram[bucket] += meshMemory.leafSizeHistogram[bucket];
+				}
+				memory.traversalBytes += meshMemory.traversalBytes;
+				memory.totalBytes += meshMemory.totalBytes;
+				weightedSahCost += static_cast<double>(meshMemory.sahCost) * static_cast<double>(meshMemory.triangleCount);
+			}
+			memory.sahCost = memory.triangleCount > 0 ? static_cast<float>(weightedSahCost / static_cast<double>(memory.triangleCount)) : 0.0f;
+			memoryRows.push_back(MemoryRow{ benchmarkScene.name, variant.name, memory });
+			BuildAccelerationStructure(scene);
+
+			std::vector<double> traceMilliseconds;
+			uint64_t hits{ 0 };
+			for (uint32_t repetition{ 0 }; repetition < repetitions; ++repetition)
+			{
+				auto traceStart = std::chrono::steady_clock::now();
+				hits = TracePrimaryRays(scene, camera, width, height, tiles, threadPool);
+				traceMilliseconds.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - traceStart).count());
+			}
+			if (&variant == &variants.front())
+			{
+				sahHits = hits;
+			}
+			else if (hits != sahHits)
+			{
+				std::printf("%s %s hit %llu primary rays where SAH hit %llu\n", benchmarkScene.name.c_str(), variant.name, static_cast<unsigned long long>(hits), static_cast<unsigned long long>(sahHits));
+				hitsMatch = false;
+			}
+
+			const double traceMedian = Median(traceMilliseconds);
+			const double raysPerMicrosecond = static_cast<double>(width) * static_cast<double>(height) / (traceMedian * 1e3);
+			std::printf("%-18s %-12s %10zu %10zu %10.3f %10.3f %10.2f %10.2f\n", benchmarkScene.name.c_str(), variant.name, memory.triangleCount, referenceCount, Median(buildMilliseconds), traceMedian, raysPerMicrosecond, memory.sahCost);
+		}
+	}
+
+	std::printf("\n%-18s %-12s %10s %10s %10s %8s %8s %s\n", "Scene", "Build", "Nodes", "Wide nodes", "Leaves", "Trace B", "Total B", "Leaf sizes 1..7, 8+");
+	for (const MemoryRow& row : memoryRows)
+	{
+		const MeshMemoryReport& memory = row.report;
+		const double triangleCount = static_cast<double>(std::max<size_t>(memory.triangleCount, 1));
+		std::printf("%-18s %-12s %10zu %10zu %10zu %8.1f %8.1f", row.sceneName.c_str(), row.variantName, memory.binaryNodeCount, memory.wideNodeCount, memory.leafCount, static_cast<double>(memory.traversalBytes) / triangleCount, static_cast<double>(memory.totalBytes) / triangleCount);
+		for (const size_t leaves : memory.leafSizeHistogram)
+		{
+			std::printf(" %zu", leaves);
+		}
+		std::printf("\n");
+	}
+	std::printf("Trace B and Total B are bytes per triangle.\n");
+
+	const bool leakFree = RunLeakTest();
+	return hitsMatch && leakFree;
+}
+
+const bool RunLeakTest()
+{
+	Mesh mesh = MakeClosedMesh(48);
+	BuildMeshBvh(mesh);
+	ReorderTriangles(mesh);
+
+	const LeakResult mollerTrumbore = CountLeaks(mesh, [&](glm::vec3 origin, glm::vec3 direction, float& maxDistance, bool& hit)
+	{
+		TraverseWideBvh(mesh.wideBvh, origin, direction, maxDistance, [&](uint32_t triangleIndex, float& meshMaxDistance)
+		{
+			const float distance = IntersectTriangleMollerTrumbore(origin, direction, mesh.posistions[3 * triangleIndex], mesh.posistions[3 * triangleIndex + 1], mesh.posistions[3 * triangleIndex + 2], 0.0f, meshMaxDistance).distance;
+			if (distance < meshMaxDistance)
+			{
+				meshMaxDistance = distance;
+				hit = true;
+			}
+			return false;
+		});
+	});
+
+	const LeakResult watertight = CountLeaks(mesh, [&](glm::vec3 origin, glm::vec3 direction, float& maxDistance, bool& hit)
+	{
+		const TriangleRay triangleRay = PrepareTriangleRay(origin, direction);
+		TraverseWideBvh(mesh.wideBvh, origin, direction, maxDistance, [&](uint32_t triangleIndex, float& meshMaxDistance)
+		{
+			const float distance = IntersectTriangle(triangleRay, mesh.posistions[3 * triangleIndex], mesh.posistions[3 * triangleIndex + 1], mesh.posistions[3 * triangleIndex + 2], 0.0f, meshMaxDistance).distance;
+			if (distance < meshMaxDistance)
+			{
+				meshMaxDistance = distance;
+				hit = true;
+			}
+			return false;
+		});
+	});
+
+	std::printf("\n%-18s %10s %10s %10s\n", "Triangle test", "Rays", "Misses", "Trace ms");
+	std::printf("%-18s %10llu %10llu %10.3f\n", "Moller-Trumbore", static_cast<unsigned long long>(mollerTrumbore.rayCount), static_cast<unsigned long long>(mollerTrumbore.misses), mollerTrumbore.milliseconds);
+	std::printf("%-18s %10llu %10llu %10.3f\n", "Watertight", static_cast<unsigned long long>(watertight.rayCount), static_cast<unsigned long long>(watertight.misses), watertight.milliseconds);
+	std::printf("Rays from inside a closed mesh through its vertices and edge midpoints, every one should hit.\n");
+
+	// Moller-Trumbore is only there for comparison, the watertight test is
+	// the one tracing uses and must not leak.
+	if (watertight.misses > 0)
+	{
+		std::printf("The watertight triangle test leaked %llu rays\n", static_cast<unsigned long long>(watertight.misses));
+		return false;
+	}
+	return true;
+}
+
+void RunSamplerBenchmark(int32_t width, int32_t height, uint32_t maxSamples)
+{
+	constexpr std::array<SamplerType, 4> samplerTypes{ SamplerType::Independent, SamplerType::Stratified, SamplerType::Sobol, SamplerType::BlueNoise };
+
+	ResourceManager resourceManager;
+	ThreadPool threadPool;
+	const std::vector<Tile> tiles = MakeTiles(width, height);
+	const EnvironmentMap sky = MakeSkyEnvironment();
+	std::vector<TileScratch> scratch(threadPool.WorkerCount());
+
+	std::vector<BenchmarkScene> scenes;
+	scenes.push_back(BenchmarkScene{ "Ground", LoadReferenceScene(ReferenceSceneID::GroundAndQuad, resourceManager) });
+	scenes.push_back(BenchmarkScene{ "Lantern", LoadReferenceScene(ReferenceSceneID::Lantern, resourceManager) });
+	scenes.push_back(BenchmarkScene{ "Spheres", LoadReferenceScene(ReferenceSceneID::Spheres, resourceManager) });
+
+	std::FILE* csv = std::fopen("Lux.convergence.csv", "w");
+	if (csv)
+	{
+		std::fprintf(csv, "scene,sampler,samples,rmse\n");
+	}
+
+	for (BenchmarkScene& benchmarkScene : scenes)
+	{
+		ReferenceScene& reference = benchmarkScene.reference;
+		reference.scene.environment = &sky;
+		const Camera camera{ reference.cameraPosition, reference.cameraPosition + reference.cameraDirection, reference.verticalFov, static_cast<float>(width) / static_cast<float>(height) };
+
+		const auto render = [&](const SamplerSettings& sampling)
+		{
+			Framebuffer framebuffer{ width, height };
+			threadPool.ParallelFor(static_cast<uint32_t>(tiles.size()), [&](uint32_t tileIndex, uint32_t workerIndex)
+			{
+				RenderTile(reference.scene, camera, tiles[tileIndex], framebuffer, scratch[workerIndex], sampling);
+			});
+			return framebuffer;
+		};
+
+		// A different seed than the measured images, so the reference does
+		// not share their first samples.
+		const Framebuffer converged = render(SamplerSettings{ SamplerType::Sobol, 16 * maxSamples, 0x5eed });
+
+		std::printf("%-10s %8s", benchmarkScene.name.c_str(), "Samples");
+		for (const SamplerType type : samplerTypes)
+		{
+			std::printf(" %12s", SamplerTypeName(type));
+		}
+		std::printf("\n");
+
+		std::array<std::vector<float>, samplerTypes.size()> errors;
+		uint32_t samples{ 1 };
+		for (; samples <= maxSamples; samples *= 2)
+		{
+			std::printf("%-10s %8u", benchmarkScene.name.c_str(), samples);
+			for (size_t typeIndex{ 0 }; typeIndex < samplerTypes.size(); ++typeIndex)
+			{
+				const float error = RootMeanSquareError(render(SamplerSettings{ samplerTypes[typeIndex], samples }), converged);
+				errors[typeIndex].push_back(error);
+				std::printf(" %12.6f", error);
+				if (csv)
+				{
+					std::fprintf(csv, "%s,%s,%u,%.8f\n", benchmarkScene.name.c_str(), SamplerTypeName(samplerTypes[typeIndex]), samples, error);
+				}
+			}
+			std::printf("\n");
+		}
+
+		// -0.5 is the Monte Carlo rate, lower converges faster.
+		std::printf("%-10s %8s", benchmarkScene.name.c_str(), "Slope");
+		const float sampleRange = std::log2(static_cast<float>(samples / 2));
+		for (const std::vector<float>& typeErrors : errors)
+		{
+			const float slope = sampleRange > 0.0f && typeErrors.front() > 0.0f && typeErrors.back() > 0.0f ? std::log2(typeErrors.back() / typeErrors.front()) / sampleRange : 0.0f;
+			std::printf(" %12.3f", slope);
+		}
+		std::printf("\n\n");
+	}
+
+	if (csv)
+	{
+		std::fclose(csv);
+		std::printf("Wrote Lux.convergence.csv\n");
+	}
+}
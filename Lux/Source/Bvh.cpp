@@ -0,0 +1,296 @@
+#include "Bvh.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+	struct Bin
+	{
+		Bounds bounds;
+		uint32_t count{ 0 };
+	};
+
+	struct BuildContext
+	{
+		gsl::span<const Bounds> primitiveBounds;
+		std::vector<glm::vec3> centroids;
+		const BvhBuildSettings& settings;
+		Bvh& bvh;
+	};
+
+	const Bounds ComputeNodeBounds(const BuildContext& context, uint32_t first, uint32_t count) noexcept
+	{
+		Bounds bounds{};
+		for (uint32_t i{ first }; i < first + count; ++i)
+		{
+			Grow(bounds, context.primitiveBounds[context.bvh.primitiveIndices[i]]);
+		}
+		return bounds;
+	}
+
+	const Bounds RefitNode(const Bvh& bvh, const BvhNode& node, gsl::span<const Bounds> primitiveBounds) noexcept
+	{
+		Bounds bounds{};
+
+		if (node.primitiveCount > 0)
+		{
+			for (uint32_t i{ node.offset }; i < node.offset + node.primitiveCount; ++i)
+			{
+				Grow(bounds, primitiveBounds[bvh.primitiveIndices[i]]);
+			}
+		}
+		else
+		{
+			Grow(bounds, bvh.nodes[node.offset].bounds);
+			Grow(bounds, bvh.nodes[node.offset + 1].bounds);
+		}
+
+		return bounds;
+	}
+
+	// Linear builds do not store children after their parent, so refitting
+	// recurses instead of walking the nodes backwards.
+	void RefitSubtree(Bvh& bvh, uint32_t nodeIndex, gsl::span<const Bounds> primitiveBounds) noexcept
+	{
+		const BvhNode& node = bvh.nodes[nodeIndex];
+		if (node.primitiveCount == 0)
+		{
+			RefitSubtree(bvh, node.offset, primitiveBounds);
+			RefitSubtree(bvh, node.offset + 1, primitiveBounds);
+		}
+		bvh.nodes[nodeIndex].bounds = RefitNode(bvh, node, primitiveBounds);
+	}
+
+	void Subdivide(BuildContext& context, uint32_t nodeIndex, uint32_t depth)
+	{
+		std::vector<uint32_t>& primitiveIndices = context.bvh.primitiveIndices;
+		const uint32_t first = context.bvh.nodes[nodeIndex].offset;
+		const uint32_t count = context.bvh.nodes[nodeIndex].primitiveCount;
+		const Bounds nodeBounds = context.bvh.nodes[nodeIndex].bounds;
+
+		if (count <= context.settings.maxLeafSize || depth + 1 >= bvhMaxDepth)
+		{
+			return;
+		}
+
+		Bounds centroidBounds{};
+		for (uint32_t i{ first }; i < first + count; ++i)
+		{
+			Grow(centroidBounds, context.centroids[primitiveIndices[i]]);
+		}
+
+		const uint32_t binCount = context.settings.binCount;
+		std::vector<Bin> bins(binCount);
+		std::vector<float> rightCosts(binCount);
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis{ -1 };
+		uint32_t bestSplit{ 0 };
+
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			const float extent = centroidBounds.maximum[axis] - centroidBounds.minimum[axis];
+			if (extent <= 0.0f)
+			{
+				continue;
+			}
+
+			const float binScale = static_cast<float>(binCount) / extent;
+			std::fill(bins.begin(), bins.end(), Bin{});
+			for (uint32_t i{ first }; i < first + count; ++i)
+			{
+				const uint32_t primitiveIndex = primitiveIndices[i];
+				const uint32_t binIndex = std::min(binCount - 1, static_cast<uint32_t>((context.centroids[primitiveIndex][axis] - centroidBounds.minimum[axis]) * binScale));
+				Grow(bins[binIndex].bounds, context.primitiveBounds[primitiveIndex]);
+				++bins[binIndex].count;
+			}
+
+			Bounds rightBounds{};
+			uint32_t rightCount{ 0 };
+			for (uint32_t split{ binCount - 1 }; split > 0; --split)
+			{
+				Grow(rightBounds, bins[split].bounds);
+				rightCount += bins[split].count;
+				rightCosts[split] = static_cast<float>(rightCount) * SurfaceArea(rightBounds);
+			}
+
+			Bounds leftBounds{};
+			uint32_t leftCount{ 0 };
+			for (uint32_t split{ 1 }; split < binCount; ++split)
+			{
+				Grow(leftBounds, bins[split - 1].bounds);
+				leftCount += bins[split - 1].count;
+
+				const float cost = static_cast<float>(leftCount) * SurfaceArea(leftBounds) + rightCosts[split];
+				if (leftCount > 0 && leftCount < count && cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		if (bestAxis == -1)
+		{
+			return;
+		}
+
+		const float nodeArea = std::max(SurfaceArea(nodeBounds), std::numeric_limits<float>::min());
+		const float splitCost = context.settings.traversalCost + context.settings.intersectionCost * bestCost / nodeArea;
+		const float leafCost = context.settings.intersectionCost * static_cast<float>(count);
+		if (splitCost >= leafCost)
+		{
+			return;
+		}
+
+		const float binScale = static_cast<float>(binCount) / (centroidBounds.maximum[bestAxis] - centroidBounds.minimum[bestAxis]);
+		auto middle = std::partition(primitiveIndices.begin() + first, primitiveIndices.begin() + first + count, [&](uint32_t primitiveIndex)
+		{
+			const uint32_t binIndex = std::min(binCount - 1, static_cast<uint32_t>((context.centroids[primitiveIndex][bestAxis] - centroidBounds.minimum[bestAxis]) * binScale));
+			return binIndex < bestSplit;
+		});
+		const uint32_t leftCount = static_cast<uint32_t>(middle - (primitiveIndices.begin() + first));
+
+		const uint32_t leftChild = static_cast<uint32_t>(context.bvh.nodes.size());
+		context.bvh.nodes.push_back(BvhNode{ ComputeNodeBounds(context, first, leftCount), first, leftCount });
+		context.bvh.nodes.push_back(BvhNode{ ComputeNodeBounds(context, first + leftCount, count - leftCount), first + leftCount, count - leftCount });
+
+		BvhNode& node = context.bvh.nodes[nodeIndex];
+		node.offset = leftChild;
+		node.primitiveCount = 0;
+
+		Subdivide(context, leftChild, depth + 1);
+		Subdivide(context, leftChild + 1, depth + 1);
+	}
+}
+
+const Bvh BuildBvh(gsl::span<const Bounds> primitiveBounds, const BvhBuildSettings& settings)
+{
+	if (settings.mode == BvhBuildMode::Linear)
+	{
+		return BuildLinearBvh(primitiveBounds, settings);
+	}
+	if (settings.mode == BvhBuildMode::Spatial)
+	{
+		return BuildSpatialBvh(primitiveBounds, {}, settings);
+	}
+
+	LUX_PROFILE_ZONE("BuildBvh");
+
+	Bvh bvh{};
+	if (primitiveBounds.empty())
+	{
+		return bvh;
+	}
+
+	const uint32_t primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+	bvh.primitiveIndices.resize(primitiveCount);
+	std::iota(bvh.primitiveIndices.begin(), bvh.primitiveIndices.end(), 0u);
+	bvh.nodes.reserve(2 * static_cast<size_t>(primitiveCount));
+
+	BuildContext context{ primitiveBounds, {}, settings, bvh };
+	context.centroids.reserve(primitiveCount);
+	for (const Bounds& bounds : primitiveBounds)
+	{
+		context.centroids.push_back(Centroid(bounds));
+	}
+
+	bvh.nodes.push_back(BvhNode{ ComputeNodeBounds(context, 0, primitiveCount), 0, primitiveCount });
+	Subdivide(context, 0, 0);
+	bvh.builtSahCost = ComputeSahCost(bvh, settings);
+
+	return bvh;
+}
+
+const BvhTopology ComputeTopology(const Bvh& bvh)
+{
+	BvhTopology topology{};
+	topology.parents.resize(bvh.nodes.size(), std::numeric_limits<uint32_t>::max());
+	topology.primitiveLeaves.resize(bvh.primitiveIndices.size());
+
+	for (uint32_t nodeIndex{ 0 }; nodeIndex < bvh.nodes.size(); ++nodeIndex)
+	{
+		const BvhNode& node = bvh.nodes[nodeIndex];
+		if (node.primitiveCount > 0)
+		{
+			for (uint32_t i{ node.offset }; i < node.offset + node.primitiveCount; ++i)
+			{
+				topology.primitiveLeaves[bvh.primitiveIndices[i]] = nodeIndex;
+			}
+		}
+		else
+		{
+			topology.parents[node.offset] = nodeIndex;
+			topology.parents[node.offset + 1] = nodeIndex;
+		}
+	}
+
+	return topology;
+}
+
+const float ComputeSahCost(const Bvh& bvh, const BvhBuildSettings& settings) noexcept
+{
+	if (bvh.nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	float cost{ 0.0f };
+	for (const BvhNode& node : bvh.nodes)
+	{
+		const float nodeCost = node.primitiveCount > 0 ? settings.intersectionCost * static_cast<float>(node.primitiveCount) : settings.traversalCost;
+		cost += nodeCost * SurfaceArea(node.bounds);
+	}
+
+	return cost / std::max(SurfaceArea(bvh.nodes[0].bounds), std::numeric_limits<float>::min());
+}
+
+void RefitBvh(Bvh& bvh, gsl::span<const Bounds> primitiveBounds) noexcept
+{
+	if (!bvh.nodes.empty())
+	{
+		RefitSubtree(bvh, 0, primitiveBounds);
+	}
+}
+
+void RefitMotionBvh(Bvh& bvh, gsl::span<const Bounds> startBounds, gsl::span<const Bounds> endBounds)
+{
+	bvh.endBounds.clear();
+	if (bvh.nodes.empty())
+	{
+		return;
+	}
+
+	RefitSubtree(bvh, 0, endBounds);
+	bvh.endBounds.reserve(bvh.nodes.size());
+	for (const BvhNode& node : bvh.nodes)
+	{
+		bvh.endBounds.push_back(node.bounds);
+	}
+	RefitSubtree(bvh, 0, startBounds);
+}
+
+void RefitBvh(Bvh& bvh, const BvhTopology& topology, gsl::span<const Bounds> primitiveBounds, gsl::span<const uint32_t> changedPrimitives) noexcept
+{
+	for (const uint32_t primitive : changedPrimitives)
+	{
+		uint32_t nodeIndex = topology.primitiveLeaves[primitive];
+
+		while (nodeIndex != std::numeric_limits<uint32_t>::max())
+		{
+			BvhNode& node = bvh.nodes[nodeIndex];
+			const Bounds bounds = RefitNode(bvh, node, primitiveBounds);
+
+			if (bounds.minimum == node.bounds.minimum && bounds.maximum == node.bounds.maximum)
+			{
+				break;
+			}
+
+			node.bounds = bounds;
+			nodeIndex = topology.parents[nodeIndex];
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#include "CacheKey.h"
+
+#include <functional>
+#include <istream>
+#include <ostream>
+
+namespace
+{
+	// Longer identities only come from corrupt files.
+	constexpr uint32_t maximumIdentityLength = 1u << 16;
+}
+
+const std::optional<CacheKey> MakeCacheKey(const std::filesystem::path& sourcePath, std::string_view suffix)
+{
+	std::error_code error{};
+	const std::filesystem::path canonicalPath = std::filesystem::canonical(sourcePath, error);
+	if (error)
+	{
+		return std::nullopt;
+	}
+
+	const uintmax_t size = std::filesystem::file_size(canonicalPath, error);
+	if (error)
+	{
+		return std::nullopt;
+	}
+	const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(canonicalPath, error);
+	if (error)
+	{
+		return std::nullopt;
+	}
+
+	return CacheKey{ canonicalPath.generic_string().append(suffix), static_cast<uint64_t>(size), static_cast<int64_t>(writeTime.time_since_epoch().count()) };
+}
+
+const std::filesystem::path CachePath(const std::filesystem::path& cacheDirectory, const CacheKey& key, std::string_view extension)
+{
+	return cacheDirectory / (std::to_string(std::hash<std::string>{}(key.identity)) + std::string{ extension });
+}
+
+void WriteCacheKey(std::ostream& file, const CacheKey& key)
+{
+	const uint32_t identityLength = static_cast<uint32_t>(key.identity.size());
+	file.write(reinterpret_cast<const char*>(&key.sourceSize), sizeof(key.sourceSize));
+	file.write(reinterpret_cast<const char*>(&key.sourceWriteTime), sizeof(key.sourceWriteTime));
+	file.write(reinterpret_cast<const char*>(&identityLength), sizeof(identityLength));
+	file.write(key.identity.data(), static_cast<std::streamsize>(identityLength));
+}
+
+const std::optional<CacheKey> ReadCacheKey(std::istream& file)
+{
+	CacheKey key{};
+	uint32_t identityLength{ 0 };
+	file.read(reinterpret_cast<char*>(&key.sourceSize), sizeof(key.sourceSize));
+	file.read(reinterpret_cast<char*>(&key.sourceWriteTime), sizeof(key.sourceWriteTime));
+	file.read(reinterpret_cast<char*>(&identityLength), sizeof(identityLength));
+	if (!file || identityLength > maximumIdentityLength)
+	{
+		return std::nullopt;
+	}
+
+	key.identity.resize(identityLength);
+	file.read(key.identity.data(), static_cast<std::streamsize>(identityLength));
+	if (!file)
+	{
+		return std::nullopt;
+	}
+	return key;
+}
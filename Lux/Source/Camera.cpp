@@ -1,21 +1,315 @@
 #include "Camera.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
 #include <cmath>
 #include <glm/geometric.hpp>
 #include <glm/gtc/constants.hpp>
-#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	void UpdateImagePlane(Camera& camera)
+	{
+		const float distance = camera.model == CameraModel::ThinLens ? camera.focusDistance : 1.0f;
+		const glm::vec3 center = camera.model == CameraModel::Orthographic ? camera.position : camera.position + distance * camera.forward;
+
+		camera.horizontal = 2.0f * camera.halfWidth * distance * camera.right;
+		camera.vertical = 2.0f * camera.halfHeight * distance * camera.up;
+		camera.lower_left_corner = center - 0.5f * camera.horizontal - 0.5f * camera.vertical;
+	}
+
+	void ResizeRays(CameraRays& rays, size_t rayCount)
+	{
+		for (std::vector<float>* component : { &rays.originX, &rays.originY, &rays.originZ, &rays.directionX, &rays.directionY, &rays.directionZ })
+		{
+			component->resize(rayCount);
+		}
+	}
+
+	const glm::vec2 PixelOffset(gsl::span<const glm::vec2> jitter, size_t ray) noexcept
+	{
+		return jitter.empty() ? glm::vec2{ 0.5f } : jitter[ray];
+	}
+
+	// Shirley and Chiu's concentric mapping, keeps the strata of the samples.
+	const glm::vec2 SampleDisc(glm::vec2 u) noexcept
+	{
+		const glm::vec2 offset = 2.0f * u - 1.0f;
+		if (offset.x == 0.0f && offset.y == 0.0f)
+		{
+			return glm::vec2{ 0.0f };
+		}
+
+		const bool horizontal = std::abs(offset.x) > std::abs(offset.y);
+		const float radius = horizontal ? offset.x : offset.y;
+		const float angle = horizontal ? glm::quarter_pi<float>() * (offset.y / offset.x) : glm::half_pi<float>() - glm::quarter_pi<float>() * (offset.x / offset.y);
+		return radius * glm::vec2{ std::cos(angle), std::sin(angle) };
+	}
+
+	// Rays from the origins already in rays through the image plane, eight at a
+	// time with AVX2. Serves pinhole and thin lens cameras, a pinhole just has
+	// all origins at the camera position.
+	void GeneratePlanarRays(const Camera& camera, int32_t imageWidth, int32_t imageHeight, const Tile& tile, gsl::span<const glm::vec2> jitter, CameraRays& rays) noexcept
+	{
+		const float inverseWidth = 1.0f / static_cast<float>(imageWidth);
+		const float inverseHeight = 1.0f / static_cast<float>(imageHeight);
+		// The image plane relative to the camera, so each ray only adds two
+		// scaled axes to it.
+		const glm::vec3 corner = camera.lower_left_corner - camera.position;
+
+		// Same operations in the same order as the AVX2 loop, so both give
+		// identical rays.
+		const auto scalarRay = [&](size_t ray, int32_t x, int32_t y)
+		{
+			const glm::vec2 offset = PixelOffset(jitter, ray);
+			const float u = (static_cast<float>(x) + offset.x) * inverseWidth;
+			const float v = (static_cast<float>(y) + offset.y) * inverseHeight;
+			const glm::vec3 lensOffset = glm::vec3{ rays.originX[ray], rays.originY[ray], rays.originZ[ray] } - camera.position;
+			const glm::vec3 direction = corner + u * camera.horizontal + v * camera.vertical - lensOffset;
+			const float inverseLength = 1.0f / std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+			rays.directionX[ray] = direction.x * inverseLength;
+			rays.directionY[ray] = direction.y * inverseLength;
+			rays.directionZ[ray] = direction.z * inverseLength;
+		};
+
+#if defined(__AVX2__)
+		const __m256 laneOffsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+		const __m256 positionLanes[3]{ _mm256_set1_ps(camera.position.x), _mm256_set1_ps(camera.position.y), _mm256_set1_ps(camera.position.z) };
+		const __m256 cornerLanes[3]{ _mm256_set1_ps(corner.x), _mm256_set1_ps(corner.y), _mm256_set1_ps(corner.z) };
+		const __m256 horizontalLanes[3]{ _mm256_set1_ps(camera.horizontal.x), _mm256_set1_ps(camera.horizontal.y), _mm256_set1_ps(camera.horizontal.z) };
+		const __m256 verticalLanes[3]{ _mm256_set1_ps(camera.vertical.x), _mm256_set1_ps(camera.vertical.y), _mm256_set1_ps(camera.vertical.z) };
+		const __m256 inverseWidthLanes = _mm256_set1_ps(inverseWidth);
+		const __m256 inverseHeightLanes = _mm256_set1_ps(inverseHeight);
+		float* const origins[3]{ rays.originX.data(), rays.originY.data(), rays.originZ.data() };
+#endif
+
+		for (int32_t row{ 0 }; row < tile.height; ++row)
+		{
+			const int32_t y = tile.y + row;
+			const size_t rowStart = static_cast<size_t>(row) * static_cast<size_t>(tile.width);
+			int32_t column{ 0 };
+
+#if defined(__AVX2__)
+			const __m256 rowY = _mm256_set1_ps(static_cast<float>(y));
+			for (; column + 8 <= tile.width; column += 8)
+			{
+				const size_t ray = rowStart + static_cast<size_t>(column);
+				__m256 offsetX = _mm256_set1_ps(0.5f);
+				__m256 offsetY = offsetX;
+				if (!jitter.empty())
+				{
+					// x0 y0 x1 y1 ... x7 y7 to x0..x7 and y0..y7, shuffle_ps works
+					// within 128 bit lanes and leaves the quarters out of order.
+					const __m256 low = _mm256_loadu_ps(&jitter[ray].x);
+					const __m256 high = _mm256_loadu_ps(&jitter[ray + 4].x);
+					offsetX = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+					offsetY = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+				}
+
+				const __m256 x = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(tile.x + column)), laneOffsets);
+				const __m256 u = _mm256_mul_ps(_mm256_add_ps(x, offsetX), inverseWidthLanes);
+				const __m256 v = _mm256_mul_ps(_mm256_add_ps(rowY, offsetY), inverseHeightLanes);
+
+				__m256 direction[3];
+				for (size_t axis{ 0 }; axis < 3; ++axis)
+				{
+					const __m256 lensOffset = _mm256_sub_ps(_mm256_loadu_ps(origins[axis] + ray), positionLanes[axis]);
+					direction[axis] = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(cornerLanes[axis], _mm256_mul_ps(u, horizontalLanes[axis])), _mm256_mul_ps(v, verticalLanes[axis])), lensOffset);
+				}
+				const __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(direction[0], direction[0]), _mm256_mul_ps(direction[1], direction[1])), _mm256_mul_ps(direction[2], direction[2]));
+				const __m256 inverseLength = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSquared));
+
+				_mm256_storeu_ps(&rays.directionX[ray], _mm256_mul_ps(direction[0], inverseLength));
+				_mm256_storeu_ps(&rays.directionY[ray], _mm256_mul_ps(direction[1], inverseLength));
+				_mm256_storeu_ps(&rays.directionZ[ray], _mm256_mul_ps(direction[2], inverseLength));
+			}
+#endif
+
+			for (; column < tile.width; ++column)
+			{
+				scalarRay(rowStart + static_cast<size_t>(column), tile.x + column, y);
+			}
+		}
+	}
+
+	void GenerateOrthographicRays(const Camera& camera, int32_t imageWidth, int32_t imageHeight, const Tile& tile, gsl::span<const glm::vec2> jitter, CameraRays& rays) noexcept
+	{
+		const float inverseWidth = 1.0f / static_cast<float>(imageWidth);
+		const float inverseHeight = 1.0f / static_cast<float>(imageHeight);
+
+		// Plain loops over the arrays without branches, compilers vectorize
+		// them.
+		std::fill(rays.directionX.begin(), rays.directionX.end(), camera.forward.x);
+		std::fill(rays.directionY.begin(), rays.directionY.end(), camera.forward.y);
+		std::fill(rays.directionZ.begin(), rays.directionZ.end(), camera.forward.z);
+		for (int32_t row{ 0 }; row < tile.height; ++row)
+		{
+			const size_t rowStart = static_cast<size_t>(row) * static_cast<size_t>(tile.width);
+			for (int32_t column{ 0 }; column < tile.width; ++column)
+			{
+				const size_t ray = rowStart + static_cast<size_t>(column);
+				const glm::vec2 offset = PixelOffset(jitter, ray);
+				const float u = (static_cast<float>(tile.x + column) + offset.x) * inverseWidth;
+				const float v = (static_cast<float>(tile.y + row) + offset.y) * inverseHeight;
+				const glm::vec3 origin = camera.lower_left_corner + u * camera.horizontal + v * camera.vertical;
+				rays.originX[ray] = origin.x;
+				rays.originY[ray] = origin.y;
+				rays.originZ[ray] = origin.z;
+			}
+		}
+	}
+
+	// Scalar, every ray needs its own sines and cosines.
+	void GenerateEquirectangularRays(const Camera& camera, int32_t imageWidth, int32_t imageHeight, const Tile& tile, gsl::span<const glm::vec2> jitter, CameraRays& rays) noexcept
+	{
+		const float inverseWidth = 1.0f / static_cast<float>(imageWidth);
+		const float inverseHeight = 1.0f / static_cast<float>(imageHeight);
+
+		for (int32_t row{ 0 }; row < tile.height; ++row)
+		{
+			const size_t rowStart = static_cast<size_t>(row) * static_cast<size_t>(tile.width);
+			for (int32_t column{ 0 }; column < tile.width; ++column)
+			{
+				const size_t ray = rowStart + static_cast<size_t>(column);
+				const glm::vec2 offset = PixelOffset(jitter, ray);
+				// Forward in the middle of the image, the top row looks up.
+				const float azimuth = glm::two_pi<float>() * ((static_cast<float>(tile.x + column) + offset.x) * inverseWidth - 0.5f);
+				const float elevation = glm::pi<float>() * ((static_cast<float>(tile.y + row) + offset.y) * inverseHeight - 0.5f);
+				const float sineAzimuth = std::sin(azimuth);
+				const float cosineAzimuth = std::cos(azimuth);
+				const float cosineElevation = std::cos(elevation);
+
+				const glm::vec3 direction = cosineElevation * (sineAzimuth * camera.right + cosineAzimuth * camera.forward) + std::sin(elevation) * camera.up;
+				const glm::vec3 origin = camera.position + camera.stereoOffset * (cosineAzimuth * camera.right - sineAzimuth * camera.forward);
+				rays.originX[ray] = origin.x;
+				rays.originY[ray] = origin.y;
+				rays.originZ[ray] = origin.z;
+				rays.directionX[ray] = direction.x;
+				rays.directionY[ray] = direction.y;
+				rays.directionZ[ray] = direction.z;
+			}
+		}
+	}
+}
 
 Camera::Camera(glm::vec3 position, glm::vec3 lookat, float vfov, float aspect)
-    : position(position)
 {
 	float theta = vfov * glm::pi<float>() / 180.0f;
-    float halfHeight = std::tan(theta / 2);
-    float halfWidth = aspect * halfHeight;
-    
-    glm::vec3 cameraDirection = glm::normalize(position - lookat);
-    glm::vec3 cameraRight = glm::normalize(glm::cross(glm::vec3{ 0.0f, 1.0f, 0.0f }, cameraDirection));
-    glm::vec3 cameraUp = glm::cross(cameraDirection, cameraRight);
-
-    lower_left_corner = position - halfWidth * cameraRight - halfHeight * cameraUp - cameraDirection;
-    horizontal = 2 * halfWidth * cameraRight;
-    vertical = 2 * halfHeight * cameraUp;
-}
\ No newline at end of file
+	halfHeight = std::tan(theta / 2);
+	halfWidth = aspect * halfHeight;
+	AimCamera(*this, position, lookat);
+}
+
+const Camera MakeThinLensCamera(glm::vec3 position, glm::vec3 lookat, float vfov, float aspect, float lensRadius, float focusDistance)
+{
+	Camera camera{ position, lookat, vfov, aspect };
+	camera.model = CameraModel::ThinLens;
+	camera.lensRadius = lensRadius;
+	camera.focusDistance = focusDistance;
+	UpdateImagePlane(camera);
+	return camera;
+}
+
+const Camera MakeOrthographicCamera(glm::vec3 position, glm::vec3 lookat, float viewHeight, float aspect)
+{
+	Camera camera{ position, lookat, 90.0f, aspect };
+	camera.model = CameraModel::Orthographic;
+	camera.halfHeight = 0.5f * viewHeight;
+	camera.halfWidth = aspect * camera.halfHeight;
+	UpdateImagePlane(camera);
+	return camera;
+}
+
+const Camera MakeEquirectangularCamera(glm::vec3 position, glm::vec3 lookat)
+{
+	Camera camera{ position, lookat, 90.0f, 2.0f };
+	camera.model = CameraModel::Equirectangular;
+	return camera;
+}
+
+const std::array<Camera, 2> MakeStereoPair(const Camera& camera, float eyeDistance)
+{
+	std::array<Camera, 2> eyes{ camera, camera };
+	for (size_t eye{ 0 }; eye < eyes.size(); ++eye)
+	{
+		const float offset = (eye == 0 ? -0.5f : 0.5f) * eyeDistance;
+		if (camera.model == CameraModel::Equirectangular)
+		{
+			eyes[eye].stereoOffset = offset;
+		}
+		else
+		{
+			eyes[eye].position += offset * camera.right;
+			UpdateImagePlane(eyes[eye]);
+		}
+	}
+	return eyes;
+}
+
+void AimCamera(Camera& camera, glm::vec3 position, glm::vec3 lookat)
+{
+	camera.position = position;
+	camera.forward = glm::normalize(lookat - position);
+	camera.right = glm::normalize(glm::cross(camera.forward, glm::vec3{ 0.0f, 1.0f, 0.0f }));
+	camera.up = glm::cross(camera.right, camera.forward);
+	UpdateImagePlane(camera);
+}
+
+const float PixelConeWidth(const Camera& camera, int32_t imageHeight) noexcept
+{
+	return camera.model == CameraModel::Orthographic ? 2.0f * camera.halfHeight / static_cast<float>(imageHeight) : 0.0f;
+}
+
+const float PixelSpreadAngle(const Camera& camera, int32_t imageHeight) noexcept
+{
+	switch (camera.model)
+	{
+	case CameraModel::Orthographic:
+		return 0.0f;
+	case CameraModel::Equirectangular:
+		return glm::pi<float>() / static_cast<float>(imageHeight);
+	default:
+		// The angle one pixel covers, the image plane is at distance one.
+		return std::atan(2.0f * camera.halfHeight / static_cast<float>(imageHeight));
+	}
+}
+
+void GenerateCameraRays(const Camera& camera, int32_t imageWidth, int32_t imageHeight, const Tile& tile, gsl::span<const glm::vec2> jitter, gsl::span<const glm::vec2> lensSamples, CameraRays& rays)
+{
+	ResizeRays(rays, static_cast<size_t>(tile.width) * static_cast<size_t>(tile.height));
+
+	switch (camera.model)
+	{
+	case CameraModel::Orthographic:
+		GenerateOrthographicRays(camera, imageWidth, imageHeight, tile, jitter, rays);
+		break;
+	case CameraModel::Equirectangular:
+		GenerateEquirectangularRays(camera, imageWidth, imageHeight, tile, jitter, rays);
+		break;
+	case CameraModel::ThinLens:
+		if (!lensSamples.empty() && camera.lensRadius > 0.0f)
+		{
+			for (size_t ray{ 0 }; ray < rays.originX.size(); ++ray)
+			{
+				const glm::vec2 disc = camera.lensRadius * SampleDisc(lensSamples[ray]);
+				const glm::vec3 origin = camera.position + disc.x * camera.right + disc.y * camera.up;
+				rays.originX[ray] = origin.x;
+				rays.originY[ray] = origin.y;
+				rays.originZ[ray] = origin.z;
+			}
+			GeneratePlanarRays(camera, imageWidth, imageHeight, tile, jitter, rays);
+			break;
+		}
+		[[fallthrough]];
+	case CameraModel::Pinhole:
+	default:
+		std::fill(rays.originX.begin(), rays.originX.end(), camera.position.x);
+		std::fill(rays.originY.begin(), rays.originY.end(), camera.position.y);
+		std::fill(rays.originZ.begin(), rays.originZ.end(), camera.position.z);
+		GeneratePlanarRays(camera, imageWidth, imageHeight, tile, jitter, rays);
+		break;
+	}
+}
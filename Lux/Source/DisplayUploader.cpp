@@ -0,0 +1,179 @@
+#include "DisplayUploader.h"
+#include "Profiler.h"
+
+#include <glm/vec3.hpp>
+#include <glm/common.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	constexpr size_t srgbTableSize = 4096;
+
+	const std::array<uint8_t, srgbTableSize> BuildSrgbTable() noexcept
+	{
+		std::array<uint8_t, srgbTableSize> table{};
+		for (size_t i{ 0 }; i < srgbTableSize; ++i)
+		{
+			float linear = static_cast<float>(i) / static_cast<float>(srgbTableSize - 1);
+			float srgb = linear <= 0.0031308f ? 12.92f * linear : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+			table[i] = static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+		}
+		return table;
+	}
+
+	uint8_t LinearToSrgb8(float value) noexcept
+	{
+		static const std::array<uint8_t, srgbTableSize> table = BuildSrgbTable();
+
+		float clamped = std::clamp(value, 0.0f, 1.0f);
+		return table[static_cast<size_t>(clamped * static_cast<float>(srgbTableSize - 1))];
+	}
+}
+
+bool DisplayUploader::Initialize(int32_t width, int32_t height, DisplayFormat format)
+{
+	if (!GLAD_GL_VERSION_4_4)
+	{
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->format = format;
+	bytesPerPixel = format == DisplayFormat::Srgb8 ? 4 * sizeof(uint8_t) : 4 * sizeof(uint16_t);
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format == DisplayFormat::Srgb8 ? GL_SRGB8_ALPHA8 : GL_RGBA16F, width, height);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	const GLsizeiptr bufferSize = static_cast<GLsizeiptr>(width) * height * bytesPerPixel;
+	const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(ringSize, buffers.data());
+	for (uint32_t slot{ 0 }; slot < ringSize; ++slot)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[slot]);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, bufferSize, nullptr, mapFlags);
+		mappedData[slot] = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bufferSize, mapFlags));
+
+		if (!mappedData[slot])
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			Shutdown();
+			return false;
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	return true;
+}
+
+void DisplayUploader::Shutdown()
+{
+	for (uint32_t slot{ 0 }; slot < ringSize; ++slot)
+	{
+		if (fences[slot])
+		{
+			glDeleteSync(fences[slot]);
+			fences[slot] = nullptr;
+		}
+
+		if (mappedData[slot])
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[slot]);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			mappedData[slot] = nullptr;
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	glDeleteBuffers(ringSize, buffers.data());
+	buffers.fill(0);
+
+	glDeleteTextures(1, &texture);
+	texture = 0;
+}
+
+void DisplayUploader::BeginFrame()
+{
+	GLsync& fence = fences[currentSlot];
+	if (!fence)
+	{
+		return;
+	}
+
+	LUX_PROFILE_ZONE("WaitForUploadFence");
+
+	constexpr GLuint64 timeout = 1'000'000'000;
+	while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout) == GL_TIMEOUT_EXPIRED)
+	{
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void DisplayUploader::PackTile(const Framebuffer& framebuffer, const Tile& tile) noexcept
+{
+	uint8_t* destination = mappedData[currentSlot];
+	const size_t rowPitch = static_cast<size_t>(width) * bytesPerPixel;
+
+	for (int32_t y{ tile.y }; y < tile.y + tile.height; ++y)
+	{
+		const glm::vec3* sourceRow = framebuffer.pixels.data() + static_cast<size_t>(y) * framebuffer.width;
+		uint8_t* destinationRow = destination + static_cast<size_t>(y) * rowPitch;
+
+		for (int32_t x{ tile.x }; x < tile.x + tile.width; ++x)
+		{
+			const glm::vec3& color = sourceRow[x];
+			uint8_t* pixel = destinationRow + static_cast<size_t>(x) * bytesPerPixel;
+
+			if (format == DisplayFormat::Srgb8)
+			{
+				pixel[0] = LinearToSrgb8(color.x);
+				pixel[1] = LinearToSrgb8(color.y);
+				pixel[2] = LinearToSrgb8(color.z);
+				pixel[3] = 255;
+			}
+			else
+			{
+				std::array<uint16_t, 4> half
+				{
+					glm::packHalf1x16(color.x),
+					glm::packHalf1x16(color.y),
+					glm::packHalf1x16(color.z),
+					glm::packHalf1x16(1.0f)
+				};
+				std::memcpy(pixel, half.data(), sizeof(half));
+			}
+		}
+	}
+}
+
+void DisplayUploader::EndFrame()
+{
+	LUX_PROFILE_ZONE("UploadTexture");
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[currentSlot]);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, format == DisplayFormat::Srgb8 ? GL_UNSIGNED_BYTE : GL_HALF_FLOAT, nullptr);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	fences[currentSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	currentSlot = (currentSlot + 1) % ringSize;
+}
+
+GLuint DisplayUploader::GetTexture() const noexcept
+{
+	return texture;
+}
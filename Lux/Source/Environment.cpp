@@ -0,0 +1,217 @@
+#include "Environment.h"
+#include "Image.h"
+#include "Profiler.h"
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+	constexpr std::array<char, 4> environmentCacheMagic{ 'L', 'X', 'E', 'N' };
+	constexpr uint32_t environmentCacheVersion = 2;
+
+	struct EnvironmentCacheHeader
+	{
+		std::array<char, 4> magic;
+		uint32_t version;
+		int32_t width;
+		int32_t height;
+		float normalization;
+	};
+
+	const float Luminance(glm::vec3 color) noexcept
+	{
+		return glm::dot(color, glm::vec3{ 0.2126f, 0.7152f, 0.0722f });
+	}
+
+	const float RowSine(const EnvironmentMap& environment, int32_t y) noexcept
+	{
+		return std::sin(glm::pi<float>() * (static_cast<float>(y) + 0.5f) / static_cast<float>(environment.height));
+	}
+
+	const glm::vec2 DirectionToTexcoord(glm::vec3 direction) noexcept
+	{
+		const float u = 0.5f * std::atan2(direction.x, -direction.z) * glm::one_over_pi<float>() + 0.5f;
+		const float v = std::acos(std::clamp(direction.y, -1.0f, 1.0f)) * glm::one_over_pi<float>();
+		return glm::vec2{ u, v };
+	}
+
+	const size_t PixelIndex(const EnvironmentMap& environment, glm::vec2 texcoord, int32_t& y) noexcept
+	{
+		const int32_t x = std::clamp(static_cast<int32_t>(texcoord.x * static_cast<float>(environment.width)), 0, environment.width - 1);
+		y = std::clamp(static_cast<int32_t>(texcoord.y * static_cast<float>(environment.height)), 0, environment.height - 1);
+		return static_cast<size_t>(y) * environment.width + x;
+	}
+
+	// Index of the interval [cdf[i], cdf[i + 1]) holding u and how far into it.
+	const float SampleCdf(const float* cdf, int32_t count, float u, int32_t& index) noexcept
+	{
+		index = std::clamp(static_cast<int32_t>(std::upper_bound(cdf, cdf + count + 1, u) - cdf) - 1, 0, count - 1);
+		const float width = cdf[index + 1] - cdf[index];
+		return width > 0.0f ? std::clamp((u - cdf[index]) / width, 0.0f, 1.0f) : 0.5f;
+	}
+
+	template <typename T>
+	void WriteVector(std::ofstream& file, const std::vector<T>& values)
+	{
+		file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+	}
+
+	template <typename T>
+	void ReadVector(std::ifstream& file, std::vector<T>& values, size_t count)
+	{
+		values.resize(count);
+		file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+	}
+}
+
+const EnvironmentMap MakeEnvironmentMap(int32_t width, int32_t height, std::vector<glm::vec3>&& radiance)
+{
+	LUX_PROFILE_ZONE("MakeEnvironmentMap");
+
+	EnvironmentMap environment{ width, height, std::move(radiance) };
+	environment.marginalCdf.resize(static_cast<size_t>(height) + 1);
+	environment.conditionalCdfs.resize(static_cast<size_t>(height) * (width + 1));
+
+	// Sums in double, a sun next to a dim sky loses the sky in float.
+	std::vector<double> rowSums(height);
+	double total{ 0.0 };
+	for (int32_t y{ 0 }; y < height; ++y)
+	{
+		const float sine = RowSine(environment, y);
+		float* conditional = &environment.conditionalCdfs[static_cast<size_t>(y) * (width + 1)];
+		const glm::vec3* row = &environment.radiance[static_cast<size_t>(y) * width];
+
+		double sum{ 0.0 };
+		for (int32_t x{ 0 }; x < width; ++x)
+		{
+			conditional[x] = static_cast<float>(sum);
+			sum += std::max(Luminance(row[x]), 0.0f) * sine;
+		}
+		for (int32_t x{ 0 }; x < width; ++x)
+		{
+			conditional[x] = sum > 0.0 ? static_cast<float>(conditional[x] / sum) : static_cast<float>(x) / static_cast<float>(width);
+		}
+		conditional[width] = 1.0f;
+
+		rowSums[y] = sum;
+		total += sum;
+	}
+
+	double running{ 0.0 };
+	for (int32_t y{ 0 }; y < height; ++y)
+	{
+		environment.marginalCdf[y] = total > 0.0 ? static_cast<float>(running / total) : static_cast<float>(y) / static_cast<float>(height);
+		running += rowSums[y];
+	}
+	environment.marginalCdf[height] = 1.0f;
+	environment.normalization = total > 0.0 ? static_cast<float>(static_cast<double>(width) * height / total) : 0.0f;
+
+	return environment;
+}
+
+const std::optional<EnvironmentMap> LoadEnvironmentMap(const std::filesystem::path& filePath)
+{
+	const std::optional<Framebuffer> image = filePath.extension() == ".pfm" ? ReadPfm(filePath) : ReadHdr(filePath);
+	if (!image)
+	{
+		return std::nullopt;
+	}
+
+	// Both formats are bottom row first.
+	std::vector<glm::vec3> radiance(image->pixels.size());
+	for (int32_t y{ 0 }; y < image->height; ++y)
+	{
+		const auto row = image->pixels.begin() + static_cast<ptrdiff_t>(image->height - 1 - y) * image->width;
+		std::copy(row, row + image->width, radiance.begin() + static_cast<ptrdiff_t>(y) * image->width);
+	}
+
+	return MakeEnvironmentMap(image->width, image->height, std::move(radiance));
+}
+
+const bool WriteEnvironmentCache(const EnvironmentMap& environment, const CacheKey& key, const std::filesystem::path& filePath)
+{
+	std::ofstream file{ filePath, std::ios::binary };
+	const EnvironmentCacheHeader header{ environmentCacheMagic, environmentCacheVersion, environment.width, environment.height, environment.normalization };
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	WriteCacheKey(file, key);
+	WriteVector(file, environment.radiance);
+	WriteVector(file, environment.marginalCdf);
+	WriteVector(file, environment.conditionalCdfs);
+	return static_cast<bool>(file);
+}
+
+const std::optional<EnvironmentMap> ReadEnvironmentCache(const std::filesystem::path& filePath, const CacheKey& key)
+{
+	LUX_PROFILE_ZONE("ReadEnvironmentCache");
+
+	std::ifstream file{ filePath, std::ios::binary };
+	EnvironmentCacheHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.magic != environmentCacheMagic || header.version != environmentCacheVersion || header.width <= 0 || header.height <= 0 || ReadCacheKey(file) != key)
+	{
+		return std::nullopt;
+	}
+
+	EnvironmentMap environment{ header.width, header.height };
+	environment.normalization = header.normalization;
+	const size_t pixelCount = static_cast<size_t>(header.width) * header.height;
+	ReadVector(file, environment.radiance, pixelCount);
+	ReadVector(file, environment.marginalCdf, static_cast<size_t>(header.height) + 1);
+	ReadVector(file, environment.conditionalCdfs, static_cast<size_t>(header.height) * (header.width + 1));
+
+	if (!file)
+	{
+		return std::nullopt;
+	}
+	return environment;
+}
+
+const glm::vec3 EnvironmentRadiance(const EnvironmentMap& environment, glm::vec3 direction) noexcept
+{
+	int32_t y{ 0 };
+	return environment.radiance[PixelIndex(environment, DirectionToTexcoord(direction), y)];
+}
+
+const EnvironmentSample SampleEnvironment(const EnvironmentMap& environment, glm::vec2 u) noexcept
+{
+	if (environment.normalization == 0.0f)
+	{
+		return EnvironmentSample{ glm::vec3{ 0.0f, 1.0f, 0.0f }, glm::vec3{ 0.0f }, 0.0f };
+	}
+
+	int32_t y{ 0 };
+	const float rowOffset = SampleCdf(environment.marginalCdf.data(), environment.height, u.y, y);
+	int32_t x{ 0 };
+	const float columnOffset = SampleCdf(&environment.conditionalCdfs[static_cast<size_t>(y) * (environment.width + 1)], environment.width, u.x, x);
+
+	const float theta = glm::pi<float>() * (static_cast<float>(y) + rowOffset) / static_cast<float>(environment.height);
+	const float phi = glm::two_pi<float>() * ((static_cast<float>(x) + columnOffset) / static_cast<float>(environment.width) - 0.5f);
+	const float sine = std::sin(theta);
+	const glm::vec3 direction{ sine * std::sin(phi), std::cos(theta), -sine * std::cos(phi) };
+
+	const glm::vec3 radiance = environment.radiance[static_cast<size_t>(y) * environment.width + x];
+	const float weight = std::max(Luminance(radiance), 0.0f) * RowSine(environment, y);
+	const float pdf = sine > 0.0f ? weight * environment.normalization / (2.0f * glm::pi<float>() * glm::pi<float>() * sine) : 0.0f;
+	return EnvironmentSample{ direction, radiance, pdf };
+}
+
+const float EnvironmentPdf(const EnvironmentMap& environment, glm::vec3 direction) noexcept
+{
+	const glm::vec2 texcoord = DirectionToTexcoord(direction);
+	int32_t y{ 0 };
+	const size_t pixel = PixelIndex(environment, texcoord, y);
+	const float sine = std::sin(glm::pi<float>() * texcoord.y);
+	if (sine <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	const float weight = std::max(Luminance(environment.radiance[pixel]), 0.0f) * RowSine(environment, y);
+	return weight * environment.normalization / (2.0f * glm::pi<float>() * glm::pi<float>() * sine);
+}
@@ -0,0 +1,696 @@
+#include "Image.h"
+
+#include <gsl/span>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+
+namespace
+{
+	// Deflate streams pack bits starting at the least significant one.
+	class BitReader
+	{
+	public:
+		BitReader(gsl::span<const uint8_t> data)
+			: data{ data }
+		{
+		}
+
+		const uint32_t Peek(uint32_t count) noexcept
+		{
+			while (bufferedBits < count && position < data.size())
+			{
+				buffer |= static_cast<uint64_t>(data[position++]) << bufferedBits;
+				bufferedBits += 8;
+			}
+			return static_cast<uint32_t>(buffer & ((uint64_t{ 1 } << count) - 1));
+		}
+
+		void Consume(uint32_t count) noexcept
+		{
+			if (count > bufferedBits)
+			{
+				overrun = true;
+				count = bufferedBits;
+			}
+			buffer >>= count;
+			bufferedBits -= count;
+		}
+
+		const uint32_t Read(uint32_t count) noexcept
+		{
+			const uint32_t value = Peek(count);
+			Consume(count);
+			return value;
+		}
+
+		void AlignToByte() noexcept
+		{
+			Consume(bufferedBits % 8);
+		}
+
+		const bool Overrun() const noexcept
+		{
+			return overrun;
+		}
+
+	private:
+		gsl::span<const uint8_t> data;
+		size_t position{ 0 };
+		uint64_t buffer{ 0 };
+		uint32_t bufferedBits{ 0 };
+		bool overrun{ false };
+	};
+
+	// Canonical Huffman code decoded with a single table lookup, indexed by
+	// the next maximum code length bits. Entries hold symbol << 4 | length.
+	struct HuffmanTable
+	{
+		std::vector<uint16_t> entries;
+		uint32_t bits;
+	};
+
+	const bool BuildHuffmanTable(gsl::span<const uint8_t> lengths, HuffmanTable& table)
+	{
+		std::array<uint32_t, 16> lengthCounts{ 0 };
+		for (const uint8_t length : lengths)
+		{
+			++lengthCounts[length];
+		}
+		lengthCounts[0] = 0;
+
+		table.bits = 1;
+		for (uint32_t length{ 1 }; length < 16; ++length)
+		{
+			if (lengthCounts[length] > 0)
+			{
+				table.bits = length;
+			}
+		}
+
+		std::array<uint32_t, 16> nextCode{ 0 };
+		uint32_t code{ 0 };
+		for (uint32_t length{ 1 }; length < 16; ++length)
+		{
+			code = (code + lengthCounts[length - 1]) << 1;
+			nextCode[length] = code;
+			if (lengthCounts[length] > (1u << length))
+			{
+				return false;
+			}
+		}
+
+		table.entries.assign(size_t{ 1 } << table.bits, 0);
+		for (uint32_t symbol{ 0 }; symbol < lengths.size(); ++symbol)
+		{
+			const uint32_t length = lengths[symbol];
+			if (length == 0)
+			{
+				continue;
+			}
+
+			const uint32_t symbolCode = nextCode[length]++;
+			uint32_t reversed{ 0 };
+			for (uint32_t bit{ 0 }; bit < length; ++bit)
+			{
+				reversed |= ((symbolCode >> bit) & 1) << (length - 1 - bit);
+			}
+			for (uint32_t entry{ reversed }; entry < table.entries.size(); entry += 1u << length)
+			{
+				table.entries[entry] = static_cast<uint16_t>(symbol << 4 | length);
+			}
+		}
+		return true;
+	}
+
+	// Returns -1 for codes the table doesn't contain.
+	const int32_t DecodeSymbol(BitReader& reader, const HuffmanTable& table) noexcept
+	{
+		const uint16_t entry = table.entries[reader.Peek(table.bits)];
+		if ((entry & 15) == 0)
+		{
+			return -1;
+		}
+		reader.Consume(entry & 15);
+		return entry >> 4;
+	}
+
+	constexpr std::array<uint16_t, 29> lengthBases{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr std::array<uint8_t, 29> lengthExtraBits{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr std::array<uint16_t, 30> distanceBases{ 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr std::array<uint8_t, 30> distanceExtraBits{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	const bool InflateBlock(BitReader& reader, const HuffmanTable& literals, const HuffmanTable& distances, size_t maxSize, std::vector<uint8_t>& output)
+	{
+		while (!reader.Overrun())
+		{
+			if (output.size() >= maxSize)
+			{
+				return true;
+			}
+
+			const int32_t symbol = DecodeSymbol(reader, literals);
+			if (symbol < 0)
+			{
+				return false;
+			}
+			if (symbol < 256)
+			{
+				output.push_back(static_cast<uint8_t>(symbol));
+				continue;
+			}
+			if (symbol == 256)
+			{
+				return true;
+			}
+
+			const uint32_t lengthCode = static_cast<uint32_t>(symbol) - 257;
+			if (lengthCode >= lengthBases.size())
+			{
+				return false;
+			}
+			const size_t length = lengthBases[lengthCode] + reader.Read(lengthExtraBits[lengthCode]);
+
+			const int32_t distanceCode = DecodeSymbol(reader, distances);
+			if (distanceCode < 0 || distanceCode >= static_cast<int32_t>(distanceBases.size()))
+			{
+				return false;
+			}
+			const size_t distance = distanceBases[distanceCode] + reader.Read(distanceExtraBits[distanceCode]);
+			if (distance > output.size())
+			{
+				return false;
+			}
+
+			// Byte by byte, the copy may overlap what it writes.
+			const size_t start = output.size() - distance;
+			for (size_t i{ 0 }; i < length; ++i)
+			{
+				output.push_back(output[start + i]);
+			}
+		}
+		return false;
+	}
+
+	// RFC 1950 zlib stream holding RFC 1951 deflate blocks. Stops once it
+	// decompressed maxSize bytes, whatever the stream holds beyond them.
+	const bool Inflate(gsl::span<const uint8_t> stream, size_t maxSize, std::vector<uint8_t>& output)
+	{
+		if (stream.size() < 2 || (stream[0] & 15) != 8 || (stream[0] << 8 | stream[1]) % 31 != 0 || (stream[1] & 32) != 0)
+		{
+			return false;
+		}
+
+		BitReader reader{ stream.subspan(2) };
+		HuffmanTable literals{};
+		HuffmanTable distances{};
+
+		bool finalBlock{ false };
+		while (!finalBlock)
+		{
+			finalBlock = reader.Read(1) == 1;
+			const uint32_t blockType = reader.Read(2);
+
+			if (blockType == 0)
+			{
+				reader.AlignToByte();
+				const uint32_t length = reader.Read(16);
+				if ((length ^ 0xffff) != reader.Read(16))
+				{
+					return false;
+				}
+				for (uint32_t i{ 0 }; i < length; ++i)
+				{
+					output.push_back(static_cast<uint8_t>(reader.Read(8)));
+				}
+			}
+			else if (blockType == 1)
+			{
+				std::array<uint8_t, 288> literalLengths{};
+				std::fill(literalLengths.begin(), literalLengths.begin() + 144, uint8_t{ 8 });
+				std::fill(literalLengths.begin() + 144, literalLengths.begin() + 256, uint8_t{ 9 });
+				std::fill(literalLengths.begin() + 256, literalLengths.begin() + 280, uint8_t{ 7 });
+				std::fill(literalLengths.begin() + 280, literalLengths.end(), uint8_t{ 8 });
+				std::array<uint8_t, 30> distanceLengths{};
+				distanceLengths.fill(5);
+
+				if (!BuildHuffmanTable(literalLengths, literals) || !BuildHuffmanTable(distanceLengths, distances) || !InflateBlock(reader, literals, distances, maxSize, output))
+				{
+					return false;
+				}
+			}
+			else if (blockType == 2)
+			{
+				const uint32_t literalCount = reader.Read(5) + 257;
+				const uint32_t distanceCount = reader.Read(5) + 1;
+				const uint32_t codeLengthCount = reader.Read(4) + 4;
+
+				constexpr std::array<uint8_t, 19> codeLengthOrder{ 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+				std::array<uint8_t, 19> codeLengthLengths{};
+				for (uint32_t i{ 0 }; i < codeLengthCount; ++i)
+				{
+					codeLengthLengths[codeLengthOrder[i]] = static_cast<uint8_t>(reader.Read(3));
+				}
+
+				HuffmanTable codeLengths{};
+				if (!BuildHuffmanTable(codeLengthLengths, codeLengths))
+				{
+					return false;
+				}
+
+				// Literal and distance lengths form one sequence, repeats may
+				// cross from one into the other.
+				std::vector<uint8_t> lengths;
+				lengths.reserve(literalCount + distanceCount);
+				while (lengths.size() < literalCount + distanceCount)
+				{
+					const int32_t symbol = DecodeSymbol(reader, codeLengths);
+					if (symbol < 0 || reader.Overrun())
+					{
+						return false;
+					}
+
+					if (symbol < 16)
+					{
+						lengths.push_back(static_cast<uint8_t>(symbol));
+						continue;
+					}
+
+					uint8_t repeated{ 0 };
+					uint32_t repeatCount{ 0 };
+					if (symbol == 16)
+					{
+						if (lengths.empty())
+						{
+							return false;
+						}
+						repeated = lengths.back();
+						repeatCount = 3 + reader.Read(2);
+					}
+					else if (symbol == 17)
+					{
+						repeatCount = 3 + reader.Read(3);
+					}
+					else
+					{
+						repeatCount = 11 + reader.Read(7);
+					}
+					lengths.insert(lengths.end(), repeatCount, repeated);
+				}
+
+				if (lengths.size() != literalCount + distanceCount || lengths[256] == 0)
+				{
+					return false;
+				}
+
+				const gsl::span<const uint8_t> allLengths{ lengths };
+				if (!BuildHuffmanTable(allLengths.first(literalCount), literals) || !BuildHuffmanTable(allLengths.subspan(literalCount), distances) || !InflateBlock(reader, literals, distances, maxSize, output))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return false;
+			}
+
+			if (reader.Overrun())
+			{
+				return false;
+			}
+			if (output.size() >= maxSize)
+			{
+				output.resize(maxSize);
+				return true;
+			}
+		}
+
+		return true;
+	}
+
+	// The bit depths the PNG specification allows for each color type.
+	const bool IsValidBitDepth(uint32_t colorType, uint32_t bitDepth) noexcept
+	{
+		switch (colorType)
+		{
+		case 0:
+			return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+		case 2:
+		case 4:
+		case 6:
+			return bitDepth == 8 || bitDepth == 16;
+		case 3:
+			return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+		default:
+			return false;
+		}
+	}
+
+	const uint32_t ReadBigEndian(const uint8_t* bytes) noexcept
+	{
+		return static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 | static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+	}
+
+	const uint8_t Paeth(uint8_t left, uint8_t up, uint8_t upLeft) noexcept
+	{
+		const int32_t estimate = static_cast<int32_t>(left) + up - upLeft;
+		const int32_t leftDistance = std::abs(estimate - left);
+		const int32_t upDistance = std::abs(estimate - up);
+		const int32_t upLeftDistance = std::abs(estimate - upLeft);
+
+		if (leftDistance <= upDistance && leftDistance <= upLeftDistance)
+		{
+			return left;
+		}
+		return upDistance <= upLeftDistance ? up : upLeft;
+	}
+
+	// Undoes the per row filters in place, rows start with their filter type.
+	const bool Unfilter(std::vector<uint8_t>& data, size_t rowBytes, size_t height, size_t bytesPerPixel)
+	{
+		for (size_t row{ 0 }; row < height; ++row)
+		{
+			uint8_t* current = data.data() + row * (rowBytes + 1) + 1;
+			const uint8_t* previous = row > 0 ? current - (rowBytes + 1) : nullptr;
+			const uint8_t filter = current[-1];
+
+			for (size_t i{ 0 }; i < rowBytes; ++i)
+			{
+				const uint8_t left = i >= bytesPerPixel ? current[i - bytesPerPixel] : 0;
+				const uint8_t up = previous ? previous[i] : 0;
+				const uint8_t upLeft = previous && i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+
+				switch (filter)
+				{
+				case 0:
+					break;
+				case 1:
+					current[i] = static_cast<uint8_t>(current[i] + left);
+					break;
+				case 2:
+					current[i] = static_cast<uint8_t>(current[i] + up);
+					break;
+				case 3:
+					current[i] = static_cast<uint8_t>(current[i] + (left + up) / 2);
+					break;
+				case 4:
+					current[i] = static_cast<uint8_t>(current[i] + Paeth(left, up, upLeft));
+					break;
+				default:
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+bool WritePfm(const std::filesystem::path& filePath, const Framebuffer& framebuffer)
+{
+	std::ofstream file{ filePath, std::ios::binary };
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "PF\n" << framebuffer.width << " " << framebuffer.height << "\n-1.0\n";
+	file.write(reinterpret_cast<const char*>(framebuffer.pixels.data()), static_cast<std::streamsize>(framebuffer.pixels.size() * sizeof(glm::vec3)));
+
+	return static_cast<bool>(file);
+}
+
+const std::optional<Framebuffer> ReadPfm(const std::filesystem::path& filePath)
+{
+	std::ifstream file{ filePath, std::ios::binary };
+	if (!file)
+	{
+		return std::nullopt;
+	}
+
+	std::string magic;
+	int32_t width{ 0 };
+	int32_t height{ 0 };
+	float scale{ 0.0f };
+	file >> magic >> width >> height >> scale;
+	file.get();
+
+	// Only little endian color maps are produced by WritePfm.
+	if (!file || magic != "PF" || width <= 0 || height <= 0 || scale >= 0.0f)
+	{
+		return std::nullopt;
+	}
+
+	Framebuffer framebuffer{ width, height };
+	file.read(reinterpret_cast<char*>(framebuffer.pixels.data()), static_cast<std::streamsize>(framebuffer.pixels.size() * sizeof(glm::vec3)));
+
+	if (!file)
+	{
+		return std::nullopt;
+	}
+
+	return framebuffer;
+}
+
+const std::optional<Framebuffer> ReadHdr(const std::filesystem::path& filePath)
+{
+	std::ifstream file{ filePath, std::ios::binary };
+	std::string line;
+	if (!std::getline(file, line) || (line != "#?RADIANCE" && line != "#?RGBE"))
+	{
+		return std::nullopt;
+	}
+
+	bool rgbe{ false };
+	while (std::getline(file, line) && !line.empty())
+	{
+		rgbe = rgbe || line == "FORMAT=32-bit_rle_rgbe";
+	}
+
+	std::string yAxis;
+	std::string xAxis;
+	int32_t width{ 0 };
+	int32_t height{ 0 };
+	file >> yAxis >> height >> xAxis >> width;
+	file.get();
+	if (!file || !rgbe || yAxis != "-Y" || xAxis != "+X" || width <= 0 || height <= 0)
+	{
+		return std::nullopt;
+	}
+
+	Framebuffer framebuffer{ width, height };
+	std::vector<uint8_t> scanline(4 * static_cast<size_t>(width));
+	const auto readByte = [&file]()
+	{
+		return static_cast<uint8_t>(file.get());
+	};
+
+	for (int32_t y{ 0 }; y < height; ++y)
+	{
+		const std::array<uint8_t, 4> start{ readByte(), readByte(), readByte(), readByte() };
+
+		// New style scanlines store each channel run length encoded, flat
+		// ones store whole pixels.
+		if (width >= 8 && width < 32768 && start[0] == 2 && start[1] == 2 && (start[2] << 8 | start[3]) == width)
+		{
+			for (size_t channel{ 0 }; channel < 4; ++channel)
+			{
+				size_t x{ 0 };
+				while (x < static_cast<size_t>(width) && file)
+				{
+					uint32_t count = readByte();
+					const bool run = count > 128;
+					count = run ? count - 128 : count;
+					if (count == 0 || x + count > static_cast<size_t>(width))
+					{
+						return std::nullopt;
+					}
+
+					const uint8_t value = run ? readByte() : 0;
+					for (uint32_t i{ 0 }; i < count; ++i, ++x)
+					{
+						scanline[4 * x + channel] = run ? value : readByte();
+					}
+				}
+			}
+		}
+		else
+		{
+			std::copy(start.begin(), start.end(), scanline.begin());
+			file.read(reinterpret_cast<char*>(scanline.data() + 4), static_cast<std::streamsize>(scanline.size() - 4));
+		}
+
+		if (!file)
+		{
+			return std::nullopt;
+		}
+
+		glm::vec3* row = &framebuffer.pixels[static_cast<size_t>(height - 1 - y) * width];
+		for (int32_t x{ 0 }; x < width; ++x)
+		{
+			const uint8_t* pixel = &scanline[4 * static_cast<size_t>(x)];
+			const float scale = pixel[3] != 0 ? std::ldexp(1.0f, static_cast<int>(pixel[3]) - 136) : 0.0f;
+			row[x] = glm::vec3{ static_cast<float>(pixel[0]), static_cast<float>(pixel[1]), static_cast<float>(pixel[2]) } * scale;
+		}
+	}
+
+	return framebuffer;
+}
+
+const float RootMeanSquareError(const Framebuffer& a, const Framebuffer& b) noexcept
+{
+	if (a.width != b.width || a.height != b.height)
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+
+	double sum{ 0.0 };
+	for (size_t pixelIndex{ 0 }; pixelIndex < a.pixels.size(); ++pixelIndex)
+	{
+		for (int channel{ 0 }; channel < 3; ++channel)
+		{
+			double difference = std::clamp(a.pixels[pixelIndex][channel], 0.0f, 1.0f) - std::clamp(b.pixels[pixelIndex][channel], 0.0f, 1.0f);
+			sum += std::isnan(difference) ? 1.0 : difference * difference;
+		}
+	}
+
+	return static_cast<float>(std::sqrt(sum / (3.0 * static_cast<double>(a.pixels.size()))));
+}
+
+const std::optional<Rgba8Image> DecodePng(gsl::span<const uint8_t> bytes)
+{
+	constexpr std::array<uint8_t, 8> signature{ 137, 80, 78, 71, 13, 10, 26, 10 };
+	if (bytes.size() < signature.size() || !std::equal(signature.begin(), signature.end(), bytes.begin()))
+	{
+		return std::nullopt;
+	}
+
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	uint32_t bitDepth{ 0 };
+	uint32_t colorType{ 0 };
+	bool interlaced{ false };
+	std::vector<uint8_t> palette;
+	std::vector<uint8_t> paletteAlpha;
+	std::vector<uint8_t> compressed;
+
+	for (size_t position{ signature.size() }; position + 12 <= bytes.size();)
+	{
+		const uint32_t length = ReadBigEndian(&bytes[position]);
+		const std::string type{ reinterpret_cast<const char*>(&bytes[position + 4]), 4 };
+		if (position + 12 + length > bytes.size())
+		{
+			return std::nullopt;
+		}
+		const uint8_t* chunk = &bytes[position + 8];
+
+		if (type == "IHDR" && length >= 13)
+		{
+			width = ReadBigEndian(chunk);
+			height = ReadBigEndian(chunk + 4);
+			bitDepth = chunk[8];
+			colorType = chunk[9];
+			interlaced = chunk[12] != 0;
+		}
+		else if (type == "PLTE")
+		{
+			palette.assign(chunk, chunk + length);
+		}
+		else if (type == "tRNS")
+		{
+			paletteAlpha.assign(chunk, chunk + length);
+		}
+		else if (type == "IDAT")
+		{
+			compressed.insert(compressed.end(), chunk, chunk + length);
+		}
+		else if (type == "IEND")
+		{
+			break;
+		}
+
+		position += 12 + length;
+	}
+
+	constexpr std::array<uint32_t, 7> channelCounts{ 1, 0, 3, 1, 2, 0, 4 };
+	if (width == 0 || height == 0 || width > 1u << 15 || height > 1u << 15 || interlaced || !IsValidBitDepth(colorType, bitDepth) || (colorType == 3 && palette.empty()))
+	{
+		return std::nullopt;
+	}
+
+	const uint32_t channelCount = channelCounts[colorType];
+	const size_t bitsPerPixel = static_cast<size_t>(channelCount) * bitDepth;
+	const size_t rowBytes = (static_cast<size_t>(width) * bitsPerPixel + 7) / 8;
+
+	// Deflate expands at most about a thousandfold, a header claiming more
+	// than that is not worth reserving for.
+	const size_t dataSize = (rowBytes + 1) * height;
+	std::vector<uint8_t> data;
+	data.reserve(std::min(dataSize, 1032 * compressed.size()));
+	if (!Inflate(compressed, dataSize, data) || data.size() < dataSize || !Unfilter(data, rowBytes, height, std::max<size_t>(bitsPerPixel / 8, 1)))
+	{
+		return std::nullopt;
+	}
+
+	Rgba8Image image{ static_cast<int32_t>(width), static_cast<int32_t>(height) };
+	image.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+	const uint32_t maximumSample = (1u << std::min(bitDepth, 8u)) - 1;
+	for (size_t y{ 0 }; y < height; ++y)
+	{
+		const uint8_t* row = data.data() + y * (rowBytes + 1) + 1;
+		for (size_t x{ 0 }; x < width; ++x)
+		{
+			// High byte for 16 bit samples, packed bits below 8.
+			const auto sample = [&](uint32_t channel) -> uint32_t
+			{
+				const size_t bit = (x * channelCount + channel) * bitDepth;
+				if (bitDepth >= 8)
+				{
+					return row[bit / 8];
+				}
+				return (row[bit / 8] >> (8 - bitDepth - bit % 8)) & maximumSample;
+			};
+
+			uint8_t* pixel = &image.pixels[(y * width + x) * 4];
+			if (colorType == 3)
+			{
+				const uint32_t index = sample(0);
+				for (uint32_t channel{ 0 }; channel < 3; ++channel)
+				{
+					pixel[channel] = 3 * index + channel < palette.size() ? palette[3 * index + channel] : 0;
+				}
+				pixel[3] = index < paletteAlpha.size() ? paletteAlpha[index] : 255;
+				continue;
+			}
+
+			const auto scaled = [&](uint32_t value) { return static_cast<uint8_t>(value * 255 / maximumSample); };
+			const bool gray = colorType == 0 || colorType == 4;
+			const bool alpha = colorType == 4 || colorType == 6;
+			for (uint32_t channel{ 0 }; channel < 3; ++channel)
+			{
+				pixel[channel] = scaled(sample(gray ? 0 : channel));
+			}
+			pixel[3] = alpha ? scaled(sample(channelCount - 1)) : 255;
+		}
+	}
+
+	return image;
+}
+
+const std::optional<Rgba8Image> ReadPng(const std::filesystem::path& filePath)
+{
+	std::ifstream file{ filePath, std::ios::binary };
+	if (!file)
+	{
+		return std::nullopt;
+	}
+
+	const std::vector<uint8_t> bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	return DecodePng(bytes);
+}
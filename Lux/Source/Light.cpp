@@ -0,0 +1,67 @@
+#include "Light.h"
+
+#include <algorithm>
+#include <numeric>
+
+const AliasTable BuildAliasTable(gsl::span<const float> weights)
+{
+	AliasTable table{};
+	const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+	if (!(total > 0.0))
+	{
+		return table;
+	}
+
+	const size_t count = weights.size();
+	table.probabilities.resize(count);
+	table.aliases.resize(count);
+	table.pdfs.resize(count);
+
+	std::vector<double> scaled(count);
+	std::vector<uint32_t> small{};
+	std::vector<uint32_t> large{};
+	for (size_t index{ 0 }; index < count; ++index)
+	{
+		table.pdfs[index] = static_cast<float>(weights[index] / total);
+		scaled[index] = weights[index] / total * static_cast<double>(count);
+		(scaled[index] < 1.0 ? small : large).push_back(static_cast<uint32_t>(index));
+	}
+
+	while (!small.empty() && !large.empty())
+	{
+		const uint32_t less = small.back();
+		small.pop_back();
+		const uint32_t more = large.back();
+
+		table.probabilities[less] = static_cast<float>(scaled[less]);
+		table.aliases[less] = more;
+
+		scaled[more] -= 1.0 - scaled[less];
+		if (scaled[more] < 1.0)
+		{
+			large.pop_back();
+			small.push_back(more);
+		}
+	}
+
+	// Whatever is left is one up to rounding.
+	for (const uint32_t index : small)
+	{
+		table.probabilities[index] = 1.0f;
+		table.aliases[index] = index;
+	}
+	for (const uint32_t index : large)
+	{
+		table.probabilities[index] = 1.0f;
+		table.aliases[index] = index;
+	}
+
+	return table;
+}
+
+const uint32_t SampleAliasTable(const AliasTable& table, float u) noexcept
+{
+	const float scaled = u * static_cast<float>(table.probabilities.size());
+	const uint32_t index = std::min(static_cast<uint32_t>(scaled), static_cast<uint32_t>(table.probabilities.size() - 1));
+	return scaled - static_cast<float>(index) < table.probabilities[index] ? index : table.aliases[index];
+}
@@ -0,0 +1,328 @@
+#include "Bvh.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+
+namespace
+{
+	constexpr uint32_t primitivesPerJob = 16384;
+	constexpr uint32_t radixBits = 8;
+	constexpr uint32_t radixSize = 1u << radixBits;
+	constexpr uint32_t leafFlag = 1u << 31;
+
+	using Histogram = std::array<uint32_t, radixSize>;
+
+	void RunJobs(ThreadPool* threadPool, uint32_t jobCount, const ThreadPool::Job& job)
+	{
+		if (threadPool)
+		{
+			threadPool->ParallelFor(jobCount, job);
+			return;
+		}
+
+		for (uint32_t jobIndex{ 0 }; jobIndex < jobCount; ++jobIndex)
+		{
+			job(jobIndex, 0);
+		}
+	}
+
+	const uint32_t JobCount(uint32_t count) noexcept
+	{
+		return (count + primitivesPerJob - 1) / primitivesPerJob;
+	}
+
+	const uint32_t JobEnd(uint32_t jobIndex, uint32_t count) noexcept
+	{
+		return std::min(count, (jobIndex + 1) * primitivesPerJob);
+	}
+
+	// Inserts two zero bits between each of the lowest 10 bits.
+	const uint64_t SpreadBits10(uint64_t value) noexcept
+	{
+		value &= 0x3ff;
+		value = (value | value << 16) & 0x030000ff;
+		value = (value | value << 8) & 0x0300f00f;
+		value = (value | value << 4) & 0x030c30c3;
+		value = (value | value << 2) & 0x09249249;
+		return value;
+	}
+
+	// Inserts two zero bits between each of the lowest 21 bits.
+	const uint64_t SpreadBits21(uint64_t value) noexcept
+	{
+		value &= 0x1fffff;
+		value = (value | value << 32) & 0x001f00000000ffff;
+		value = (value | value << 16) & 0x001f0000ff0000ff;
+		value = (value | value << 8) & 0x100f00f00f00f00f;
+		value = (value | value << 4) & 0x10c30c30c30c30c3;
+		value = (value | value << 2) & 0x1249249249249249;
+		return value;
+	}
+
+	// position is relative to the centroid bounds, in [0, 1].
+	const uint64_t MortonCode(glm::vec3 position, uint32_t mortonBits) noexcept
+	{
+		const uint32_t bitsPerAxis = mortonBits / 3;
+		const float scale = static_cast<float>(1u << bitsPerAxis);
+		const glm::vec3 cell = glm::clamp(position * scale, glm::vec3{ 0.0f }, glm::vec3{ scale - 1.0f });
+		const auto spread = bitsPerAxis == 10 ? SpreadBits10 : SpreadBits21;
+
+		return spread(static_cast<uint64_t>(cell.x)) << 2 | spread(static_cast<uint64_t>(cell.y)) << 1 | spread(static_cast<uint64_t>(cell.z));
+	}
+
+	// Least significant digit first, every pass counts digits per job, turns
+	// the counts into per job offsets and scatters stably.
+	void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, uint32_t keyBits, ThreadPool* threadPool)
+	{
+		const uint32_t count = static_cast<uint32_t>(keys.size());
+		const uint32_t jobCount = JobCount(count);
+
+		std::vector<uint64_t> sortedKeys(count);
+		std::vector<uint32_t> sortedValues(count);
+		std::vector<Histogram> offsets(jobCount);
+
+		for (uint32_t shift{ 0 }; shift < keyBits; shift += radixBits)
+		{
+			RunJobs(threadPool, jobCount, [&](uint32_t jobIndex, uint32_t)
+			{
+				Histogram& histogram = offsets[jobIndex];
+				histogram.fill(0);
+				for (uint32_t i{ jobIndex * primitivesPerJob }; i < JobEnd(jobIndex, count); ++i)
+				{
+					++histogram[(keys[i] >> shift) & (radixSize - 1)];
+				}
+			});
+
+			uint32_t offset{ 0 };
+			bool singleDigit{ false };
+			for (uint32_t digit{ 0 }; digit < radixSize; ++digit)
+			{
+				const uint32_t digitStart = offset;
+				for (Histogram& histogram : offsets)
+				{
+					const uint32_t digitCount = histogram[digit];
+					histogram[digit] = offset;
+					offset += digitCount;
+				}
+				singleDigit |= offset - digitStart == count;
+			}
+
+			// Every key has the same digit, the pass would not move anything.
+			if (singleDigit)
+			{
+				continue;
+			}
+
+			RunJobs(threadPool, jobCount, [&](uint32_t jobIndex, uint32_t)
+			{
+				Histogram& histogram = offsets[jobIndex];
+				for (uint32_t i{ jobIndex * primitivesPerJob }; i < JobEnd(jobIndex, count); ++i)
+				{
+					const uint32_t destination = histogram[(keys[i] >> shift) & (radixSize - 1)]++;
+					sortedKeys[destination] = keys[i];
+					sortedValues[destination] = values[i];
+				}
+			});
+
+			keys.swap(sortedKeys);
+			values.swap(sortedValues);
+		}
+	}
+
+	// Length of the common prefix of the sorted keys at i and j, the index
+	// breaks ties between duplicate keys. -1 when j is outside the keys.
+	const int CommonPrefix(const std::vector<uint64_t>& keys, int64_t i, int64_t j) noexcept
+	{
+		if (j < 0 || j >= static_cast<int64_t>(keys.size()))
+		{
+			return -1;
+		}
+
+		const uint64_t difference = keys[i] ^ keys[j];
+		if (difference == 0)
+		{
+			return 64 + std::countl_zero(static_cast<uint32_t>(i ^ j));
+		}
+		return std::countl_zero(difference);
+	}
+
+	// Finds the key range covered by internal node i and where it splits,
+	// see Karras, "Maximizing Parallelism in the Construction of BVHs,
+	// Octrees, and k-d Trees". Leaves are returned with leafFlag set.
+	const std::array<uint32_t, 2> FindChildren(const std::vector<uint64_t>& keys, int64_t i) noexcept
+	{
+		const int64_t direction = CommonPrefix(keys, i, i + 1) > CommonPrefix(keys, i, i - 1) ? 1 : -1;
+		const int minimumPrefix = CommonPrefix(keys, i, i - direction);
+
+		int64_t maximumLength{ 2 };
+		while (CommonPrefix(keys, i, i + maximumLength * direction) > minimumPrefix)
+		{
+			maximumLength *= 2;
+		}
+
+		int64_t length{ 0 };
+		for (int64_t step = maximumLength / 2; step > 0; step /= 2)
+		{
+			if (CommonPrefix(keys, i, i + (length + step) * direction) > minimumPrefix)
+			{
+				length += step;
+			}
+		}
+
+		const int64_t j = i + length * direction;
+		const int nodePrefix = CommonPrefix(keys, i, j);
+
+		int64_t split{ 0 };
+		int64_t divisor{ 2 };
+		int64_t step{ 0 };
+		do
+		{
+			step = (length + divisor - 1) / divisor;
+			if (CommonPrefix(keys, i, i + (split + step) * direction) > nodePrefix)
+			{
+				split += step;
+			}
+			divisor *= 2;
+		} while (step > 1);
+
+		const int64_t gamma = i + split * direction + std::min<int64_t>(direction, 0);
+		const uint32_t left = static_cast<uint32_t>(gamma) | (std::min(i, j) == gamma ? leafFlag : 0);
+		const uint32_t right = static_cast<uint32_t>(gamma + 1) | (std::max(i, j) == gamma + 1 ? leafFlag : 0);
+		return { left, right };
+	}
+}
+
+const Bvh BuildLinearBvh(gsl::span<const Bounds> primitiveBounds, const BvhBuildSettings& settings)
+{
+	LUX_PROFILE_ZONE("BuildLinearBvh");
+
+	Bvh bvh{};
+	if (primitiveBounds.empty())
+	{
+		return bvh;
+	}
+
+	const uint32_t primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+	const uint32_t jobCount = JobCount(primitiveCount);
+	ThreadPool* threadPool = settings.threadPool;
+
+	std::vector<Bounds> jobCentroidBounds(jobCount);
+	RunJobs(threadPool, jobCount, [&](uint32_t jobIndex, uint32_t)
+	{
+		for (uint32_t i{ jobIndex * primitivesPerJob }; i < JobEnd(jobIndex, primitiveCount); ++i)
+		{
+			Grow(jobCentroidBounds[jobIndex], Centroid(primitiveBounds[i]));
+		}
+	});
+
+	Bounds centroidBounds{};
+	for (const Bounds& bounds : jobCentroidBounds)
+	{
+		Grow(centroidBounds, bounds);
+	}
+	const glm::vec3 extent = centroidBounds.maximum - centroidBounds.minimum;
+	const glm::vec3 inverseExtent = glm::vec3{ 1.0f } / glm::max(extent, glm::vec3{ std::numeric_limits<float>::min() });
+
+	const uint32_t mortonBits = settings.mortonBits > 30 ? 63 : 30;
+	std::vector<uint64_t> mortonCodes(primitiveCount);
+	bvh.primitiveIndices.resize(primitiveCount);
+	RunJobs(threadPool, jobCount, [&](uint32_t jobIndex, uint32_t)
+	{
+		for (uint32_t i{ jobIndex * primitivesPerJob }; i < JobEnd(jobIndex, primitiveCount); ++i)
+		{
+			mortonCodes[i] = MortonCode((Centroid(primitiveBounds[i]) - centroidBounds.minimum) * inverseExtent, mortonBits);
+			bvh.primitiveIndices[i] = i;
+		}
+	});
+
+	RadixSort(mortonCodes, bvh.primitiveIndices, mortonBits, threadPool);
+
+	if (primitiveCount == 1)
+	{
+		bvh.nodes.push_back(BvhNode{ primitiveBounds[0], 0, 1 });
+		bvh.builtSahCost = ComputeSahCost(bvh, settings);
+		return bvh;
+	}
+
+	// Internal node i of the radix tree owns the output slots 2i + 1 and
+	// 2i + 2 for its children, so every node is emitted independently.
+	const uint32_t internalCount = primitiveCount - 1;
+	std::vector<std::array<uint32_t, 2>> children(internalCount);
+	std::vector<uint32_t> internalParents(internalCount, 0);
+	std::vector<uint32_t> leafParents(primitiveCount, 0);
+
+	const uint32_t internalJobCount = JobCount(internalCount);
+	RunJobs(threadPool, internalJobCount, [&](uint32_t jobIndex, uint32_t)
+	{
+		for (uint32_t i{ jobIndex * primitivesPerJob }; i < JobEnd(jobIndex, internalCount); ++i)
+		{
+			children[i] = FindChildren(mortonCodes, i);
+			for (const uint32_t child : children[i])
+			{
+				if (child & leafFlag)
+				{
+					leafParents[child & ~leafFlag] = i;
+				}
+				else
+				{
+					internalParents[child] = i;
+				}
+			}
+		}
+	});
+
+	const auto childBounds = [&](const std::vector<Bounds>& internalBounds, uint32_t child) -> const Bounds&
+	{
+		return child & leafFlag ? primitiveBounds[bvh.primitiveIndices[child & ~leafFlag]] : internalBounds[child];
+	};
+
+	// Walks up from every leaf, the second child to arrive at a node knows
+	// both child bounds and continues to its parent.
+	std::vector<Bounds> internalBounds(internalCount);
+	std::unique_ptr<std::atomic<uint32_t>[]> arrivals = std::make_unique<std::atomic<uint32_t>[]>(internalCount);
+	RunJobs(threadPool, jobCount, [&](uint32_t jobIndex, uint32_t)
+	{
+		for (uint32_t leaf{ jobIndex * primitivesPerJob }; leaf < JobEnd(jobIndex, primitiveCount); ++leaf)
+		{
+			uint32_t node = leafParents[leaf];
+			while (arrivals[node].fetch_add(1, std::memory_order_acq_rel) == 1)
+			{
+				Bounds bounds{};
+				Grow(bounds, childBounds(internalBounds, children[node][0]));
+				Grow(bounds, childBounds(internalBounds, children[node][1]));
+				internalBounds[node] = bounds;
+
+				if (node == 0)
+				{
+					break;
+				}
+				node = internalParents[node];
+			}
+		}
+	});
+
+	bvh.nodes.resize(2 * static_cast<size_t>(primitiveCount) - 1);
+	bvh.nodes[0] = BvhNode{ internalBounds[0], 1, 0 };
+	RunJobs(threadPool, internalJobCount, [&](uint32_t jobIndex, uint32_t)
+	{
+		for (uint32_t i{ jobIndex * primitivesPerJob }; i < JobEnd(jobIndex, internalCount); ++i)
+		{
+			for (uint32_t side{ 0 }; side < 2; ++side)
+			{
+				const uint32_t child = children[i][side];
+				bvh.nodes[2 * static_cast<size_t>(i) + 1 + side] = child & leafFlag
+					? BvhNode{ childBounds(internalBounds, child), child & ~leafFlag, 1 }
+					: BvhNode{ internalBounds[child], 2 * child + 1, 0 };
+			}
+		}
+	});
+
+	bvh.builtSahCost = ComputeSahCost(bvh, settings);
+	return bvh;
+}
@@ -4,30 +4,738 @@
 #include "Light.h"
 #include "Camera.h"
 #include "ResourceManager.h"
+#include "Renderer.h"
+#include "ThreadPool.h"
+#include "DisplayUploader.h"
+#include "Statistics.h"
+#include "Profiler.h"
+#include "ReferenceScene.h"
+#include "Image.h"
+#include "Benchmark.h"
+#include "Sequence.h"
 
 #include <glm/vec3.hpp>
 #include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <gsl/span>
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 
 #include <cstdint>
+#include <cstdio>
+#include <algorithm>
 #include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
 
 constexpr int32_t screenWidth = 512;
 constexpr int32_t screenHeight = 512;
 
-std::array<glm::vec3, screenWidth * screenHeight> image;
-
 void processInput(GLFWwindow* window);
 
-int main()
+struct Options
+{
+	ReferenceSceneID scene{ ReferenceSceneID::GroundAndQuad };
+	// Loaded instead of scene when set.
+	std::filesystem::path gltfPath;
+	bool headless{ false };
+	bool benchmarkBvh{ false };
+	bool benchmarkSamplers{ false };
+	bool leakTest{ false };
+	MeshImportSettings importSettings;
+	std::filesystem::path environmentPath;
+	SamplerSettings sampling;
+	CameraModel cameraModel{ CameraModel::Pinhole };
+	float lensRadius{ 0.1f };
+	float focusDistance{ 10.0f };
+	// Above zero, renders a stereo pair this far apart.
+	float eyeDistance{ 0.0f };
+	// Headless runs render one view per line of this file, or this many
+	// views around the scene camera's target, instead of the scene camera.
+	std::filesystem::path viewsPath;
+	uint32_t turntableViews{ 0 };
+	// Above zero, renders this many frames of the scene's animations.
+	uint32_t sequenceFrames{ 0 };
+	float framesPerSecond{ 24.0f };
+	float shutter{ 0.0f };
+	int32_t width{ screenWidth };
+	int32_t height{ screenHeight };
+	uint32_t frameCount{ 5 };
+	std::filesystem::path outputPath;
+	std::filesystem::path goldenPath;
+	float maxRootMeanSquareError{ 0.01f };
+	// Zero disables the timing gate.
+	double maxFrameMilliseconds{ 0.0 };
+};
+
+static void PrintUsage()
+{
+	std::printf(
+		"Usage: Lux [--scene ground|lantern|spheres] [--gltf scene.gltf] [--headless] [--width N] [--height N] [--frames N]\n"
+		"           [--output image.pfm] [--golden image.pfm] [--max-rmse E] [--max-frame-ms T]\n"
+		"           [--quantize-attributes] [--texture-cache-mb N] [--environment image.hdr]\n"
+		"           [--sampler independent|stratified|sobol|bluenoise] [--samples N]\n"
+		"           [--camera pinhole|thinlens|orthographic|equirectangular] [--lens-radius R]\n"
+		"           [--focus-distance D] [--stereo D] [--views cameras.txt] [--turntable N]\n"
+		"           [--animate N] [--fps F] [--shutter S] [--benchmark-bvh]\n"
+		"           [--benchmark-samplers] [--leak-test]\n"
+		"\n"
+		"Headless runs render the scene without a window and return a non-zero exit code\n"
+		"when the image differs from --golden by more than --max-rmse, or when the median\n"
+		"frame time exceeds --max-frame-ms.\n"
+		"\n"
+		"--quantize-attributes stores imported normals, tangents and texcoords packed.\n"
+		"\n"
+		"--gltf renders the default scene of a glTF file on a ground plane instead of\n"
+		"one of the built-in scenes.\n"
+		"\n"
+		"--texture-cache-mb pages textures from pre-tiled copies in the temporary\n"
+		"directory through a cache of N MiB instead of keeping them in memory.\n"
+		"\n"
+		"--environment lights the scene with an equirectangular .hdr or .pfm image.\n"
+		"Its sampling tables are cached in the temporary directory.\n"
+		"\n"
+		"--sampler picks the sequence the --samples samples of every pixel are drawn\n"
+		"from, independent by default.\n"
+		"\n"
+		"--camera picks the projection. Thin lens cameras focus at --focus-distance\n"
+		"through a lens of --lens-radius, orthographic ones cover the height the field of\n"
+		"view spans at --focus-distance, equirectangular ones the whole sphere.\n"
+		"--stereo renders a left and right eye D apart, over-under with the left eye on\n"
+		"top in headless runs. Equirectangular pairs are omnidirectional stereo.\n"
+		"\n"
+		"--views renders a view for every line 'x y z tx ty tz [vfov]' of a file, a\n"
+		"camera at x y z looking at tx ty tz. --turntable renders N views circling the\n"
+		"point --focus-distance in front of the scene camera instead. Headless runs load\n"
+		"the scene once, render all views together and append the view index to the\n"
+		"--output and --golden file names, as in image_007.pfm.\n"
+		"\n"
+		"--animate renders N frames of the node animations of the scene at --fps\n"
+		"frames per second without a window, starting at time zero. Each frame moves\n"
+		"only the animated objects and is updated while the one before is traced. The\n"
+		"frame index is appended to the --output and --golden file names before the\n"
+		"view index, as in image_012.pfm or image_012_003.pfm. --shutter keeps the\n"
+		"shutter open for the fraction S of every frame, blurring what moves meanwhile.\n"
+		"\n"
+		"--benchmark-bvh compares build and trace time of every BVH build mode, using\n"
+		"--width and --height for the rays and --frames as the number of repetitions.\n"
+		"It returns a non-zero exit code when any hierarchy hits a different number of\n"
+		"rays than the SAH one.\n"
+		"\n"
+		"--benchmark-samplers prints the error of every sampler against a converged\n"
+		"image at 1, 2, 4, ... up to --samples samples per pixel, at least 64.\n"
+		"\n"
+		"--leak-test fires rays through the shared edges of a closed mesh and returns a\n"
+		"non-zero exit code when any slips through the watertight triangle test, as\n"
+		"--benchmark-bvh does after its timings.\n");
+}
+
+// Parses the whole of text, rejecting signs on unsigned types, values out
+// of range and infinite or NaN floats.
+template<typename T>
+static bool ParseNumber(std::string_view text, T& value) noexcept
+{
+	T parsed{};
+	const char* end = text.data() + text.size();
+	const auto [last, error] = std::from_chars(text.data(), end, parsed);
+	if (error != std::errc{} || last != end)
+	{
+		return false;
+	}
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		if (!std::isfinite(parsed))
+		{
+			return false;
+		}
+	}
+	value = parsed;
+	return true;
+}
+
+static const std::optional<Options> ParseOptions(int argc, char** argv)
+{
+	Options options{};
+	options.importSettings.cacheDirectory = std::filesystem::temp_directory_path() / "LuxCache";
+
+	for (int argumentIndex{ 1 }; argumentIndex < argc; ++argumentIndex)
+	{
+		std::string_view argument{ argv[argumentIndex] };
+		const bool hasValue = argumentIndex + 1 < argc;
+
+		if (argument == "--headless")
+		{
+			options.headless = true;
+		}
+		else if (argument == "--quantize-attributes")
+		{
+			options.importSettings.quantizeAttributes = true;
+		}
+		else if (argument == "--texture-cache-mb" && hasValue)
+		{
+			size_t megabytes{ 0 };
+			if (!ParseNumber(argv[++argumentIndex], megabytes) || megabytes > (std::numeric_limits<size_t>::max() >> 20))
+			{
+				return std::nullopt;
+			}
+			options.importSettings.textureCacheBytes = megabytes << 20;
+		}
+		else if (argument == "--environment" && hasValue)
+		{
+			options.environmentPath = argv[++argumentIndex];
+		}
+		else if (argument == "--benchmark-bvh")
+		{
+			options.benchmarkBvh = true;
+		}
+		else if (argument == "--benchmark-samplers")
+		{
+			options.benchmarkSamplers = true;
+		}
+		else if (argument == "--leak-test")
+		{
+			options.leakTest = true;
+		}
+		else if (argument == "--sampler" && hasValue)
+		{
+			auto sampler = ParseSamplerType(argv[++argumentIndex]);
+			if (!sampler)
+			{
+				return std::nullopt;
+			}
+			options.sampling.type = *sampler;
+		}
+		else if (argument == "--camera" && hasValue)
+		{
+			const std::string_view model{ argv[++argumentIndex] };
+			if (model == "pinhole")
+			{
+				options.cameraModel = CameraModel::Pinhole;
+			}
+			else if (model == "thinlens")
+			{
+				options.cameraModel = CameraModel::ThinLens;
+			}
+			else if (model == "orthographic")
+			{
+				options.cameraModel = CameraModel::Orthographic;
+			}
+			else if (model == "equirectangular")
+			{
+				options.cameraModel = CameraModel::Equirectangular;
+			}
+			else
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--lens-radius" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.lensRadius))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--focus-distance" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.focusDistance))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--stereo" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.eyeDistance))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--views" && hasValue)
+		{
+			options.viewsPath = argv[++argumentIndex];
+		}
+		else if (argument == "--turntable" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.turntableViews))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--gltf" && hasValue)
+		{
+			options.gltfPath = argv[++argumentIndex];
+		}
+		else if (argument == "--animate" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.sequenceFrames))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--fps" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.framesPerSecond))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--shutter" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.shutter))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--samples" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.sampling.samplesPerPixel))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--scene" && hasValue)
+		{
+			auto scene = ParseReferenceSceneID(argv[++argumentIndex]);
+			if (!scene)
+			{
+				return std::nullopt;
+			}
+			options.scene = *scene;
+		}
+		else if (argument == "--width" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.width))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--height" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.height))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--frames" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.frameCount))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--output" && hasValue)
+		{
+			options.outputPath = argv[++argumentIndex];
+		}
+		else if (argument == "--golden" && hasValue)
+		{
+			options.goldenPath = argv[++argumentIndex];
+		}
+		else if (argument == "--max-rmse" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.maxRootMeanSquareError))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (argument == "--max-frame-ms" && hasValue)
+		{
+			if (!ParseNumber(argv[++argumentIndex], options.maxFrameMilliseconds))
+			{
+				return std::nullopt;
+			}
+		}
+		else
+		{
+			return std::nullopt;
+		}
+	}
+
+	if (options.width <= 0 || options.height <= 0 || options.frameCount == 0 || options.sampling.samplesPerPixel == 0 || !(options.framesPerSecond > 0.0f) || !(options.shutter >= 0.0f && options.shutter <= 1.0f))
+	{
+		return std::nullopt;
+	}
+
+	return options;
+}
+
+struct CameraPose
+{
+	glm::vec3 position;
+	glm::vec3 lookat;
+	float verticalFov;
+};
+
+static const CameraPose ReferencePose(const ReferenceScene& reference)
+{
+	return CameraPose{ reference.cameraPosition, reference.cameraPosition + reference.cameraDirection, reference.verticalFov };
+}
+
+static const Camera MakeCamera(const Options& options, const CameraPose& pose, float aspect)
+{
+	switch (options.cameraModel)
+	{
+	case CameraModel::ThinLens:
+		return MakeThinLensCamera(pose.position, pose.lookat, pose.verticalFov, aspect, options.lensRadius, options.focusDistance);
+	case CameraModel::Orthographic:
+	{
+		const float viewHeight = 2.0f * options.focusDistance * std::tan(0.5f * glm::radians(pose.verticalFov));
+		return MakeOrthographicCamera(pose.position, pose.lookat, viewHeight, aspect);
+	}
+	case CameraModel::Equirectangular:
+		return MakeEquirectangularCamera(pose.position, pose.lookat);
+	case CameraModel::Pinhole:
+	default:
+		return Camera{ pose.position, pose.lookat, pose.verticalFov, aspect };
+	}
+}
+
+// Skips blank lines and lines starting with #. Views without a field of view
+// use the one of reference.
+static const std::optional<std::vector<CameraPose>> ReadCameraPoses(const std::filesystem::path& filePath, const CameraPose& reference)
+{
+	std::ifstream file{ filePath };
+	if (!file)
+	{
+		return std::nullopt;
+	}
+
+	std::vector<CameraPose> poses{};
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields{ line };
+		char first{};
+		if (!(fields >> first) || first == '#')
+		{
+			continue;
+		}
+		fields.unget();
+
+		CameraPose pose{ reference };
+		if (!(fields >> pose.position.x >> pose.position.y >> pose.position.z >> pose.lookat.x >> pose.lookat.y >> pose.lookat.z))
+		{
+			return std::nullopt;
+		}
+		// The field of view is optional, in degrees. Anything else on the line
+		// fails the file rather than being ignored.
+		if (!(fields >> std::ws).eof())
+		{
+			if (!(fields >> pose.verticalFov) || !(pose.verticalFov > 0.0f && pose.verticalFov < 180.0f) || !(fields >> std::ws).eof())
+			{
+				return std::nullopt;
+			}
+		}
+		poses.push_back(pose);
+	}
+	return poses;
+}
+
+// Evenly spaced around the vertical axis through pivot, the first view is
+// reference itself.
+static const std::vector<CameraPose> MakeTurntablePoses(const CameraPose& reference, glm::vec3 pivot, uint32_t viewCount)
+{
+	const glm::vec3 offset = reference.position - pivot;
+	std::vector<CameraPose> poses{};
+	for (uint32_t view{ 0 }; view < viewCount; ++view)
+	{
+		const float angle = glm::two_pi<float>() * static_cast<float>(view) / static_cast<float>(viewCount);
+		const float cosine = std::cos(angle);
+		const float sine = std::sin(angle);
+		const glm::vec3 rotated{ cosine * offset.x + sine * offset.z, offset.y, cosine * offset.z - sine * offset.x };
+		poses.push_back(CameraPose{ pivot + rotated, pivot, reference.verticalFov });
+	}
+	return poses;
+}
+
+// image.pfm becomes image_007.pfm for the eighth of several views.
+static const std::filesystem::path ViewPath(const std::filesystem::path& filePath, size_t view, size_t viewCount)
+{
+	if (viewCount == 1)
+	{
+		return filePath;
+	}
+	char index[16];
+	std::snprintf(index, sizeof(index), "_%03zu", view);
+	std::filesystem::path viewPath{ filePath };
+	viewPath.replace_filename(filePath.stem().string() + index + filePath.extension().string());
+	return viewPath;
+}
+
+// Views on top of each other, the first one at the top.
+static const Framebuffer StackViews(gsl::span<const View> views)
+{
+	Framebuffer stacked{ views.front().framebuffer.width, views.front().framebuffer.height * static_cast<int32_t>(views.size()) };
+	auto destination = stacked.pixels.begin();
+	for (auto view = views.rbegin(); view != views.rend(); ++view)
+	{
+		destination = std::copy(view->framebuffer.pixels.begin(), view->framebuffer.pixels.end(), destination);
+	}
+	return stacked;
+}
+
+static const ReferenceScene LoadScene(const Options& options, ResourceManager& resourceManager)
+{
+	ReferenceScene reference = options.gltfPath.empty() ? LoadReferenceScene(options.scene, resourceManager) : LoadGltfScene(options.gltfPath, resourceManager);
+	if (!options.environmentPath.empty())
+	{
+		reference.scene.environment = resourceManager.LoadEnvironment(options.environmentPath);
+	}
+	return reference;
+}
+
+static const std::optional<std::vector<CameraPose>> MakeCameraPoses(const Options& options, const ReferenceScene& reference)
+{
+	const CameraPose referencePose = ReferencePose(reference);
+	if (!options.viewsPath.empty())
+	{
+		std::optional<std::vector<CameraPose>> poses = ReadCameraPoses(options.viewsPath, referencePose);
+		if (!poses || poses->empty())
+		{
+			std::printf("Failed to read views from %s\n", options.viewsPath.string().c_str());
+			return std::nullopt;
+		}
+		return poses;
+	}
+	if (options.turntableViews > 0)
+	{
+		const glm::vec3 pivot = reference.cameraPosition + options.focusDistance * glm::normalize(reference.cameraDirection);
+		return MakeTurntablePoses(referencePose, pivot, options.turntableViews);
+	}
+	return std::vector<CameraPose>{ referencePose };
+}
+
+// Stereo runs render both eyes of every pose, adjacent in views.
+static const std::vector<View> MakeViews(const Options& options, gsl::span<const CameraPose> poses)
+{
+	const float aspect = static_cast<float>(options.width) / static_cast<float>(options.height);
+	std::vector<View> views{};
+	for (const CameraPose& pose : poses)
+	{
+		const Camera camera = MakeCamera(options, pose, aspect);
+		if (options.eyeDistance > 0.0f)
+		{
+			for (const Camera& eye : MakeStereoPair(camera, options.eyeDistance))
+			{
+				views.push_back(View{ eye, Framebuffer{ options.width, options.height } });
+			}
+		}
+		else
+		{
+			views.push_back(View{ camera, Framebuffer{ options.width, options.height } });
+		}
+	}
+	return views;
+}
+
+// Writes the image of every pose to outputPath and compares it against
+// goldenPath, with the pose index appended when there are several. Returns
+// false when anything failed or drifted.
+static const bool CheckViews(const Options& options, const std::vector<View>& views, size_t poseCount, const std::filesystem::path& outputPath, const std::filesystem::path& goldenPath)
+{
+	bool passed{ true };
+	const size_t eyeCount = views.size() / poseCount;
+	for (size_t pose{ 0 }; pose < poseCount; ++pose)
+	{
+		const gsl::span<const View> eyes{ views.data() + pose * eyeCount, eyeCount };
+		const Framebuffer framebuffer = eyeCount == 1 ? eyes.front().framebuffer : StackViews(eyes);
+
+		const std::filesystem::path poseOutputPath = ViewPath(outputPath, pose, poseCount);
+		if (!outputPath.empty() && !WritePfm(poseOutputPath, framebuffer))
+		{
+			std::printf("Failed to write %s\n", poseOutputPath.string().c_str());
+			passed = false;
+		}
+
+		if (goldenPath.empty())
+		{
+			continue;
+		}
+
+		const std::filesystem::path poseGoldenPath = ViewPath(goldenPath, pose, poseCount);
+		const std::optional<Framebuffer> golden = ReadPfm(poseGoldenPath);
+		if (!golden)
+		{
+			std::printf("Failed to read golden image %s\n", poseGoldenPath.string().c_str());
+			passed = false;
+			continue;
+		}
+
+		const float error = RootMeanSquareError(framebuffer, *golden);
+		std::printf("RMSE against golden image: %.6f (max %.6f)\n", error, options.maxRootMeanSquareError);
+		if (!(error <= options.maxRootMeanSquareError))
+		{
+			std::printf("Image drifted from %s\n", poseGoldenPath.string().c_str());
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+static int RunHeadless(const Options& options)
+{
+	ResourceManager resourceManager{ options.importSettings };
+	ReferenceScene reference = LoadScene(options, resourceManager);
+
+	const std::optional<std::vector<CameraPose>> poses = MakeCameraPoses(options, reference);
+	if (!poses)
+	{
+		return 1;
+	}
+	std::vector<View> views = MakeViews(options, *poses);
+
+	ThreadPool threadPool;
+
+#if LUX_ENABLE_STATISTICS
+	RayStatistics statisticsTotals{};
+	PixelStatistics statisticsMaximum{};
+#endif
+
+	std::vector<double> frameMilliseconds{};
+	for (uint32_t frameIndex{ 0 }; frameIndex < options.frameCount; ++frameIndex)
+	{
+		LUX_PROFILE_ZONE("Frame");
+
+		auto frameStart = std::chrono::steady_clock::now();
+		RenderViews(reference.scene, views, threadPool, options.sampling);
+		frameMilliseconds.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+
+#if LUX_ENABLE_STATISTICS
+		for (const View& view : views)
+		{
+			AccumulateStatistics(view.framebuffer, statisticsTotals, statisticsMaximum);
+		}
+#endif
+	}
+
+	std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+	const double medianMilliseconds = frameMilliseconds[frameMilliseconds.size() / 2];
+	std::printf("Frame time: %.3f ms median, %.3f ms min over %u frames at %dx%d\n", medianMilliseconds, frameMilliseconds.front(), options.frameCount, options.width, options.height);
+	if (poses->size() > 1)
+	{
+		std::printf("Views:      %zu per frame, %.3f ms per view median\n", poses->size(), medianMilliseconds / static_cast<double>(poses->size()));
+	}
+
+	if (const std::optional<TextureCacheReport> report = resourceManager.GetTextureCacheReport())
+	{
+		PrintTextureCacheReport(*report);
+	}
+
+#if LUX_ENABLE_STATISTICS
+	double renderSeconds{ 0.0 };
+	for (double milliseconds : frameMilliseconds)
+	{
+		renderSeconds += milliseconds * 1e-3;
+	}
+	PrintStatistics(statisticsTotals, renderSeconds, options.frameCount);
+#endif
+
+#if LUX_ENABLE_PROFILING
+	Profiler::Get().WriteChromeTrace("Lux.trace.json");
+#endif
+
+	int result = CheckViews(options, views, poses->size(), options.outputPath, options.goldenPath) ? 0 : 1;
+
+	if (options.maxFrameMilliseconds > 0.0 && medianMilliseconds > options.maxFrameMilliseconds)
+	{
+		std::printf("Frame time regressed past %.3f ms\n", options.maxFrameMilliseconds);
+		result = 1;
+	}
+
+	return result;
+}
+
+static int RunSequence(const Options& options)
+{
+	ResourceManager resourceManager{ options.importSettings };
+	ReferenceScene reference = LoadScene(options, resourceManager);
+	if (reference.sceneGraph.animations.empty())
+	{
+		std::printf("The scene has no node animations, all frames will be the same\n");
+	}
+
+	const std::optional<std::vector<CameraPose>> poses = MakeCameraPoses(options, reference);
+	if (!poses)
+	{
+		return 1;
+	}
+	std::vector<View> views = MakeViews(options, *poses);
+
+	ThreadPool threadPool;
+	const SequenceSettings settings{ options.sequenceFrames, options.framesPerSecond, 0.0f, options.shutter, options.sampling };
+
+#if LUX_ENABLE_STATISTICS
+	RayStatistics statisticsTotals{};
+	PixelStatistics statisticsMaximum{};
+#endif
+
+	int result{ 0 };
+	double renderSeconds{ 0.0 };
+	uint32_t rebuildCount{ 0 };
+	const auto sequenceStart = std::chrono::steady_clock::now();
+	RenderSequence(reference.sceneGraph, reference.scene, views, threadPool, settings, [&](const SequenceFrame& frame, const std::vector<View>& frameViews)
+	{
+		std::printf("Frame %u at %.3f s: %zu objects moved%s, update %.3f ms, render %.3f ms\n", frame.index, frame.time, frame.movedObjects, frame.rebuilt ? " (rebuilt)" : "", frame.updateMilliseconds, frame.renderMilliseconds);
+		renderSeconds += frame.renderMilliseconds * 1e-3;
+		rebuildCount += frame.rebuilt ? 1 : 0;
+
+#if LUX_ENABLE_STATISTICS
+		for (const View& view : frameViews)
+		{
+			AccumulateStatistics(view.framebuffer, statisticsTotals, statisticsMaximum);
+		}
+#endif
+
+		const std::filesystem::path outputPath = options.outputPath.empty() ? options.outputPath : ViewPath(options.outputPath, frame.index, options.sequenceFrames);
+		const std::filesystem::path goldenPath = options.goldenPath.empty() ? options.goldenPath : ViewPath(options.goldenPath, frame.index, options.sequenceFrames);
+		if (!CheckViews(options, frameViews, poses->size(), outputPath, goldenPath))
+		{
+			result = 1;
+		}
+	});
+	const double sequenceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sequenceStart).count();
+
+	std::printf("Sequence:   %u frames in %.3f s, %.3f s tracing, %u rebuilds\n", options.sequenceFrames, sequenceSeconds, renderSeconds, rebuildCount);
+
+	if (const std::optional<TextureCacheReport> report = resourceManager.GetTextureCacheReport())
+	{
+		PrintTextureCacheReport(*report);
+	}
+
+#if LUX_ENABLE_STATISTICS
+	PrintStatistics(statisticsTotals, renderSeconds, options.sequenceFrames);
+#endif
+
+#if LUX_ENABLE_PROFILING
+	Profiler::Get().WriteChromeTrace("Lux.trace.json");
+#endif
+
+	return result;
+}
+
+static int RunInteractive(const Options& options)
 {
 	if (!glfwInit())
 		return 1;
 
-	auto window = glfwCreateWindow(screenWidth, screenHeight, "Lux", NULL, NULL);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	auto window = glfwCreateWindow(options.width, options.height, "Lux", NULL, NULL);
 
 	if (!window)
 	{
@@ -45,14 +753,16 @@ int main()
 	int framebufferWidth, framebufferHeight;
 	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
-	unsigned int texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
+	DisplayUploader displayUploader;
+	if (!displayUploader.Initialize(framebufferWidth, framebufferHeight, DisplayFormat::Srgb8))
+	{
+		glfwTerminate();
+		return 1;
+	}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_CLAMP_TO_EDGE, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_CLAMP_TO_EDGE, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	unsigned int vertexArray;
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
 
 	const char* vertexShaderSource = R"(#version 400
 
@@ -95,62 +805,30 @@ void main()
 
 	glUseProgram(shaderProgram);
 
-	Mesh groundPlane;
-	groundPlane.posistions.emplace_back(500.0f, -1.0f, 500.0f);
-	groundPlane.posistions.emplace_back(500.0f, -1.0f,-500.0f);
-	groundPlane.posistions.emplace_back(-500.0f,-1.0f, 500.0f);
-	groundPlane.posistions.emplace_back(500.0f, -1.0f,-500.0f);
-	groundPlane.posistions.emplace_back(-500.0f,-1.0f, -500.0f);
-	groundPlane.posistions.emplace_back(-500.0f,-1.0f, 500.0f);
-
-	Mesh plane;
-	plane.posistions.emplace_back(1.0f,  1.0f, 0.0f);
-	plane.posistions.emplace_back(1.0f,  -1.0f, 0.0f);
-	plane.posistions.emplace_back(-1.0f, 1.0f, 0.0f);
-	plane.posistions.emplace_back(1.0f,  -1.0f, 0.0f);
-	plane.posistions.emplace_back(-1.0f, -1.0f, 0.0f);
-	plane.posistions.emplace_back(-1.0f, 1.0f, 0.0f);
-
-	ResourceManager resourceManager;
-	resourceManager.ImportFromGltf(R"(D:\GameDev\Projects\Cpp\Lux\Assets\Models\Lantern\Lantern.gltf)");
-
-	Object ground
-	{
-		&groundPlane,
-		new Material{Color::white, 0.0f}
-	};
-
-	const Mesh& mesh = resourceManager.GetMeshByIndex(0);
-
-	Object object1
-	{
-		&plane,
-		new Material{Color::red, 0.0f}
-	};
-
-	PointLight light1
-	{
-		glm::vec3{0.0f, 0.0f, -1.0f},
-		Color::white * 10.f
-	};
-
-	PointLight light2
-	{
-		glm::vec3{25.0f, 5.0f, 0.0f},
-		Color::white * 1000.f
-	};
-
-	Scene scene;
-
-	scene.objects.push_back(ground);
-	scene.objects.push_back(object1);
-	scene.lights.push_back(light1);
-
-	glm::vec3 lookDir{ 0.0f, 0.0f, 1.0f };
-	Camera camera{glm::vec3{0.0f, 0.0f, -20.0f}, glm::vec3{0.0f, 0.0f, 0.0f}, 90 , static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight) };
+	ResourceManager resourceManager{ options.importSettings };
+	ReferenceScene reference = LoadScene(options, resourceManager);
+	const Scene& scene = reference.scene;
+
+	Framebuffer framebuffer{ framebufferWidth, framebufferHeight };
+	const std::vector<Tile> tiles = MakeTiles(framebufferWidth, framebufferHeight);
+	ThreadPool threadPool;
+	std::vector<TileScratch> scratch(threadPool.WorkerCount());
+
+	double renderSeconds{ 0.0 };
+	uint64_t frameCount{ 0 };
+#if LUX_ENABLE_STATISTICS
+	RayStatistics statisticsTotals{};
+	PixelStatistics statisticsMaximum{};
+	DebugView debugView{ DebugView::Shaded };
+#endif
+
+	glm::vec3 lookDir = reference.cameraDirection;
+	Camera camera = MakeCamera(options, ReferencePose(reference), static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight));
 	bool pressedOnce = false;	
 	while (!glfwWindowShouldClose(window))
 	{
+		LUX_PROFILE_ZONE("Frame");
+
 		glfwPollEvents();
 
 		if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -174,34 +852,88 @@ void main()
 		{
 			pressedOnce = false;
 		}
-
-
-		camera = Camera{ camera.position, camera.position + lookDir, 90, static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight) };
-
-		for (int y{ 0 }; y < framebufferHeight; ++y)
+#if LUX_ENABLE_STATISTICS
+		for (int key{ GLFW_KEY_F1 }; key <= GLFW_KEY_F6; ++key)
 		{
-			for (int x{ 0 }; x < framebufferWidth; ++x)
-			{
-				auto pixelIndex = x + framebufferWidth * y;
+			if (glfwGetKey(window, key) == GLFW_PRESS)
+				debugView = static_cast<DebugView>(key - GLFW_KEY_F1);
+		}
+#endif
 
-				float u = static_cast<float>(x) / static_cast<float>(framebufferWidth);
-				float v = static_cast<float>(y) / static_cast<float>(framebufferHeight);
 
-				glm::vec3 screenPoint = camera.lower_left_corner + u * camera.horizontal + v * camera.vertical;
+		AimCamera(camera, camera.position, camera.position + lookDir);
 
-				Ray ray{ camera.position, glm::normalize(screenPoint - camera.position) };
+		displayUploader.BeginFrame();
 
-				image[pixelIndex] = Trace(scene, ray);
-			}
-		}
+		auto frameStart = std::chrono::steady_clock::now();
+		threadPool.ParallelFor(static_cast<uint32_t>(tiles.size()), [&](uint32_t tileIndex, uint32_t workerIndex)
+		{
+			RenderTile(scene, camera, tiles[tileIndex], framebuffer, scratch[workerIndex], options.sampling);
+#if LUX_ENABLE_STATISTICS
+			RenderDebugView(debugView, statisticsMaximum, tiles[tileIndex], framebuffer);
+#endif
+			displayUploader.PackTile(framebuffer, tiles[tileIndex]);
+		});
+		renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - frameStart).count();
+		++frameCount;
+
+#if LUX_ENABLE_STATISTICS
+		AccumulateStatistics(framebuffer, statisticsTotals, statisticsMaximum);
+#endif
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, framebufferWidth, framebufferHeight, 0, GL_RGB, GL_FLOAT, image.data());
+		displayUploader.EndFrame();
 
 		glDrawArrays(GL_TRIANGLES, 0, 3);
 
 		glfwSwapBuffers(window);
 	}
 
+#if LUX_ENABLE_PROFILING
+	Profiler::Get().WriteChromeTrace("Lux.trace.json");
+#endif
+
+#if LUX_ENABLE_STATISTICS
+	PrintStatistics(statisticsTotals, renderSeconds, frameCount);
+#endif
+
+	displayUploader.Shutdown();
+	glDeleteVertexArrays(1, &vertexArray);
+
 	glfwTerminate();
 	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	LUX_PROFILE_THREAD_NAME("Main");
+
+	const std::optional<Options> options = ParseOptions(argc, argv);
+	if (!options)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (options->benchmarkBvh)
+	{
+		return RunBvhBenchmark(options->width, options->height, options->frameCount) ? 0 : 1;
+	}
+
+	if (options->leakTest)
+	{
+		return RunLeakTest() ? 0 : 1;
+	}
+
+	if (options->benchmarkSamplers)
+	{
+		RunSamplerBenchmark(options->width, options->height, std::max(options->sampling.samplesPerPixel, 64u));
+		return 0;
+	}
+
+	if (options->sequenceFrames > 0)
+	{
+		return RunSequence(*options);
+	}
+
+	return options->headless ? RunHeadless(*options) : RunInteractive(*options);
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "Material.h"
+
+#include <algorithm>
+
+namespace
+{
+	const TextureID AddTexture(MaterialTable& table, const Texture* texture)
+	{
+		if (!texture)
+		{
+			return noTexture;
+		}
+
+		const auto it = std::find(table.textures.begin(), table.textures.end(), texture);
+		if (it != table.textures.end())
+		{
+			return static_cast<TextureID>(it - table.textures.begin());
+		}
+
+		if (table.textures.size() >= noTexture)
+		{
+			return noTexture;
+		}
+
+		table.textures.push_back(texture);
+		return static_cast<TextureID>(table.textures.size() - 1);
+	}
+}
+
+const MaterialID AddMaterial(MaterialTable& table, const Material& material)
+{
+	const auto it = std::find(table.sources.begin(), table.sources.end(), &material);
+	if (it != table.sources.end())
+	{
+		return static_cast<MaterialID>(it - table.sources.begin());
+	}
+
+	uint32_t flags{ 0 };
+	if (material.emissiveColor != glm::vec3{ 0.0f })
+	{
+		flags |= materialEmissive;
+	}
+	if (material.alphaMode != AlphaMode::Opaque)
+	{
+		flags |= materialAlphaTested;
+	}
+	if (material.doubleSided)
+	{
+		flags |= materialDoubleSided;
+	}
+
+	table.shading.push_back(MaterialShading
+	{
+		material.albedoColor,
+		material.metalicness,
+		material.roughness,
+		flags,
+		AddTexture(table, material.baseColorTexture),
+		AddTexture(table, material.metallicRoughnessTexture),
+		AddTexture(table, material.normalTexture),
+		AddTexture(table, material.emissiveTexture)
+	});
+
+	table.extras.push_back(MaterialExtras
+	{
+		material.emissiveColor,
+		material.normalScale,
+		material.occlusionStrength,
+		material.alpha,
+		material.alphaCutoff,
+		AddTexture(table, material.occlusionTexture),
+		material.alphaMode
+	});
+
+	table.sources.push_back(&material);
+	return static_cast<MaterialID>(table.shading.size() - 1);
+}
@@ -0,0 +1,389 @@
+#include "Mesh.h"
+
+#include "Profiler.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+
+namespace
+{
+	const std::vector<Bounds> ComputeTriangleBounds(const Mesh& mesh)
+	{
+		std::vector<Bounds> triangleBounds(mesh.posistions.size() / 3);
+		for (size_t triangleIndex{ 0 }; triangleIndex < triangleBounds.size(); ++triangleIndex)
+		{
+			Bounds& bounds = triangleBounds[triangleIndex];
+			Grow(bounds, mesh.posistions[3 * triangleIndex]);
+			Grow(bounds, mesh.posistions[3 * triangleIndex + 1]);
+			Grow(bounds, mesh.posistions[3 * triangleIndex + 2]);
+		}
+		return triangleBounds;
+	}
+
+	// Unit vector to the square [-1, 1]^2, the upper hemisphere maps to the
+	// inner diamond and the lower one is folded over the corners.
+	const glm::vec2 OctahedralEncode(glm::vec3 direction) noexcept
+	{
+		direction /= std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		const glm::vec2 point{ direction.x, direction.y };
+		if (direction.z >= 0.0f)
+		{
+			return point;
+		}
+		return glm::vec2
+		{
+			(1.0f - std::abs(point.y)) * (point.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(point.x)) * (point.y >= 0.0f ? 1.0f : -1.0f)
+		};
+	}
+
+	const glm::vec3 OctahedralDecode(glm::vec2 point) noexcept
+	{
+		glm::vec3 direction{ point.x, point.y, 1.0f - std::abs(point.x) - std::abs(point.y) };
+		if (direction.z < 0.0f)
+		{
+			direction.x = (1.0f - std::abs(point.y)) * (point.x >= 0.0f ? 1.0f : -1.0f);
+			direction.y = (1.0f - std::abs(point.x)) * (point.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return glm::normalize(direction);
+	}
+
+	const uint32_t QuantizeSnorm(float value, uint32_t bits) noexcept
+	{
+		const float scale = static_cast<float>((1u << (bits - 1)) - 1);
+		const int32_t quantized = static_cast<int32_t>(std::round(std::clamp(value, -1.0f, 1.0f) * scale));
+		return static_cast<uint32_t>(quantized) & ((1u << bits) - 1);
+	}
+
+	const float DequantizeSnorm(uint32_t value, uint32_t bits) noexcept
+	{
+		const int32_t quantized = static_cast<int32_t>(value << (32 - bits)) >> (32 - bits);
+		return std::max(static_cast<float>(quantized) / static_cast<float>((1u << (bits - 1)) - 1), -1.0f);
+	}
+
+	// Quantized snorms stop at -(2^(bits-1) - 1), so the lowest value of the
+	// first component never comes out of a direction and marks a zero one,
+	// which has no octahedral point. Both layouts put it at bit 15.
+	constexpr uint32_t packedZeroDirection = 0x8000;
+
+	// Zero, and anything else that can not be normalized, would divide to
+	// NaN in OctahedralEncode.
+	const bool IsEncodable(glm::vec3 direction) noexcept
+	{
+		return std::isnormal(std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z));
+	}
+
+	const uint32_t PackNormal(glm::vec3 normal) noexcept
+	{
+		if (!IsEncodable(normal))
+		{
+			return packedZeroDirection;
+		}
+		const glm::vec2 point = OctahedralEncode(normal);
+		return QuantizeSnorm(point.x, 16) | QuantizeSnorm(point.y, 16) << 16;
+	}
+
+	const glm::vec3 UnpackNormal(uint32_t packed) noexcept
+	{
+		if (packed == packedZeroDirection)
+		{
+			return glm::vec3{ 0.0f };
+		}
+		return OctahedralDecode(glm::vec2{ DequantizeSnorm(packed & 0xffff, 16), DequantizeSnorm(packed >> 16, 16) });
+	}
+
+	const uint32_t PackTangent(glm::vec4 tangent) noexcept
+	{
+		const uint32_t sign = tangent.w < 0.0f ? 1u : 0u;
+		if (!IsEncodable(glm::vec3{ tangent }))
+		{
+			return sign | packedZeroDirection;
+		}
+		const glm::vec2 point = OctahedralEncode(glm::vec3{ tangent });
+		return sign | QuantizeSnorm(point.x, 15) << 1 | QuantizeSnorm(point.y, 16) << 16;
+	}
+
+	const glm::vec4 UnpackTangent(uint32_t packed) noexcept
+	{
+		const float sign = packed & 1 ? -1.0f : 1.0f;
+		if ((packed & ~1u) == packedZeroDirection)
+		{
+			return glm::vec4{ 0.0f, 0.0f, 0.0f, sign };
+		}
+		const glm::vec3 tangent = OctahedralDecode(glm::vec2{ DequantizeSnorm((packed >> 1) & 0x7fff, 15), DequantizeSnorm(packed >> 16, 16) });
+		return glm::vec4{ tangent, sign };
+	}
+
+	// Rounds to nearest even, overflows to infinity.
+	const uint32_t FloatToHalf(float value) noexcept
+	{
+		const uint32_t bits = std::bit_cast<uint32_t>(value);
+		const uint32_t sign = (bits >> 16) & 0x8000;
+		const uint32_t magnitude = bits & 0x7fffffff;
+
+		if (magnitude > 0x7f800000)
+		{
+			return sign | 0x7e00;
+		}
+		if (magnitude >= 0x477ff000)
+		{
+			return sign | 0x7c00;
+		}
+		if (magnitude < 0x38800000)
+		{
+			return sign | static_cast<uint32_t>(std::nearbyint(std::bit_cast<float>(magnitude) * 16777216.0f));
+		}
+		return sign | ((magnitude + 0xfff + ((magnitude >> 13) & 1) - 0x38000000) >> 13);
+	}
+
+	const float HalfToFloat(uint32_t half) noexcept
+	{
+		const uint32_t sign = (half & 0x8000) << 16;
+		const uint32_t exponent = (half >> 10) & 0x1f;
+		const uint32_t mantissa = half & 0x3ff;
+
+		if (exponent == 0)
+		{
+			const float subnormal = static_cast<float>(mantissa) / 16777216.0f;
+			return sign ? -subnormal : subnormal;
+		}
+		if (exponent == 0x1f)
+		{
+			return std::bit_cast<float>(sign | 0x7f800000 | mantissa << 13);
+		}
+		return std::bit_cast<float>(sign | (exponent + 112) << 23 | mantissa << 13);
+	}
+
+	const uint32_t PackTexcoord(glm::vec2 texcoord) noexcept
+	{
+		return FloatToHalf(texcoord.x) | FloatToHalf(texcoord.y) << 16;
+	}
+
+	const glm::vec2 UnpackTexcoord(uint32_t packed) noexcept
+	{
+		return glm::vec2{ HalfToFloat(packed & 0xffff), HalfToFloat(packed >> 16) };
+	}
+
+	template <typename Attribute, typename Unpack>
+	const auto Interpolate(const std::vector<Attribute>& attribute, uint32_t triangleIndex, float u, float v, Unpack&& unpack) noexcept
+	{
+		const size_t firstVertex = 3 * static_cast<size_t>(triangleIndex);
+		return (1.0f - u - v) * unpack(attribute[firstVertex]) + u * unpack(attribute[firstVertex + 1]) + v * unpack(attribute[firstVertex + 2]);
+	}
+
+	template <typename Attribute>
+	const bool HasAttribute(const Mesh& mesh, const std::vector<Attribute>& attribute) noexcept
+	{
+		return !attribute.empty() && attribute.size() == mesh.posistions.size();
+	}
+}
+
+void BuildMeshBvh(Mesh& mesh, const BvhBuildSettings& settings, WideBvhLayout layout)
+{
+	mesh.bvhSettings = settings;
+	mesh.bvhSettings.threadPool = nullptr;
+	if (settings.mode == BvhBuildMode::Spatial)
+	{
+		mesh.bvh = BuildSpatialBvh(ComputeTriangleBounds(mesh), mesh.posistions, settings);
+	}
+	else
+	{
+		mesh.bvh = BuildBvh(ComputeTriangleBounds(mesh), settings);
+	}
+	mesh.wideBvh = CollapseBvh(mesh.bvh, layout);
+}
+
+void ReorderTriangles(Mesh& mesh)
+{
+	const size_t triangleCount = mesh.posistions.size() / 3;
+	if (mesh.bvh.primitiveIndices.size() != triangleCount)
+	{
+		return;
+	}
+
+	const auto reorder = [&](auto& attribute)
+	{
+		if (attribute.size() != mesh.posistions.size())
+		{
+			return;
+		}
+
+		std::remove_reference_t<decltype(attribute)> reordered;
+		reordered.reserve(attribute.size());
+		for (const uint32_t triangleIndex : mesh.bvh.primitiveIndices)
+		{
+			for (uint32_t corner{ 0 }; corner < 3; ++corner)
+			{
+				reordered.push_back(attribute[3 * static_cast<size_t>(triangleIndex) + corner]);
+			}
+		}
+		attribute = std::move(reordered);
+	};
+
+	reorder(mesh.normals);
+	reorder(mesh.tangents);
+	reorder(mesh.texcoords);
+	reorder(mesh.packedNormals);
+	reorder(mesh.packedTangents);
+	reorder(mesh.packedTexcoords);
+	// Last, every attribute compares its size against it.
+	reorder(mesh.posistions);
+
+	std::iota(mesh.bvh.primitiveIndices.begin(), mesh.bvh.primitiveIndices.end(), 0u);
+	std::iota(mesh.wideBvh.primitiveIndices.begin(), mesh.wideBvh.primitiveIndices.end(), 0u);
+}
+
+const bool RefitMeshBvh(Mesh& mesh)
+{
+	LUX_PROFILE_ZONE("RefitMeshBvh");
+
+	const std::vector<Bounds> triangleBounds = ComputeTriangleBounds(mesh);
+	const auto rebuild = [&]
+	{
+		if (mesh.bvhSettings.mode == BvhBuildMode::Spatial)
+		{
+			mesh.bvh = BuildSpatialBvh(triangleBounds, mesh.posistions, mesh.bvhSettings);
+		}
+		else
+		{
+			mesh.bvh = BuildBvh(triangleBounds, mesh.bvhSettings);
+		}
+	};
+
+	// Spatial splits reference triangles from more than one leaf, so only
+	// other trees have one index per triangle.
+	const bool spatial = mesh.bvhSettings.mode == BvhBuildMode::Spatial;
+	const bool trianglesChanged = (!spatial && mesh.bvh.primitiveIndices.size() != triangleBounds.size())
+		|| std::any_of(mesh.bvh.primitiveIndices.begin(), mesh.bvh.primitiveIndices.end(), [&](uint32_t index) { return index >= triangleBounds.size(); });
+	bool rebuilt{ false };
+
+	if (trianglesChanged)
+	{
+		rebuild();
+		rebuilt = true;
+	}
+	else
+	{
+		RefitBvh(mesh.bvh, triangleBounds);
+		if (ComputeSahCost(mesh.bvh, mesh.bvhSettings) > bvhRebuildThreshold * mesh.bvh.builtSahCost)
+		{
+			rebuild();
+			rebuilt = true;
+		}
+	}
+
+	mesh.wideBvh = CollapseBvh(mesh.bvh, mesh.wideBvh.layout);
+	return rebuilt;
+}
+
+const Bounds ComputeBounds(const Mesh& mesh) noexcept
+{
+	return mesh.bvh.nodes.empty() ? Bounds{} : mesh.bvh.nodes[0].bounds;
+}
+
+void QuantizeAttributes(Mesh& mesh)
+{
+	LUX_PROFILE_ZONE("QuantizeAttributes");
+
+	const auto pack = [](auto& attribute, std::vector<uint32_t>& packed, auto&& packValue)
+	{
+		packed.resize(attribute.size());
+		std::transform(attribute.begin(), attribute.end(), packed.begin(), packValue);
+		attribute.clear();
+		attribute.shrink_to_fit();
+	};
+
+	if (!mesh.normals.empty())
+	{
+		pack(mesh.normals, mesh.packedNormals, PackNormal);
+	}
+	if (!mesh.tangents.empty())
+	{
+		pack(mesh.tangents, mesh.packedTangents, PackTangent);
+	}
+	if (!mesh.texcoords.empty())
+	{
+		pack(mesh.texcoords, mesh.packedTexcoords, PackTexcoord);
+	}
+}
+
+const glm::vec3 InterpolateNormal(const Mesh& mesh, uint32_t triangleIndex, float u, float v) noexcept
+{
+	if (HasAttribute(mesh, mesh.normals))
+	{
+		return Interpolate(mesh.normals, triangleIndex, u, v, [](glm::vec3 normal) { return normal; });
+	}
+	if (HasAttribute(mesh, mesh.packedNormals))
+	{
+		return Interpolate(mesh.packedNormals, triangleIndex, u, v, UnpackNormal);
+	}
+	return glm::vec3{ 0.0f };
+}
+
+const glm::vec4 InterpolateTangent(const Mesh& mesh, uint32_t triangleIndex, float u, float v) noexcept
+{
+	glm::vec4 tangent{ 0.0f };
+	if (HasAttribute(mesh, mesh.tangents))
+	{
+		tangent = Interpolate(mesh.tangents, triangleIndex, u, v, [](glm::vec4 tangent) { return tangent; });
+	}
+	else if (HasAttribute(mesh, mesh.packedTangents))
+	{
+		tangent = Interpolate(mesh.packedTangents, triangleIndex, u, v, UnpackTangent);
+	}
+
+	// The handedness is constant over a triangle, interpolating only blends
+	// the directions.
+	tangent.w = tangent.w < 0.0f ? -1.0f : 1.0f;
+	return tangent;
+}
+
+const glm::vec2 InterpolateTexcoord(const Mesh& mesh, uint32_t triangleIndex, float u, float v) noexcept
+{
+	if (HasAttribute(mesh, mesh.texcoords))
+	{
+		return Interpolate(mesh.texcoords, triangleIndex, u, v, [](glm::vec2 texcoord) { return texcoord; });
+	}
+	if (HasAttribute(mesh, mesh.packedTexcoords))
+	{
+		return Interpolate(mesh.packedTexcoords, triangleIndex, u, v, UnpackTexcoord);
+	}
+	return glm::vec2{ 0.0f };
+}
+
+const MeshMemoryReport ReportMemory(const Mesh& mesh) noexcept
+{
+	MeshMemoryReport report{};
+	report.triangleCount = mesh.posistions.size() / 3;
+	report.binaryNodeCount = mesh.bvh.nodes.size();
+	report.wideNodeCount = mesh.wideBvh.nodes.size();
+	report.sahCost = mesh.bvh.builtSahCost;
+
+	for (const BvhNode& node : mesh.bvh.nodes)
+	{
+		if (node.primitiveCount > 0)
+		{
+			++report.leafCount;
+			++report.leafSizeHistogram[std::min<size_t>(node.primitiveCount, report.leafSizeHistogram.size()) - 1];
+		}
+	}
+
+	report.traversalBytes = mesh.wideBvh.nodes.size() * sizeof(WideBvhNode) + mesh.wideBvh.primitiveIndices.size() * sizeof(uint32_t);
+	report.attributeBytes = mesh.normals.size() * sizeof(glm::vec3)
+		+ mesh.tangents.size() * sizeof(glm::vec4)
+		+ mesh.texcoords.size() * sizeof(glm::vec2)
+		+ (mesh.packedNormals.size() + mesh.packedTangents.size() + mesh.packedTexcoords.size()) * sizeof(uint32_t);
+	report.totalBytes = report.traversalBytes
+		+ mesh.bvh.nodes.size() * sizeof(BvhNode)
+		+ mesh.bvh.primitiveIndices.size() * sizeof(uint32_t)
+		+ mesh.posistions.size() * sizeof(glm::vec3)
+		+ report.attributeBytes;
+
+	return report;
+}
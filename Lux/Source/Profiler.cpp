@@ -0,0 +1,101 @@
+#include "Profiler.h"
+
+#include <fstream>
+
+Profiler& Profiler::Get() noexcept
+{
+	static Profiler profiler{};
+	return profiler;
+}
+
+Profiler::Profiler()
+	: start(std::chrono::steady_clock::now())
+{
+}
+
+ThreadProfile& Profiler::CurrentThread()
+{
+	thread_local ThreadProfile* threadProfile{ nullptr };
+
+	if (!threadProfile)
+	{
+		std::lock_guard lock{ mutex };
+		auto& profile = threads.emplace_back(std::make_unique<ThreadProfile>());
+		profile->threadID = static_cast<uint32_t>(threads.size() - 1);
+		profile->threadName = "Thread " + std::to_string(profile->threadID);
+		profile->events.resize(profileEventCapacity);
+		threadProfile = profile.get();
+	}
+
+	return *threadProfile;
+}
+
+void Profiler::SetThreadName(std::string name)
+{
+	ThreadProfile& profile = CurrentThread();
+
+	std::lock_guard lock{ mutex };
+	profile.threadName = std::move(name);
+}
+
+int64_t Profiler::Now() const noexcept
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool Profiler::WriteChromeTrace(const std::filesystem::path& filePath)
+{
+	std::ofstream file{ filePath };
+	if (!file)
+	{
+		return false;
+	}
+
+	std::lock_guard lock{ mutex };
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	auto separator = [&first, &file]()
+	{
+		if (!first)
+		{
+			file << ",\n";
+		}
+		first = false;
+	};
+
+	for (const auto& thread : threads)
+	{
+		separator();
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->threadID
+			<< ",\"args\":{\"name\":\"" << thread->threadName << "\"}}";
+
+		// Oldest first, the ring has wrapped once more events were recorded
+		// than it holds.
+		const uint64_t firstEvent = thread->eventCount > profileEventCapacity ? thread->eventCount - profileEventCapacity : 0;
+		for (uint64_t eventIndex{ firstEvent }; eventIndex < thread->eventCount; ++eventIndex)
+		{
+			const ProfileEvent& event = thread->events[eventIndex % profileEventCapacity];
+			separator();
+			file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread->threadID
+				<< ",\"ts\":" << event.startMicroseconds << ",\"dur\":" << event.durationMicroseconds << "}";
+		}
+	}
+
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
+
+ProfileZone::ProfileZone(const char* name)
+	: thread(Profiler::Get().CurrentThread())
+	, name(name)
+	, startMicroseconds(Profiler::Get().Now())
+{
+}
+
+ProfileZone::~ProfileZone()
+{
+	const int64_t endMicroseconds = Profiler::Get().Now();
+	thread.events[thread.eventCount % profileEventCapacity] = ProfileEvent{ name, startMicroseconds, endMicroseconds - startMicroseconds };
+	++thread.eventCount;
+}
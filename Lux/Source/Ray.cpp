@@ -1,31 +1,151 @@
 #include "Ray.h"
 #include "Color.h"
+#include "Statistics.h"
+#include "Texture.h"
+#include "Triangle.h"
 
 #include <glm/vec3.hpp>
 #include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <limits>
 
 constexpr static float epsilon = 0.0000001f;
+constexpr static float shadowBias = 0.0001f;
 
-const glm::vec3 Trace(const Scene& scene, const Ray& ray) noexcept
+namespace
 {
-	auto hitRecord = ClosestIntersection(scene, ray);
-	if (hitRecord)
+	// The direction is not renormalized, so distances in object space are
+	// the same as in world space. Moving objects are placed at time without
+	// building their matrices.
+	const Ray ToObjectSpace(const Scene& scene, const Object& object, glm::vec3 origin, glm::vec3 direction, float time) noexcept
 	{
-		HitRecord& value = hitRecord.value();
-		glm::vec3 hitPoint = PointAlongRay(ray, value.hitDistance);
+		if (object.motionID != noMotion)
+		{
+			const ObjectMotion& motion = scene.motions[object.motionID];
+			const NodeTransform transform = InterpolateTransform(motion.start, motion.end, time);
+			const glm::quat inverseRotation = glm::conjugate(transform.rotation);
+			return Ray
+			{
+				(inverseRotation * (origin - transform.translation)) / transform.scale,
+				(inverseRotation * direction) / transform.scale
+			};
+		}
+
+		return Ray
+		{
+			glm::vec3{ object.objectFromWorld * glm::vec4{ origin, 1.0f } },
+			glm::mat3{ object.objectFromWorld } * direction
+		};
+	}
+
+	const glm::vec3 EmittedRadiance(const Scene& scene, MaterialID material, glm::vec2 texcoord, float levelOfDetail) noexcept
+	{
+		const MaterialShading& shading = scene.materials.shading[material];
+		if (!(shading.flags & materialEmissive))
+		{
+			return glm::vec3{ 0.0f };
+		}
+
+		glm::vec3 emission = scene.materials.extras[material].emissiveColor;
+		if (shading.emissiveTexture != noTexture)
+		{
+			emission *= glm::vec3{ SampleTexture(*scene.materials.textures[shading.emissiveTexture], texcoord, levelOfDetail) };
+		}
+		return emission;
+	}
+
+	const std::array<glm::vec3, 3> WorldTriangle(const Scene& scene, const TriangleLight& light, float time) noexcept
+	{
+		const Object object = ObjectAtTime(scene, light.objectIndex, time);
+		const Mesh& mesh = *scene.meshes[object.meshID];
+		const size_t firstVertex = 3 * static_cast<size_t>(light.triangleIndex);
+		return std::array<glm::vec3, 3>
+		{
+			glm::vec3{ object.worldFromObject * glm::vec4{ mesh.posistions[firstVertex], 1.0f } },
+			glm::vec3{ object.worldFromObject * glm::vec4{ mesh.posistions[firstVertex + 1], 1.0f } },
+			glm::vec3{ object.worldFromObject * glm::vec4{ mesh.posistions[firstVertex + 2], 1.0f } }
+		};
+	}
+
+	// Solid angle density of reaching a point of light at distance along
+	// direction by light sampling.
+	const float TriangleLightPdf(const Scene& scene, uint32_t lightIndex, const std::array<glm::vec3, 3>& vertices, glm::vec3 direction, float distance) noexcept
+	{
+		const glm::vec3 cross = glm::cross(vertices[1] - vertices[0], vertices[2] - vertices[0]);
+		const float cosine = std::abs(glm::dot(cross, direction));
+		if (cosine == 0.0f)
+		{
+			return 0.0f;
+		}
+		// The area is half the length of cross, its cosine is divided by it.
+		return scene.triangleLightTable.pdfs[lightIndex] * 2.0f * distance * distance / cosine;
+	}
+
+	const float PowerHeuristic(float pdf, float otherPdf) noexcept
+	{
+		return pdf * pdf / (pdf * pdf + otherPdf * otherPdf);
+	}
+}
+
+const glm::vec3 Trace(const Scene& scene, const Ray& ray, Sampler& sampler) noexcept
+{
+	auto hit = ClosestIntersection(scene, ray);
+	if (hit)
+	{
+		const HitRecord value = ComputeHitAttributes(scene, ray, hit.value());
+		const MaterialShading& material = scene.materials.shading[value.material];
+		const auto sample = [&](TextureID texture)
+		{
+			return SampleTexture(*scene.materials.textures[texture], value.texcoord, value.textureLevelOfDetail);
+		};
 
-		if (value.material->metalicness == 0.0f)
+		glm::vec3 albedo = material.baseColor;
+		float metalness = material.metalness;
+		glm::vec3 normal = value.normal;
+		const glm::vec3 emission = EmittedRadiance(scene, value.material, value.texcoord, value.textureLevelOfDetail);
+
+		if (material.baseColorTexture != noTexture)
+		{
+			albedo *= glm::vec3{ sample(material.baseColorTexture) };
+		}
+		if (material.metallicRoughnessTexture != noTexture)
 		{
-			return value.material->albedoColor * DirectIllumination(scene, hitPoint, value.normal);
+			metalness *= sample(material.metallicRoughnessTexture).z;
+		}
+		if (material.normalTexture != noTexture && value.tangent.w != 0.0f)
+		{
+			const glm::vec3 tangent = glm::normalize(glm::vec3{ value.tangent } - glm::dot(glm::vec3{ value.tangent }, normal) * normal);
+			const glm::vec3 bitangent = glm::cross(normal, tangent) * value.tangent.w;
+			const float normalScale = scene.materials.extras[value.material].normalScale;
+			const glm::vec3 tangentNormal = (2.0f * glm::vec3{ sample(material.normalTexture) } - 1.0f) * glm::vec3{ normalScale, normalScale, 1.0f };
+			const glm::vec3 mappedNormal = tangentNormal.x * tangent + tangentNormal.y * bitangent + tangentNormal.z * normal;
+			if (glm::dot(mappedNormal, value.geometricNormal) > 0.0f)
+			{
+				normal = glm::normalize(mappedNormal);
+			}
+		}
+
+		const glm::vec3 diffuse = albedo * (DirectIllumination(scene, value.point, normal, ray.time) + EmissiveIllumination(scene, value, normal, sampler));
+		if (metalness == 0.0f)
+		{
+			return emission + diffuse;
 		}
 		else
 		{
-			return value.material->albedoColor /** Trace(scene, Ray{ hitPoint, Reflect(ray.direction, value.normal) })*/;
+			return emission + (1.0f - metalness) * diffuse + metalness * albedo /** Trace(scene, Ray{ value.point, Reflect(ray.direction, normal) })*/;
 		}
 	}
+	else if (scene.environment)
+	{
+		return EnvironmentRadiance(*scene.environment, ray.direction);
+	}
 	else
 	{
 		return glm::vec3{ 0.5f, 0.5f, 1.0f };
@@ -37,81 +157,157 @@ const glm::vec3 PointAlongRay(const Ray& ray, float distance) noexcept
 	return ray.origin + distance * ray.direction;
 }
 
-const std::optional<HitRecord> ClosestIntersection(const Scene& scene, const Ray& ray) noexcept
+const std::optional<Hit> ClosestIntersection(const Scene& scene, const Ray& ray) noexcept
 {
-	float closestHitDistance{ std::numeric_limits<float>::max() };
-	size_t closestObjectIndex{ std::numeric_limits<size_t>::max() };
-	size_t closestTriangle{ std::numeric_limits<size_t>::max() };
+	Hit closestHit{ 1.0f / epsilon, invalidPrimitive };
 
-	for (size_t objectIndex{ 0 }; objectIndex < scene.objects.size(); ++objectIndex)
+	TraverseBvh(scene.bvh, ray.origin, ray.direction, closestHit.distance, [&](uint32_t primitiveIndex, float& maxDistance)
 	{
-		const Object& object{ scene.objects[objectIndex] };
-		for (size_t vertexIndex{ 0 }; vertexIndex < object.geometry->posistions.size(); vertexIndex += 3)
-		{
-			glm::vec3 vertex0 = object.geometry->posistions[vertexIndex];
-			glm::vec3 vertex1 = object.geometry->posistions[vertexIndex + 1];
-			glm::vec3 vertex2 = object.geometry->posistions[vertexIndex + 2];
-			glm::vec3 edge1 = vertex1 - vertex0;
-			glm::vec3 edge2 = vertex2 - vertex0;
-			glm::vec3 pvec = glm::cross(ray.direction, edge2);
-			float det = glm::dot(edge1, pvec);
+		const PrimitiveReference& primitive = scene.primitives[primitiveIndex];
+		float t{ std::numeric_limits<float>::infinity() };
 
-			if (det > -epsilon && det < epsilon)
+		switch (primitive.type)
+		{
+		case PrimitiveType::Object:
+		{
+			const Object& object = scene.objects[primitive.index];
+			const Mesh& mesh = *scene.meshes[object.meshID];
+			const Ray objectRay = ToObjectSpace(scene, object, ray.origin, ray.direction, ray.time);
+			const TriangleRay triangleRay = PrepareTriangleRay(objectRay.origin, objectRay.direction);
+			TraverseWideBvh(mesh.wideBvh, objectRay.origin, objectRay.direction, maxDistance, [&](uint32_t triangleIndex, float& meshMaxDistance)
 			{
-				continue;
-			}
+				const TriangleHit triangleHit = IntersectTriangle(triangleRay, mesh.posistions[3 * triangleIndex], mesh.posistions[3 * triangleIndex + 1], mesh.posistions[3 * triangleIndex + 2], epsilon, meshMaxDistance);
+				if (triangleHit.distance < meshMaxDistance)
+				{
+					meshMaxDistance = triangleHit.distance;
+					closestHit = Hit{ triangleHit.distance, primitiveIndex, triangleIndex, triangleHit.u, triangleHit.v };
+				}
+				return false;
+			});
+			return false;
+		}
+		case PrimitiveType::Sphere:
+			t = Intersect(scene.spheres[primitive.index], ray.origin, ray.direction, epsilon, maxDistance);
+			break;
+		case PrimitiveType::Disc:
+			t = Intersect(scene.discs[primitive.index], ray.origin, ray.direction, epsilon, maxDistance);
+			break;
+		case PrimitiveType::Box:
+			t = Intersect(scene.boxes[primitive.index], ray.origin, ray.direction, epsilon, maxDistance);
+			break;
+		}
+
+		if (t < maxDistance)
+		{
+			maxDistance = t;
+			closestHit = Hit{ t, primitiveIndex, 0 };
+		}
+		return false;
+	}, ray.time);
 
-			float invDet = 1.0f / det;
-			glm::vec3 tvec = ray.origin - vertex0;
-			float u = invDet * glm::dot(tvec, pvec);
+	for (uint32_t planeIndex{ 0 }; planeIndex < scene.planes.size(); ++planeIndex)
+	{
+		float t = Intersect(scene.planes[planeIndex], ray.origin, ray.direction, epsilon, closestHit.distance);
+		if (t < closestHit.distance)
+		{
+			closestHit = Hit{ t, planeInstance, planeIndex };
+		}
+	}
 
-			if (u < 0.0f || u > 1.0f)
+	if (closestHit.instanceID == invalidPrimitive)
+	{
+		return std::nullopt;
+	}
+	return closestHit;
+}
+
+const HitRecord ComputeHitAttributes(const Scene& scene, const Ray& ray, const Hit& hit) noexcept
+{
+	HitRecord record{ hit.distance, PointAlongRay(ray, hit.distance) };
+	record.time = ray.time;
+
+	if (hit.instanceID == planeInstance)
+	{
+		const Plane& plane = scene.planes[hit.primitiveID];
+		record.geometricNormal = NormalAt(plane, record.point);
+		record.normal = record.geometricNormal;
+		record.material = plane.material;
+	}
+	else
+	{
+		const uint32_t index = scene.primitives[hit.instanceID].index;
+		switch (scene.primitives[hit.instanceID].type)
+		{
+		case PrimitiveType::Object:
+		{
+			const Object object = ObjectAtTime(scene, index, ray.time);
+			const Mesh& mesh = *scene.meshes[object.meshID];
+			const size_t firstVertex = 3 * static_cast<size_t>(hit.primitiveID);
+			const glm::mat3 normalFromObject = glm::transpose(glm::mat3{ object.objectFromWorld });
+
+			const glm::vec3 edge1 = mesh.posistions[firstVertex + 1] - mesh.posistions[firstVertex];
+			const glm::vec3 edge2 = mesh.posistions[firstVertex + 2] - mesh.posistions[firstVertex];
+			record.geometricNormal = glm::normalize(normalFromObject * glm::cross(edge1, edge2));
+			record.normal = record.geometricNormal;
+
+			const glm::vec3 normal = InterpolateNormal(mesh, hit.primitiveID, hit.u, hit.v);
+			if (glm::dot(normal, normal) > 0.0f)
 			{
-				continue;
+				record.normal = glm::normalize(normalFromObject * normal);
 			}
 
-			glm::vec3 qvec = glm::cross(tvec, edge1);
-			float v = invDet * glm::dot(ray.direction, qvec);
-
-			if (v < 0.0f || u + v > 1.0f)
+			const glm::vec4 tangent = InterpolateTangent(mesh, hit.primitiveID, hit.u, hit.v);
+			const glm::vec3 worldTangent = glm::mat3{ object.worldFromObject } * glm::vec3{ tangent };
+			if (glm::dot(worldTangent, worldTangent) > 0.0f)
 			{
-				continue;
+				record.tangent = glm::vec4{ glm::normalize(worldTangent), tangent.w };
 			}
+			record.texcoord = InterpolateTexcoord(mesh, hit.primitiveID, hit.u, hit.v);
 
-			float t = invDet * glm::dot(edge2, qvec);
-			if (t > epsilon && t < 1.0f / epsilon && t < closestHitDistance)
+			if (!mesh.texcoords.empty() || !mesh.packedTexcoords.empty())
 			{
-				closestHitDistance = t;
-				closestObjectIndex = objectIndex;
-				closestTriangle = vertexIndex;
+				const glm::vec2 texcoordEdge1 = InterpolateTexcoord(mesh, hit.primitiveID, 1.0f, 0.0f) - InterpolateTexcoord(mesh, hit.primitiveID, 0.0f, 0.0f);
+				const glm::vec2 texcoordEdge2 = InterpolateTexcoord(mesh, hit.primitiveID, 0.0f, 1.0f) - InterpolateTexcoord(mesh, hit.primitiveID, 0.0f, 0.0f);
+				const glm::mat3 worldFromObject{ object.worldFromObject };
+				const float texcoordArea = std::abs(texcoordEdge1.x * texcoordEdge2.y - texcoordEdge1.y * texcoordEdge2.x);
+				const float worldArea = glm::length(glm::cross(worldFromObject * edge1, worldFromObject * edge2));
+				const float coneWidth = ray.coneWidth + ray.coneSpreadAngle * hit.distance;
+				record.textureLevelOfDetail = ConeLevelOfDetail(coneWidth, glm::dot(ray.direction, record.geometricNormal), texcoordArea, worldArea);
 			}
+
+			record.material = object.materialID;
+			break;
+		}
+		case PrimitiveType::Sphere:
+			record.geometricNormal = NormalAt(scene.spheres[index], record.point);
+			record.normal = record.geometricNormal;
+			record.material = scene.spheres[index].material;
+			break;
+		case PrimitiveType::Disc:
+			record.geometricNormal = NormalAt(scene.discs[index], record.point);
+			record.normal = record.geometricNormal;
+			record.material = scene.discs[index].material;
+			break;
+		case PrimitiveType::Box:
+			record.geometricNormal = NormalAt(scene.boxes[index], record.point);
+			record.normal = record.geometricNormal;
+			record.material = scene.boxes[index].material;
+			break;
 		}
 	}
 
-	if (closestHitDistance < std::numeric_limits<float>::max())
+	if (glm::dot(ray.direction, record.geometricNormal) > 0.0f)
 	{
-		const Object& closestObject = scene.objects[closestObjectIndex];
-		glm::vec3 closestVertex0 = closestObject.geometry->posistions[closestTriangle];
-		glm::vec3 closestVertex1 = closestObject.geometry->posistions[closestTriangle + 1];
-		glm::vec3 closestVertex2 = closestObject.geometry->posistions[closestTriangle + 2];
-		glm::vec3 A = closestVertex1 - closestVertex0;
-		glm::vec3 B = closestVertex2 - closestVertex0;
-		glm::vec3 normal = glm::cross(A, B);
-		float temp = glm::dot(ray.direction, normal);
-		if (temp > 0.0f)
-		{
-			normal = -normal;
-		}
-		return HitRecord{closestHitDistance, glm::normalize(normal), closestObject.material };
+		record.geometricNormal = -record.geometricNormal;
 	}
-	else
+	if (glm::dot(record.normal, record.geometricNormal) < 0.0f)
 	{
-		return std::nullopt;
+		record.normal = -record.normal;
 	}
-
+	return record;
 }
 
-const glm::vec3 DirectIllumination(const Scene& scene, glm::vec3 hitPoint, glm::vec3 normal) noexcept
+const glm::vec3 DirectIllumination(const Scene& scene, glm::vec3 hitPoint, glm::vec3 normal, float time) noexcept
 {
 	glm::vec3 color = Color::black;
 	auto& lights = scene.lights;
@@ -121,9 +317,11 @@ const glm::vec3 DirectIllumination(const Scene& scene, glm::vec3 hitPoint, glm::
 		float lengthSquared = glm::dot(lightDirection, lightDirection);
 		float length = sqrtf(lengthSquared);
 
-		if (!IsOccluded(scene, hitPoint, lightDirection, length))
+		glm::vec3 lightDirNormalized = lightDirection / length;
+
+		LUX_STATISTIC_INCREMENT(ShadowRays);
+		if (!IsOccluded(scene, hitPoint + shadowBias * normal, lightDirNormalized, length, time))
 		{
-			glm::vec3 lightDirNormalized = lightDirection / length;
 			color += light.color * glm::dot(normal, lightDirNormalized) / lengthSquared;
 		}
 	}
@@ -131,52 +329,161 @@ const glm::vec3 DirectIllumination(const Scene& scene, glm::vec3 hitPoint, glm::
 	return color;
 }
 
-const bool IsOccluded(const Scene& scene, glm::vec3 hitPoint, glm::vec3 lightDirection, float distance) noexcept
+const glm::vec3 EmissiveIllumination(const Scene& scene, const HitRecord& hit, glm::vec3 normal, Sampler& sampler) noexcept
 {
-	for (size_t objectIndex{ 0 }; objectIndex < scene.objects.size(); ++objectIndex)
+	const bool hasTriangleLights = !scene.triangleLightTable.pdfs.empty();
+	if (!hasTriangleLights && !scene.environment)
 	{
-		const Object& object{ scene.objects[objectIndex] };
-		for (size_t vertexIndex{ 0 }; vertexIndex < object.geometry->posistions.size(); vertexIndex += 3)
+		return glm::vec3{ 0.0f };
+	}
+
+	const glm::vec3 origin = hit.point + shadowBias * hit.geometricNormal;
+	glm::vec3 radiance{ 0.0f };
+
+	// Light sampling: a triangle by power, then a uniform point on it.
+	if (hasTriangleLights)
+	{
+		const uint32_t lightIndex = SampleAliasTable(scene.triangleLightTable, NextSample1D(sampler));
+		const TriangleLight& light = scene.triangleLights[lightIndex];
+		const std::array<glm::vec3, 3> vertices = WorldTriangle(scene, light, hit.time);
+
+		const glm::vec2 pointSample = NextSample2D(sampler);
+		const float root = std::sqrt(pointSample.x);
+		const float v = pointSample.y * root;
+		const float u = root - v;
+		const glm::vec3 point = vertices[0] + u * (vertices[1] - vertices[0]) + v * (vertices[2] - vertices[0]);
+
+		const glm::vec3 toLight = point - origin;
+		const float distance = glm::length(toLight);
+		const glm::vec3 direction = toLight / distance;
+		const float cosine = glm::dot(normal, direction);
+		const float lightPdf = TriangleLightPdf(scene, lightIndex, vertices, direction, distance);
+
+		if (cosine > 0.0f && glm::dot(hit.geometricNormal, direction) > 0.0f && lightPdf > 0.0f)
 		{
-			glm::vec3 vertex0 = object.geometry->posistions[vertexIndex];
-			glm::vec3 vertex1 = object.geometry->posistions[vertexIndex + 1];
-			glm::vec3 vertex2 = object.geometry->posistions[vertexIndex + 2];
-			glm::vec3 edge1 = vertex1 - vertex0;
-			glm::vec3 edge2 = vertex2 - vertex0;
-			glm::vec3 pvec = glm::cross(lightDirection, edge2);
-			float det = glm::dot(edge1, pvec);
+			const Object& object = scene.objects[light.objectIndex];
+			const glm::vec2 texcoord = InterpolateTexcoord(*scene.meshes[object.meshID], light.triangleIndex, u, v);
+			const glm::vec3 emission = EmittedRadiance(scene, object.materialID, texcoord, 0.0f);
 
-			if (det > -epsilon && det < epsilon)
+			LUX_STATISTIC_INCREMENT(ShadowRays);
+			if (emission != glm::vec3{ 0.0f } && !IsOccluded(scene, origin, direction, (1.0f - shadowBias) * distance, hit.time))
 			{
-				continue;
+				const float bsdfPdf = cosine * glm::one_over_pi<float>();
+				radiance += emission * (cosine * glm::one_over_pi<float>() / lightPdf * PowerHeuristic(lightPdf, bsdfPdf));
 			}
+		}
+	}
 
-			float invDet = 1.0f / det;
-			glm::vec3 tvec = hitPoint - vertex0;
-			float u = invDet * glm::dot(tvec, pvec);
+	// Environment sampling: a direction by luminance from the precomputed
+	// tables, its own technique besides the triangles.
+	if (scene.environment)
+	{
+		const EnvironmentSample sample = SampleEnvironment(*scene.environment, NextSample2D(sampler));
+		const float cosine = glm::dot(normal, sample.direction);
 
-			if (u < 0.0f || u > 1.0f)
+		if (cosine > 0.0f && glm::dot(hit.geometricNormal, sample.direction) > 0.0f && sample.pdf > 0.0f)
+		{
+			LUX_STATISTIC_INCREMENT(ShadowRays);
+			if (!IsOccluded(scene, origin, sample.direction, 1.0f / epsilon, hit.time))
 			{
-				continue;
+				const float bsdfPdf = cosine * glm::one_over_pi<float>();
+				radiance += sample.radiance * (cosine * glm::one_over_pi<float>() / sample.pdf * PowerHeuristic(sample.pdf, bsdfPdf));
 			}
+		}
+	}
+
+	// BSDF sampling: a cosine weighted direction, counted when it reaches an
+	// emissive triangle or leaves the scene. The cosine and the Lambert BSDF
+	// cancel with its pdf.
+	{
+		const glm::vec3 helper = std::abs(normal.x) > 0.9f ? glm::vec3{ 0.0f, 1.0f, 0.0f } : glm::vec3{ 1.0f, 0.0f, 0.0f };
+		const glm::vec3 tangent = glm::normalize(glm::cross(helper, normal));
+		const glm::vec3 bitangent = glm::cross(normal, tangent);
 
-			glm::vec3 qvec = glm::cross(tvec, edge1);
-			float v = invDet * glm::dot(lightDirection, qvec);
+		const glm::vec2 directionSample = NextSample2D(sampler);
+		const float radius = std::sqrt(directionSample.x);
+		const float angle = glm::two_pi<float>() * directionSample.y;
+		const float cosine = std::sqrt(std::max(0.0f, 1.0f - radius * radius));
+		const glm::vec3 direction = radius * std::cos(angle) * tangent + radius * std::sin(angle) * bitangent + cosine * normal;
 
-			if (v < 0.0f || u + v > 1.0f)
+		if (glm::dot(hit.geometricNormal, direction) > 0.0f)
+		{
+			LUX_STATISTIC_INCREMENT(BounceRays);
+			Ray bounce{ origin, direction };
+			bounce.time = hit.time;
+			const std::optional<Hit> emitterHit = ClosestIntersection(scene, bounce);
+			if (!emitterHit && scene.environment)
 			{
-				continue;
+				const float environmentPdf = EnvironmentPdf(*scene.environment, direction);
+				radiance += EnvironmentRadiance(*scene.environment, direction) * PowerHeuristic(cosine * glm::one_over_pi<float>(), environmentPdf);
 			}
-
-			float t = invDet * glm::dot(edge2, qvec);
-			if (t > epsilon && t < 1.0f / epsilon && t < distance)
+			else if (emitterHit && hasTriangleLights && emitterHit->instanceID != planeInstance && scene.primitives[emitterHit->instanceID].type == PrimitiveType::Object)
 			{
-				return true;
+				const uint32_t objectIndex = scene.primitives[emitterHit->instanceID].index;
+				if (scene.objectLights[objectIndex] != invalidLight)
+				{
+					const uint32_t lightIndex = scene.objectLights[objectIndex] + emitterHit->primitiveID;
+					const Object& object = scene.objects[objectIndex];
+					const glm::vec2 texcoord = InterpolateTexcoord(*scene.meshes[object.meshID], emitterHit->primitiveID, emitterHit->u, emitterHit->v);
+					const glm::vec3 emission = EmittedRadiance(scene, object.materialID, texcoord, 0.0f);
+
+					const float lightPdf = TriangleLightPdf(scene, lightIndex, WorldTriangle(scene, scene.triangleLights[lightIndex], hit.time), direction, emitterHit->distance);
+					const float bsdfPdf = cosine * glm::one_over_pi<float>();
+					radiance += emission * PowerHeuristic(bsdfPdf, lightPdf);
+				}
 			}
 		}
 	}
 
-	return false;
+	return radiance;
+}
+
+const bool IsOccluded(const Scene& scene, glm::vec3 hitPoint, glm::vec3 lightDirection, float distance, float time) noexcept
+{
+	for (const Plane& plane : scene.planes)
+	{
+		if (Intersect(plane, hitPoint, lightDirection, epsilon, distance) < distance)
+		{
+			return true;
+		}
+	}
+
+	bool occluded{ false };
+	float occluderDistance{ distance };
+	TraverseBvh(scene.bvh, hitPoint, lightDirection, occluderDistance, [&](uint32_t primitiveIndex, float& maxDistance)
+	{
+		const PrimitiveReference& primitive = scene.primitives[primitiveIndex];
+
+		switch (primitive.type)
+		{
+		case PrimitiveType::Object:
+		{
+			const Object& object = scene.objects[primitive.index];
+			const Mesh& mesh = *scene.meshes[object.meshID];
+			const Ray objectRay = ToObjectSpace(scene, object, hitPoint, lightDirection, time);
+			const TriangleRay triangleRay = PrepareTriangleRay(objectRay.origin, objectRay.direction);
+			TraverseWideBvh(mesh.wideBvh, objectRay.origin, objectRay.direction, maxDistance, [&](uint32_t triangleIndex, float& meshMaxDistance)
+			{
+				occluded = IntersectTriangle(triangleRay, mesh.posistions[3 * triangleIndex], mesh.posistions[3 * triangleIndex + 1], mesh.posistions[3 * triangleIndex + 2], epsilon, meshMaxDistance).distance < meshMaxDistance;
+				return occluded;
+			});
+			break;
+		}
+		case PrimitiveType::Sphere:
+			occluded = Intersect(scene.spheres[primitive.index], hitPoint, lightDirection, epsilon, maxDistance) < maxDistance;
+			break;
+		case PrimitiveType::Disc:
+			occluded = Intersect(scene.discs[primitive.index], hitPoint, lightDirection, epsilon, maxDistance) < maxDistance;
+			break;
+		case PrimitiveType::Box:
+			occluded = Intersect(scene.boxes[primitive.index], hitPoint, lightDirection, epsilon, maxDistance) < maxDistance;
+			break;
+		}
+
+		return occluded;
+	}, time);
+
+	return occluded;
 }
 
 const glm::vec3 Reflect(glm::vec3 incoming, glm::vec3 normal)
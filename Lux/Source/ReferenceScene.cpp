@@ -0,0 +1,190 @@
+#include "ReferenceScene.h"
+#include "Color.h"
+
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+	const Plane MakeGroundPlane(Scene& scene, ResourceManager& resourceManager)
+	{
+		return Plane{ glm::vec3{ 0.0f, 1.0f, 0.0f }, -1.0f, AddMaterial(scene.materials, resourceManager.AddMaterial(Material{ Color::white, 0.0f }, "Ground")) };
+	}
+
+	const ReferenceScene LoadGroundAndQuad(ResourceManager& resourceManager)
+	{
+		Mesh plane;
+		plane.posistions.emplace_back(1.0f,  1.0f, 0.0f);
+		plane.posistions.emplace_back(1.0f,  -1.0f, 0.0f);
+		plane.posistions.emplace_back(-1.0f, 1.0f, 0.0f);
+		plane.posistions.emplace_back(1.0f,  -1.0f, 0.0f);
+		plane.posistions.emplace_back(-1.0f, -1.0f, 0.0f);
+		plane.posistions.emplace_back(-1.0f, 1.0f, 0.0f);
+
+		ReferenceScene reference
+		{
+			Scene{},
+			glm::vec3{ 0.0f, 0.0f, -20.0f },
+			glm::vec3{ 0.0f, 0.0f, 1.0f },
+			90.0f
+		};
+
+		reference.scene.planes.push_back(MakeGroundPlane(reference.scene, resourceManager));
+		AddObject(reference.scene, resourceManager.AddMesh(std::move(plane), "Quad"), resourceManager.AddMaterial(Material{ Color::red, 0.0f }, "Quad"));
+		reference.scene.lights.push_back(PointLight
+		{
+			glm::vec3{ 0.0f, 0.0f, -1.0f },
+			Color::white * 10.f
+		});
+
+		BuildAccelerationStructure(reference.scene);
+		return reference;
+	}
+
+	const ReferenceScene LoadLantern(ResourceManager& resourceManager)
+	{
+
+		ReferenceScene reference
+		{
+			Scene{},
+			glm::vec3{ 0.0f, 10.0f, -30.0f },
+			glm::vec3{ 0.0f, 0.0f, 1.0f },
+			60.0f
+		};
+
+		reference.sceneGraph = resourceManager.ImportFromGltf(LUX_ASSET_DIRECTORY "/Models/Lantern/Lantern.gltf");
+		const Material& lanternMaterial = resourceManager.AddMaterial(Material{ Color::white, 0.0f }, "Lantern");
+		InstantiateSceneGraph(reference.sceneGraph, reference.scene, resourceManager, lanternMaterial);
+
+		reference.scene.planes.push_back(MakeGroundPlane(reference.scene, resourceManager));
+		reference.scene.lights.push_back(PointLight
+		{
+			glm::vec3{ 10.0f, 20.0f, -15.0f },
+			Color::white * 1000.f
+		});
+
+		BuildAccelerationStructure(reference.scene);
+		return reference;
+	}
+
+	const ReferenceScene LoadSpheres(ResourceManager& resourceManager)
+	{
+		constexpr int32_t gridSize = 32;
+		constexpr float spacing = 2.5f;
+
+		ReferenceScene reference
+		{
+			Scene{},
+			glm::vec3{ 0.0f, 15.0f, -50.0f },
+			glm::vec3{ 0.0f, -0.4f, 1.0f },
+			60.0f
+		};
+
+		const std::array<MaterialID, 3> materials
+		{
+			AddMaterial(reference.scene.materials, resourceManager.AddMaterial(Material{ Color::red, 0.0f }, "SphereRed")),
+			AddMaterial(reference.scene.materials, resourceManager.AddMaterial(Material{ Color::green, 0.0f }, "SphereGreen")),
+			AddMaterial(reference.scene.materials, resourceManager.AddMaterial(Material{ Color::blue, 0.0f }, "SphereBlue"))
+		};
+
+		for (int32_t z{ 0 }; z < gridSize; ++z)
+		{
+			for (int32_t x{ 0 }; x < gridSize; ++x)
+			{
+				glm::vec3 center{ (static_cast<float>(x) - 0.5f * gridSize) * spacing, 0.0f, static_cast<float>(z) * spacing };
+				reference.scene.spheres.push_back(Sphere{ center, 1.0f, materials[(x + z) % materials.size()] });
+			}
+		}
+
+		reference.scene.discs.push_back(Disc{ glm::vec3{ 0.0f, 6.0f, 40.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, 6.0f, materials[0] });
+		reference.scene.boxes.push_back(Box{ glm::vec3{ -4.0f, -1.0f, -6.0f }, glm::vec3{ 4.0f, 3.0f, -4.0f }, materials[2] });
+		reference.scene.planes.push_back(MakeGroundPlane(reference.scene, resourceManager));
+		reference.scene.lights.push_back(PointLight
+		{
+			glm::vec3{ 0.0f, 30.0f, 0.0f },
+			Color::white * 2000.f
+		});
+
+		BuildAccelerationStructure(reference.scene);
+		return reference;
+	}
+}
+
+const std::optional<ReferenceSceneID> ParseReferenceSceneID(std::string_view name) noexcept
+{
+	if (name == "ground")
+	{
+		return ReferenceSceneID::GroundAndQuad;
+	}
+	if (name == "lantern")
+	{
+		return ReferenceSceneID::Lantern;
+	}
+	if (name == "spheres")
+	{
+		return ReferenceSceneID::Spheres;
+	}
+	return std::nullopt;
+}
+
+const ReferenceScene LoadReferenceScene(ReferenceSceneID id, ResourceManager& resourceManager)
+{
+	switch (id)
+	{
+	case ReferenceSceneID::Lantern:
+		return LoadLantern(resourceManager);
+	case ReferenceSceneID::Spheres:
+		return LoadSpheres(resourceManager);
+	case ReferenceSceneID::GroundAndQuad:
+	default:
+		return LoadGroundAndQuad(resourceManager);
+	}
+}
+
+const ReferenceScene LoadGltfScene(const std::filesystem::path& filePath, ResourceManager& resourceManager)
+{
+	ReferenceScene reference
+	{
+		Scene{},
+		glm::vec3{ 0.0f, 0.0f, -1.0f },
+		glm::vec3{ 0.0f, 0.0f, 1.0f },
+		45.0f
+	};
+
+	reference.sceneGraph = resourceManager.ImportFromGltf(std::filesystem::path{ filePath });
+	const Material& defaultMaterial = resourceManager.AddMaterial(Material{ Color::white, 0.0f }, "Default");
+	InstantiateSceneGraph(reference.sceneGraph, reference.scene, resourceManager, defaultMaterial);
+	BuildAccelerationStructure(reference.scene);
+
+	Bounds bounds{};
+	for (const Bounds& primitiveBounds : reference.scene.primitiveBounds)
+	{
+		Grow(bounds, primitiveBounds);
+	}
+	if (IsEmpty(bounds))
+	{
+		bounds = Bounds{ glm::vec3{ -1.0f }, glm::vec3{ 1.0f } };
+	}
+
+	// Far enough back for the bounding sphere to fit the field of view.
+	const glm::vec3 center = Centroid(bounds);
+	const float radius = std::max(0.5f * glm::length(bounds.maximum - bounds.minimum), 1e-3f);
+	const float distance = radius / std::sin(0.5f * glm::radians(reference.verticalFov));
+	reference.cameraPosition = center + glm::vec3{ 0.0f, 0.25f * distance, -distance };
+	reference.cameraDirection = glm::normalize(center - reference.cameraPosition);
+
+	Plane ground = MakeGroundPlane(reference.scene, resourceManager);
+	ground.distance = bounds.minimum.y;
+	reference.scene.planes.push_back(ground);
+	reference.scene.lights.push_back(PointLight
+	{
+		center + radius * glm::vec3{ 1.0f, 2.0f, -1.0f },
+		Color::white * 10.0f * radius * radius
+	});
+
+	return reference;
+}
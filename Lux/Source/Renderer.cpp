@@ -0,0 +1,188 @@
+#include "Renderer.h"
+#include "Ray.h"
+#include "Profiler.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+Framebuffer::Framebuffer(int32_t width, int32_t height)
+	: width(width)
+	, height(height)
+	, pixels(static_cast<size_t>(width) * static_cast<size_t>(height))
+#if LUX_ENABLE_STATISTICS
+	, statistics(pixels.size())
+#endif
+{
+}
+
+const std::vector<Tile> MakeTiles(int32_t width, int32_t height, int32_t size)
+{
+	std::vector<Tile> tiles{};
+	tiles.reserve(static_cast<size_t>((width + size - 1) / size) * static_cast<size_t>((height + size - 1) / size));
+
+	for (int32_t y{ 0 }; y < height; y += size)
+	{
+		for (int32_t x{ 0 }; x < width; x += size)
+		{
+			tiles.push_back(Tile{ x, y, std::min(size, width - x), std::min(size, height - y) });
+		}
+	}
+
+	return tiles;
+}
+
+void RenderTile(const Scene& scene, const Camera& camera, const Tile& tile, Framebuffer& framebuffer, TileScratch& scratch, const SamplerSettings& sampling) noexcept
+{
+	LUX_PROFILE_ZONE("RenderTile");
+
+	const float coneWidth = PixelConeWidth(camera, framebuffer.height);
+	const float coneSpreadAngle = PixelSpreadAngle(camera, framebuffer.height);
+	const bool sampleLens = camera.model == CameraModel::ThinLens && camera.lensRadius > 0.0f;
+	// Without moving objects every ray is sent at shutter open, so static
+	// scenes keep their sample sequences.
+	const bool sampleTime = !scene.motions.empty();
+	const float sampleWeight = 1.0f / static_cast<float>(sampling.samplesPerPixel);
+
+	const size_t pixelCount = static_cast<size_t>(tile.width) * static_cast<size_t>(tile.height);
+	std::vector<Sampler>& samplers = scratch.samplers;
+	std::vector<glm::vec2>& jitter = scratch.jitter;
+	std::vector<glm::vec2>& lensSamples = scratch.lensSamples;
+	std::vector<float>& times = scratch.times;
+	std::vector<glm::vec3>& colors = scratch.colors;
+	CameraRays& rays = scratch.rays;
+	samplers.resize(pixelCount);
+	jitter.resize(pixelCount);
+	lensSamples.resize(sampleLens ? pixelCount : 0);
+	times.resize(sampleTime ? pixelCount : 0);
+	colors.assign(pixelCount, glm::vec3{ 0.0f });
+
+#if LUX_ENABLE_STATISTICS
+	for (int y{ tile.y }; y < tile.y + tile.height; ++y)
+	{
+		std::fill_n(framebuffer.statistics.begin() + (tile.x + framebuffer.width * y), tile.width, PixelStatistics{});
+	}
+#endif
+
+	// One sample of every pixel at a time, so the camera rays of the whole
+	// tile are generated together.
+	for (uint32_t sampleIndex{ 0 }; sampleIndex < sampling.samplesPerPixel; ++sampleIndex)
+	{
+		for (int y{ 0 }; y < tile.height; ++y)
+		{
+			for (int x{ 0 }; x < tile.width; ++x)
+			{
+				const size_t pixel = static_cast<size_t>(x + tile.width * y);
+				samplers[pixel] = StartPixelSample(sampling, tile.x + x, tile.y + y, sampleIndex);
+				jitter[pixel] = NextSample2D(samplers[pixel]);
+				if (sampleLens)
+				{
+					lensSamples[pixel] = NextSample2D(samplers[pixel]);
+				}
+				if (sampleTime)
+				{
+					times[pixel] = NextSample1D(samplers[pixel]);
+				}
+			}
+		}
+		GenerateCameraRays(camera, framebuffer.width, framebuffer.height, tile, jitter, lensSamples, rays);
+
+		for (int y{ 0 }; y < tile.height; ++y)
+		{
+			for (int x{ 0 }; x < tile.width; ++x)
+			{
+				const size_t pixel = static_cast<size_t>(x + tile.width * y);
+				Ray ray{ glm::vec3{ rays.originX[pixel], rays.originY[pixel], rays.originZ[pixel] }, glm::vec3{ rays.directionX[pixel], rays.directionY[pixel], rays.directionZ[pixel] } };
+				ray.coneWidth = coneWidth;
+				ray.coneSpreadAngle = coneSpreadAngle;
+				if (sampleTime)
+				{
+					ray.time = times[pixel];
+				}
+
+#if LUX_ENABLE_STATISTICS
+				const RayStatistics before = ThreadStatistics();
+#endif
+				LUX_STATISTIC_INCREMENT(PrimaryRays);
+				colors[pixel] += Trace(scene, ray, samplers[pixel]);
+#if LUX_ENABLE_STATISTICS
+				const PixelStatistics difference = Difference(ThreadStatistics(), before);
+				PixelStatistics& statistics = framebuffer.statistics[tile.x + x + framebuffer.width * (tile.y + y)];
+				for (size_t counter{ 0 }; counter < statisticCounterCount; ++counter)
+				{
+					statistics.counters[counter] += difference.counters[counter];
+				}
+#endif
+			}
+		}
+	}
+
+	for (int y{ 0 }; y < tile.height; ++y)
+	{
+		for (int x{ 0 }; x < tile.width; ++x)
+		{
+			framebuffer.pixels[tile.x + x + framebuffer.width * (tile.y + y)] = colors[static_cast<size_t>(x + tile.width * y)] * sampleWeight;
+		}
+	}
+}
+
+void RenderViews(const Scene& scene, std::vector<View>& views, ThreadPool& threadPool, const SamplerSettings& sampling)
+{
+	LUX_PROFILE_ZONE("RenderViews");
+
+	struct ViewTile
+	{
+		uint32_t view;
+		Tile tile;
+	};
+
+	std::vector<ViewTile> viewTiles{};
+	for (uint32_t view{ 0 }; view < views.size(); ++view)
+	{
+		for (const Tile& tile : MakeTiles(views[view].framebuffer.width, views[view].framebuffer.height))
+		{
+			viewTiles.push_back(ViewTile{ view, tile });
+		}
+	}
+
+	std::vector<TileScratch> scratch(threadPool.WorkerCount());
+	threadPool.ParallelFor(static_cast<uint32_t>(viewTiles.size()), [&](uint32_t tileIndex, uint32_t workerIndex)
+	{
+		View& view = views[viewTiles[tileIndex].view];
+		RenderTile(scene, view.camera, viewTiles[tileIndex].tile, view.framebuffer, scratch[workerIndex], sampling);
+	});
+}
+
+#if LUX_ENABLE_STATISTICS
+void AccumulateStatistics(const Framebuffer& framebuffer, RayStatistics& totals, PixelStatistics& maximum) noexcept
+{
+	maximum = PixelStatistics{};
+	for (const PixelStatistics& pixel : framebuffer.statistics)
+	{
+		for (size_t counter{ 0 }; counter < statisticCounterCount; ++counter)
+		{
+			totals.counters[counter] += pixel.counters[counter];
+			maximum.counters[counter] = std::max(maximum.counters[counter], pixel.counters[counter]);
+		}
+	}
+}
+
+void RenderDebugView(DebugView view, const PixelStatistics& maximum, const Tile& tile, Framebuffer& framebuffer) noexcept
+{
+	if (view == DebugView::Shaded)
+	{
+		return;
+	}
+
+	const size_t counter = static_cast<size_t>(view) - 1;
+	for (int y{ tile.y }; y < tile.y + tile.height; ++y)
+	{
+		for (int x{ tile.x }; x < tile.x + tile.width; ++x)
+		{
+			auto pixelIndex = x + framebuffer.width * y;
+			framebuffer.pixels[pixelIndex] = Heatmap(framebuffer.statistics[pixelIndex].counters[counter], maximum.counters[counter]);
+		}
+	}
+}
+#endif
@@ -1,115 +1,563 @@
 #include "ResourceManager.h"
+#include "Image.h"
+#include "Profiler.h"
 
 #include <glm/vec3.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include <fx/gltf.h>
 #include <gsl/span>
 #include <gsl/multi_span>
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <map>
+#include <string>
+#include <numeric>
+#include <optional>
+#include <tuple>
+#include <type_traits>
 
-void ResourceManager::ImportFromGltf(std::filesystem::path&& filePath)
+namespace
 {
+	const size_t ComponentSize(fx::gltf::Accessor::ComponentType componentType) noexcept
+	{
+		switch (componentType)
+		{
+		case fx::gltf::Accessor::ComponentType::Byte:
+		case fx::gltf::Accessor::ComponentType::UnsignedByte:
+			return 1;
+		case fx::gltf::Accessor::ComponentType::Short:
+		case fx::gltf::Accessor::ComponentType::UnsignedShort:
+			return 2;
+		default:
+			return 4;
+		}
+	}
+
+	const uint32_t ComponentCount(fx::gltf::Accessor::Type type) noexcept
+	{
+		switch (type)
+		{
+		case fx::gltf::Accessor::Type::Vec2:
+			return 2;
+		case fx::gltf::Accessor::Type::Vec3:
+			return 3;
+		case fx::gltf::Accessor::Type::Vec4:
+		case fx::gltf::Accessor::Type::Mat2:
+			return 4;
+		case fx::gltf::Accessor::Type::Mat3:
+			return 9;
+		case fx::gltf::Accessor::Type::Mat4:
+			return 16;
+		default:
+			return 1;
+		}
+	}
+
+	// Integer components are mapped to [0, 1] or [-1, 1] when the accessor
+	// is normalized, as texcoords often are.
+	const float ReadComponent(const uint8_t* data, fx::gltf::Accessor::ComponentType componentType, bool normalized) noexcept
+	{
+		const auto read = [data]<typename T>(T value)
+		{
+			std::memcpy(&value, data, sizeof(T));
+			return value;
+		};
+
+		switch (componentType)
+		{
+		case fx::gltf::Accessor::ComponentType::Byte:
+			return normalized ? std::max(static_cast<float>(read(int8_t{})) / 127.0f, -1.0f) : static_cast<float>(read(int8_t{}));
+		case fx::gltf::Accessor::ComponentType::UnsignedByte:
+			return normalized ? static_cast<float>(read(uint8_t{})) / 255.0f : static_cast<float>(read(uint8_t{}));
+		case fx::gltf::Accessor::ComponentType::Short:
+			return normalized ? std::max(static_cast<float>(read(int16_t{})) / 32767.0f, -1.0f) : static_cast<float>(read(int16_t{}));
+		case fx::gltf::Accessor::ComponentType::UnsignedShort:
+			return normalized ? static_cast<float>(read(uint16_t{})) / 65535.0f : static_cast<float>(read(uint16_t{}));
+		case fx::gltf::Accessor::ComponentType::UnsignedInt:
+			return static_cast<float>(read(uint32_t{}));
+		default:
+			return read(float{});
+		}
+	}
+
+	// Elements of an accessor, following the byte stride of interleaved
+	// buffer views. Accessors without a buffer view are all zero.
+	template <typename Vector>
+	const std::vector<Vector> ReadAccessor(const fx::gltf::Document& gltf, uint32_t accessorIndex)
+	{
+		const fx::gltf::Accessor& accessor = gltf.accessors[accessorIndex];
+		std::vector<Vector> values(accessor.count, Vector{ 0.0f });
+		if (accessor.bufferView < 0)
+		{
+			return values;
+		}
+
+		const fx::gltf::BufferView& bufferView = gltf.bufferViews[accessor.bufferView];
+		const fx::gltf::Buffer& buffer = gltf.buffers[bufferView.buffer];
+		const uint8_t* start = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+
+		const size_t componentSize = ComponentSize(accessor.componentType);
+		const uint32_t componentCount = std::min(ComponentCount(accessor.type), static_cast<uint32_t>(Vector::length()));
+		const size_t stride = bufferView.byteStride != 0 ? bufferView.byteStride : componentSize * ComponentCount(accessor.type);
+
+		for (size_t element{ 0 }; element < values.size(); ++element)
+		{
+			for (uint32_t component{ 0 }; component < componentCount; ++component)
+			{
+				values[element][component] = ReadComponent(start + element * stride + component * componentSize, accessor.componentType, accessor.normalized);
+			}
+		}
+		return values;
+	}
+
+	const std::vector<uint32_t> ReadIndices(const fx::gltf::Document& gltf, const fx::gltf::Primitive& primitive, size_t vertexCount)
+	{
+		std::vector<uint32_t> indices;
+		if (primitive.indices < 0)
+		{
+			indices.resize(vertexCount);
+			std::iota(indices.begin(), indices.end(), 0u);
+			return indices;
+		}
+
+		const fx::gltf::Accessor& accessor = gltf.accessors[primitive.indices];
+		const fx::gltf::BufferView& bufferView = gltf.bufferViews[accessor.bufferView];
+		const fx::gltf::Buffer& buffer = gltf.buffers[bufferView.buffer];
+		const uint8_t* start = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+		const size_t componentSize = ComponentSize(accessor.componentType);
+
+		indices.resize(accessor.count);
+		for (size_t i{ 0 }; i < indices.size(); ++i)
+		{
+			uint32_t index{ 0 };
+			std::memcpy(&index, start + i * componentSize, componentSize);
+			indices[i] = index;
+		}
+		return indices;
+	}
+
+	// Channels of nodes outside the default scene and morph target weights
+	// are left out.
+	const Animation ConvertAnimation(const fx::gltf::Document& gltf, const fx::gltf::Animation& gltfAnimation, gsl::span<const uint32_t> graphNodes)
+	{
+		Animation animation{ gltfAnimation.name };
+		for (const fx::gltf::Animation::Channel& gltfChannel : gltfAnimation.channels)
+		{
+			const int32_t gltfNode = gltfChannel.target.node;
+			if (gltfNode < 0 || graphNodes[gltfNode] == invalidNode || gltfChannel.sampler < 0)
+			{
+				continue;
+			}
+
+			AnimationChannel channel{ graphNodes[gltfNode] };
+			if (gltfChannel.target.path == "translation")
+			{
+				channel.path = AnimationPath::Translation;
+			}
+			else if (gltfChannel.target.path == "rotation")
+			{
+				channel.path = AnimationPath::Rotation;
+			}
+			else if (gltfChannel.target.path == "scale")
+			{
+				channel.path = AnimationPath::Scale;
+			}
+			else
+			{
+				continue;
+			}
+
+			const fx::gltf::Animation::Sampler& sampler = gltfAnimation.samplers[gltfChannel.sampler];
+			channel.interpolation = static_cast<AnimationInterpolation>(sampler.interpolation);
+			for (const glm::vec4& time : ReadAccessor<glm::vec4>(gltf, static_cast<uint32_t>(sampler.input)))
+			{
+				channel.times.push_back(time.x);
+			}
+			channel.values = ReadAccessor<glm::vec4>(gltf, static_cast<uint32_t>(sampler.output));
+
+			const size_t keyStride = channel.interpolation == AnimationInterpolation::CubicSpline ? 3 : 1;
+			if (channel.times.empty() || channel.values.size() < channel.times.size() * keyStride)
+			{
+				continue;
+			}
+
+			animation.duration = std::max(animation.duration, channel.times.back());
+			animation.channels.push_back(std::move(channel));
+		}
+		return animation;
+	}
+
+	const TextureWrap ConvertWrap(fx::gltf::Sampler::WrappingMode wrap) noexcept
+	{
+		switch (wrap)
+		{
+		case fx::gltf::Sampler::WrappingMode::ClampToEdge:
+			return TextureWrap::ClampToEdge;
+		case fx::gltf::Sampler::WrappingMode::MirroredRepeat:
+			return TextureWrap::MirroredRepeat;
+		default:
+			return TextureWrap::Repeat;
+		}
+	}
+}
+
+ResourceManager::ResourceManager(const MeshImportSettings& importSettings)
+	: importSettings{ importSettings }
+{
+	if (!importSettings.cacheDirectory.empty())
+	{
+		std::error_code error{};
+		std::filesystem::create_directories(importSettings.cacheDirectory, error);
+	}
+	if (importSettings.textureCacheBytes > 0 && !importSettings.cacheDirectory.empty())
+	{
+		textureCache = std::make_unique<TextureCache>(importSettings.textureCacheBytes);
+	}
+}
+
+const SceneGraph ResourceManager::ImportFromGltf(std::filesystem::path&& filePath)
+{
+	LUX_PROFILE_ZONE("ImportFromGltf");
+
 	const fx::gltf::Document gltf = fx::gltf::LoadFromText(filePath.string());
+	// Files without a default scene start with the first one, files
+	// without any scene have nothing to place.
+	const size_t sceneIndex = static_cast<size_t>(std::max(gltf.scene, 0));
+	if (sceneIndex >= gltf.scenes.size())
+	{
+		std::printf("%s has no scene %zu\n", filePath.string().c_str(), sceneIndex);
+		return SceneGraph{};
+	}
 
-	const fx::gltf::Scene& scene = gltf.scenes[gltf.scene];
+	// Materials sharing an image decode it once, color textures and data
+	// textures of the same image are kept apart.
+	std::map<std::tuple<int32_t, int32_t, bool>, const Texture*> convertedTextures{};
+	const auto getTexture = [&](const fx::gltf::Material::Texture& materialTexture, bool srgb) -> const Texture*
+	{
+		if (materialTexture.empty())
+		{
+			return nullptr;
+		}
+
+		const fx::gltf::Texture& gltfTexture = gltf.textures[materialTexture.index];
+		const auto key = std::make_tuple(gltfTexture.source, gltfTexture.sampler, srgb);
+		const auto converted = convertedTextures.find(key);
+		if (converted != convertedTextures.end())
+		{
+			return converted->second;
+		}
+
+		const Texture* texture = ConvertTexture(gltf, filePath, static_cast<uint32_t>(materialTexture.index), srgb);
+		convertedTextures.emplace(key, texture);
+		return texture;
+	};
+
+	std::vector<const Material*> gltfMaterials{};
+	gltfMaterials.reserve(gltf.materials.size());
+	for (const fx::gltf::Material& gltfMaterial : gltf.materials)
+	{
+		const fx::gltf::Material::PBRMetallicRoughness& pbr = gltfMaterial.pbrMetallicRoughness;
+		Material material{ glm::make_vec3(pbr.baseColorFactor.data()), pbr.metallicFactor, pbr.roughnessFactor };
+		material.baseColorTexture = getTexture(pbr.baseColorTexture, true);
+		material.metallicRoughnessTexture = getTexture(pbr.metallicRoughnessTexture, false);
+		material.normalTexture = getTexture(gltfMaterial.normalTexture, false);
+		material.normalScale = gltfMaterial.normalTexture.scale;
+		material.occlusionTexture = getTexture(gltfMaterial.occlusionTexture, false);
+		material.occlusionStrength = gltfMaterial.occlusionTexture.strength;
+		material.emissiveTexture = getTexture(gltfMaterial.emissiveTexture, true);
+		material.emissiveColor = glm::make_vec3(gltfMaterial.emissiveFactor.data());
+		material.alpha = pbr.baseColorFactor[3];
+		material.alphaMode = static_cast<AlphaMode>(gltfMaterial.alphaMode);
+		material.alphaCutoff = gltfMaterial.alphaCutoff;
+		material.doubleSided = gltfMaterial.doubleSided;
+		gltfMaterials.push_back(&AddMaterial(std::move(material), gltfMaterial.name));
+	}
+
+	std::vector<MeshRange> meshRanges{};
+	meshRanges.reserve(gltf.meshes.size());
+	for (const fx::gltf::Mesh& gltfMesh : gltf.meshes)
+	{
+		const int32_t first = static_cast<int32_t>(meshes.size());
+		ConvertMesh(gltf, gltfMesh, gltfMaterials);
+		meshRanges.push_back(MeshRange{ first, static_cast<int32_t>(meshes.size()) });
+	}
+
+	SceneGraph graph{};
+	const fx::gltf::Scene& scene = gltf.scenes[sceneIndex];
+	std::vector<uint32_t> graphNodes(gltf.nodes.size(), invalidNode);
 	
 	for (const uint32_t nodeIndex : scene.nodes)
 	{		
-		ParseNode(gltf, gltf.nodes[nodeIndex]);
+		ParseNode(gltf, nodeIndex, invalidNode, meshRanges, graphNodes, graph);
+	}
+
+	for (const fx::gltf::Animation& gltfAnimation : gltf.animations)
+	{
+		Animation animation = ConvertAnimation(gltf, gltfAnimation, graphNodes);
+		if (!animation.channels.empty())
+		{
+			graph.animations.push_back(std::move(animation));
+		}
 	}
+
+	return graph;
 }
 
-void ResourceManager::ParseNode(const fx::gltf::Document& gltf, const fx::gltf::Node& node)
+void ResourceManager::ParseNode(const fx::gltf::Document& gltf, uint32_t nodeIndex, uint32_t parent, gsl::span<const MeshRange> meshRanges, gsl::span<uint32_t> graphNodes, SceneGraph& graph)
 {
-	if (node.mesh != -1)
+	const fx::gltf::Node& node = gltf.nodes[nodeIndex];
+
+	NodeTransform transform{};
+	if (node.matrix != fx::gltf::defaults::IdentityMatrix)
+	{
+		transform = Decompose(glm::make_mat4(node.matrix.data()));
+	}
+	else
 	{
-		ConvertMesh(gltf, gltf.meshes[node.mesh]);
+		transform.translation = glm::make_vec3(node.translation.data());
+		transform.rotation = glm::quat{ node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2] };
+		transform.scale = glm::make_vec3(node.scale.data());
 	}
 
-	for (const uint32_t nodeIndex : node.children)
+	const MeshRange meshRange = node.mesh != -1 ? meshRanges[node.mesh] : MeshRange{ -1, -1 };
+	const uint32_t graphNode = AddNode(graph, parent, transform, meshRange.first < meshRange.end ? meshRange.first : -1, node.name);
+	graphNodes[nodeIndex] = graphNode;
+
+	// The other parts of a mesh split by material follow the node without
+	// a transform of their own.
+	for (int32_t part{ meshRange.first + 1 }; part < meshRange.end; ++part)
 	{
-		ParseNode(gltf, gltf.nodes[nodeIndex]);
+		CloseNode(graph, AddNode(graph, graphNode, NodeTransform{}, part, node.name));
 	}
+
+	for (const int32_t childIndex : node.children)
+	{
+		ParseNode(gltf, static_cast<uint32_t>(childIndex), graphNode, meshRanges, graphNodes, graph);
+	}
+
+	CloseNode(graph, graphNode);
 }
 
-void ResourceManager::ConvertMesh(const fx::gltf::Document& gltf, const fx::gltf::Mesh gltfMesh)
+void ResourceManager::ConvertMesh(const fx::gltf::Document& gltf, const fx::gltf::Mesh gltfMesh, gsl::span<const Material* const> gltfMaterials)
 {
-	Resource<Mesh>& meshResource = meshes.emplace_back();
-	meshResource.value = std::make_unique<Mesh>();
-	meshResource.name = gltfMesh.name;
+	LUX_PROFILE_ZONE("ConvertMesh");
 
+	// Objects have a single material, so triangle primitives are grouped by
+	// theirs into one mesh each, in the order the materials first appear.
+	std::vector<int32_t> groupMaterials{};
 	for (const fx::gltf::Primitive& primitve : gltfMesh.primitives)
 	{
-		const fx::gltf::Accessor& indicesAccessor = gltf.accessors[primitve.indices];
-		const fx::gltf::BufferView& indicesBufferView = gltf.bufferViews[indicesAccessor.bufferView];
-		const fx::gltf::Buffer& indicesBuffer = gltf.buffers[indicesBufferView.buffer];
-		const uint8_t* indecesbufferViewStart = indicesBuffer.data.data() + indicesBufferView.byteOffset;
-		
-		gsl::span<const uint8_t, gsl::dynamic_extent> indicesData
+		if (primitve.mode == fx::gltf::Primitive::Mode::Triangles && std::find(groupMaterials.begin(), groupMaterials.end(), primitve.material) == groupMaterials.end())
 		{
-			indecesbufferViewStart + indicesAccessor.byteOffset,
-			indecesbufferViewStart + indicesBufferView.byteLength
-		};
+			groupMaterials.push_back(primitve.material);
+		}
+	}
+
+	for (size_t group{ 0 }; group < groupMaterials.size(); ++group)
+	{
+		const int32_t groupMaterial = groupMaterials[group];
+		Resource<Mesh>& meshResource = meshes.emplace_back();
+		meshResource.value = std::make_unique<Mesh>();
+		meshResource.id = static_cast<uint32_t>(meshes.size() - 1);
+		meshResource.name = group == 0 ? gltfMesh.name : gltfMesh.name + '#' + std::to_string(group);
+		meshMaterials.push_back(groupMaterial >= 0 ? gltfMaterials[groupMaterial] : nullptr);
+		Mesh& mesh = *meshResource.value;
 
-		std::vector<uint16_t> indices{};
-		indices.resize(static_cast<size_t>(indicesAccessor.count));
+		bool hasNormals{ false };
+		bool hasTangents{ false };
+		bool hasTexcoords{ false };
 
-		for (uint32_t i{ 0 }; i < indicesAccessor.count; ++i)
+		for (const fx::gltf::Primitive& primitve : gltfMesh.primitives)
 		{
-			uint32_t index = i * sizeof(uint16_t);
+			if (primitve.mode != fx::gltf::Primitive::Mode::Triangles || primitve.material != groupMaterial)
+			{
+				continue;
+			}
 
-			std::memcpy(&(indices[i]), &(indicesData[index]), sizeof(uint16_t));
-		}
+			const std::vector<glm::vec3> positions = ReadAccessor<glm::vec3>(gltf, primitve.attributes.at("POSITION"));
+			const std::vector<uint32_t> indices = ReadIndices(gltf, primitve, positions.size());
 
-		const fx::gltf::Accessor& positionAccessor = gltf.accessors[primitve.attributes.at("POSITION")];
-		const fx::gltf::BufferView& positionBufferView = gltf.bufferViews[positionAccessor.bufferView];
-		const fx::gltf::Buffer& positionBuffer = gltf.buffers[positionBufferView.buffer];
-		const uint8_t* positionBufferViewStart = positionBuffer.data.data() + positionBufferView.byteOffset;
+			// Attributes a primitive lacks are zero, which makes hits fall back
+			// to the geometric normal.
+			const auto readAttribute = [&](const char* name, auto& attribute, bool& hasAttribute)
+			{
+				using Vector = typename std::remove_reference_t<decltype(attribute)>::value_type;
+				const auto accessor = primitve.attributes.find(name);
+				const std::vector<Vector> values = accessor != primitve.attributes.end() ? ReadAccessor<Vector>(gltf, accessor->second) : std::vector<Vector>(positions.size(), Vector{ 0.0f });
+				hasAttribute = hasAttribute || accessor != primitve.attributes.end();
 
-		gsl::span<const uint8_t, gsl::dynamic_extent> positionData
-		{
-			positionBufferViewStart + positionAccessor.byteOffset,
-			positionBufferViewStart + positionBufferView.byteLength
-		};
+				attribute.reserve(attribute.size() + indices.size());
+				for (const uint32_t index : indices)
+				{
+					attribute.push_back(values[index]);
+				}
+			};
+
+			readAttribute("NORMAL", mesh.normals, hasNormals);
+			readAttribute("TANGENT", mesh.tangents, hasTangents);
+			readAttribute("TEXCOORD_0", mesh.texcoords, hasTexcoords);
 
-		std::vector<glm::vec3> positions{};
-		positions.resize(static_cast<size_t>(positionAccessor.count));
+			mesh.posistions.reserve(mesh.posistions.size() + indices.size());
+			for (const uint32_t index : indices)
+			{
+				mesh.posistions.push_back(positions[index]);
+			}
+		}
 
-		for (uint32_t positionIndex{ 0 }; positionIndex < positionAccessor.count; ++positionIndex)
+		if (!hasNormals)
+		{
+			mesh.normals.clear();
+		}
+		if (!hasTangents)
 		{
-			uint32_t index = positionIndex * sizeof(glm::vec3);
+			mesh.tangents.clear();
+		}
+		if (!hasTexcoords)
+		{
+			mesh.texcoords.clear();
+		}
 
-			std::memcpy(&(positions[positionIndex]), &(positionData[index]), sizeof(glm::vec3));
+		if (importSettings.quantizeAttributes)
+		{
+			QuantizeAttributes(mesh);
 		}
 
-		const fx::gltf::Accessor& normalAccessor = gltf.accessors[primitve.attributes.at("NORMAL")];
-		const fx::gltf::BufferView& normalBufferView = gltf.bufferViews[normalAccessor.bufferView];
-		const fx::gltf::Buffer& normalBuffer = gltf.buffers[normalBufferView.buffer];
-		const uint8_t* normalBufferViewStart = normalBuffer.data.data() + normalBufferView.byteOffset;
+		BuildMeshBvh(mesh);
+		ReorderTriangles(mesh);
+	}
+}
 
-		gsl::span<const uint8_t, gsl::dynamic_extent> normalData
-		{
-			normalBufferViewStart + normalAccessor.byteOffset,
-			normalBufferViewStart + normalBufferView.byteLength
-		};
+const Texture* ResourceManager::ConvertTexture(const fx::gltf::Document& gltf, const std::filesystem::path& gltfPath, uint32_t textureIndex, bool srgb)
+{
+	LUX_PROFILE_ZONE("ConvertTexture");
 
-		std::vector<glm::vec3> normals{};
-		normals.resize(static_cast<size_t>(normalAccessor.count));
+	const fx::gltf::Texture& gltfTexture = gltf.textures[textureIndex];
+	const fx::gltf::Image& image = gltf.images[gltfTexture.source];
+	const fx::gltf::Sampler sampler = gltfTexture.sampler >= 0 ? gltf.samplers[gltfTexture.sampler] : fx::gltf::Sampler{};
+	const bool externalImage = !image.uri.empty() && !image.IsEmbeddedResource();
+	const std::filesystem::path sourcePath = externalImage ? gltfPath.parent_path() / image.uri : gltfPath;
+
+	const auto addTexture = [&](Texture&& texture)
+	{
+		Resource<Texture>& textureResource = textures.emplace_back();
+		textureResource.value = std::make_unique<Texture>(std::move(texture));
+		textureResource.id = static_cast<uint32_t>(textures.size() - 1);
+		textureResource.name = externalImage ? image.uri : image.name;
+		return textureResource.value.get();
+	};
 
-		for (uint32_t normalIndex{ 0 }; normalIndex < normalAccessor.count; ++normalIndex)
+	std::optional<CacheKey> cacheKey{};
+	std::filesystem::path tiledPath{};
+	if (textureCache)
+	{
+		cacheKey = MakeCacheKey(sourcePath, '#' + std::to_string(gltfTexture.source) + '#' + std::to_string(gltfTexture.sampler) + (srgb ? "#srgb" : ""));
+	}
+	if (cacheKey)
+	{
+		tiledPath = CachePath(importSettings.cacheDirectory, *cacheKey, ".luxtex");
+		if (std::optional<Texture> cached = textureCache->Open(tiledPath, *cacheKey))
 		{
-			uint32_t index = normalIndex * sizeof(glm::vec3);
+			return addTexture(std::move(*cached));
+		}
+	}
 
-			std::memcpy(&(positions[normalIndex]), &(positionData[index]), sizeof(glm::vec3));
+	std::optional<Rgba8Image> decoded{};
+	if (externalImage)
+	{
+		decoded = ReadPng(sourcePath);
+	}
+	else if (image.uri.empty())
+	{
+		const fx::gltf::BufferView& bufferView = gltf.bufferViews[image.bufferView];
+		const fx::gltf::Buffer& buffer = gltf.buffers[bufferView.buffer];
+		decoded = DecodePng(gsl::span<const uint8_t>{ buffer.data.data() + bufferView.byteOffset, bufferView.byteLength });
+	}
+	else
+	{
+		std::vector<uint8_t> data{};
+		image.MaterializeData(data);
+		decoded = DecodePng(data);
+	}
+
+	if (!decoded)
+	{
+		std::printf("Failed to load texture %s\n", externalImage ? image.uri.c_str() : image.name.c_str());
+		return nullptr;
+	}
+
+	Texture texture = MakeTexture(*decoded, srgb, ConvertWrap(sampler.wrapS), ConvertWrap(sampler.wrapT));
+	if (cacheKey && WriteTiledTexture(texture, *cacheKey, tiledPath))
+	{
+		if (std::optional<Texture> cached = textureCache->Open(tiledPath, *cacheKey))
+		{
+			texture = std::move(*cached);
 		}
+	}
+
+	return addTexture(std::move(texture));
+}
+
+const Mesh& ResourceManager::AddMesh(Mesh&& mesh, std::string name)
+{
+	Resource<Mesh>& meshResource = meshes.emplace_back();
+	meshResource.value = std::make_unique<Mesh>(std::move(mesh));
+	meshResource.id = static_cast<uint32_t>(meshes.size() - 1);
+	meshResource.name = std::move(name);
+	meshMaterials.push_back(nullptr);
+	BuildMeshBvh(*meshResource.value);
+	ReorderTriangles(*meshResource.value);
+
+	return *meshResource.value;
+}
+
+const Material& ResourceManager::AddMaterial(Material&& material, std::string name)
+{
+	Resource<Material>& materialResource = materials.emplace_back();
+	materialResource.value = std::make_unique<Material>(std::move(material));
+	materialResource.id = static_cast<uint32_t>(materials.size() - 1);
+	materialResource.name = std::move(name);
+
+	return *materialResource.value;
+}
+
+const EnvironmentMap* ResourceManager::LoadEnvironment(const std::filesystem::path& filePath)
+{
+	LUX_PROFILE_ZONE("LoadEnvironment");
 
-		meshResource.value->posistions.reserve(indices.size());
-		for (uint32_t index : indices)
+	std::optional<CacheKey> cacheKey{};
+	std::filesystem::path cachePath{};
+	std::optional<EnvironmentMap> environment{};
+	if (!importSettings.cacheDirectory.empty())
+	{
+		cacheKey = MakeCacheKey(filePath);
+	}
+	if (cacheKey)
+	{
+		cachePath = CachePath(importSettings.cacheDirectory, *cacheKey, ".luxenv");
+		environment = ReadEnvironmentCache(cachePath, *cacheKey);
+	}
+
+	if (!environment)
+	{
+		environment = LoadEnvironmentMap(filePath);
+		if (!environment)
+		{
+			std::printf("Failed to load environment %s\n", filePath.string().c_str());
+			return nullptr;
+		}
+		if (cacheKey)
 		{
-			meshResource.value->posistions.push_back(positions[index]);
-			meshResource.value->normals.push_back(normals[index]);
+			WriteEnvironmentCache(*environment, *cacheKey, cachePath);
 		}
 	}
+
+	Resource<EnvironmentMap>& environmentResource = environments.emplace_back();
+	environmentResource.value = std::make_unique<EnvironmentMap>(std::move(*environment));
+	environmentResource.id = static_cast<uint32_t>(environments.size() - 1);
+	environmentResource.name = filePath.filename().string();
+	return environmentResource.value.get();
 }
 
 const Mesh& ResourceManager::GetMeshByIndex(size_t index)
@@ -117,6 +565,25 @@ const Mesh& ResourceManager::GetMeshByIndex(size_t index)
 	return *(meshes[index].value);
 }
 
+const size_t ResourceManager::GetMeshCount() const noexcept
+{
+	return meshes.size();
+}
+
+const Material* ResourceManager::GetMeshMaterial(size_t index) const noexcept
+{
+	return meshMaterials[index];
+}
+
+const std::optional<TextureCacheReport> ResourceManager::GetTextureCacheReport() const noexcept
+{
+	if (!textureCache)
+	{
+		return std::nullopt;
+	}
+	return textureCache->Report();
+}
+
 const Mesh& ResourceManager::GetMeshByName(std::string_view name)
 {
 	for (auto& meshResource : meshes)
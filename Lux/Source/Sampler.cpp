@@ -0,0 +1,346 @@
+#include "Sampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	constexpr int32_t blueNoiseSize = 64;
+	constexpr uint32_t blueNoiseTexels = blueNoiseSize * blueNoiseSize;
+
+	// Chris Wellons' lowbias32.
+	const uint32_t Hash(uint32_t value) noexcept
+	{
+		value ^= value >> 16;
+		value *= 0x7feb352du;
+		value ^= value >> 15;
+		value *= 0x846ca68bu;
+		value ^= value >> 16;
+		return value;
+	}
+
+	const uint32_t HashCombine(uint32_t seed, uint32_t value) noexcept
+	{
+		return Hash(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+	}
+
+	const float ToFloat(uint32_t value) noexcept
+	{
+		return static_cast<float>(value >> 8) * 0x1.0p-24f;
+	}
+
+	// Element index of a random permutation of count elements picked by seed
+	// (Kensler, "Correlated Multi-Jittered Sampling").
+	const uint32_t Permute(uint32_t index, uint32_t count, uint32_t seed) noexcept
+	{
+		uint32_t mask = count - 1;
+		mask |= mask >> 1;
+		mask |= mask >> 2;
+		mask |= mask >> 4;
+		mask |= mask >> 8;
+		mask |= mask >> 16;
+		do
+		{
+			index ^= seed;
+			index *= 0xe170893du;
+			index ^= seed >> 16;
+			index ^= (index & mask) >> 4;
+			index ^= seed >> 8;
+			index *= 0x0929eb3fu;
+			index ^= seed >> 23;
+			index ^= (index & mask) >> 1;
+			index *= 1 | seed >> 27;
+			index *= 0x6935fa69u;
+			index ^= (index & mask) >> 11;
+			index *= 0x74dcb303u;
+			index ^= (index & mask) >> 2;
+			index *= 0x9e501cc3u;
+			index ^= (index & mask) >> 2;
+			index *= 0xc860a3dfu;
+			index &= mask;
+			index ^= index >> 5;
+		} while (index >= count);
+		return (index + seed) % count;
+	}
+
+	const uint32_t ReverseBits(uint32_t value) noexcept
+	{
+		value = (value << 16) | (value >> 16);
+		value = ((value & 0x00ff00ffu) << 8) | ((value & 0xff00ff00u) >> 8);
+		value = ((value & 0x0f0f0f0fu) << 4) | ((value & 0xf0f0f0f0u) >> 4);
+		value = ((value & 0x33333333u) << 2) | ((value & 0xccccccccu) >> 2);
+		return ((value & 0x55555555u) << 1) | ((value & 0xaaaaaaaau) >> 1);
+	}
+
+	// Owen scrambling of a 32 bit fraction: every bit is flipped depending on
+	// the bits above it. The Laine-Karras hash only carries bits upwards, so
+	// it runs on the reversed value.
+	const uint32_t NestedUniformScramble(uint32_t value, uint32_t seed) noexcept
+	{
+		value = ReverseBits(value);
+		value += seed;
+		value ^= value * 0x6c50b47cu;
+		value ^= value * 0xb82f1e52u;
+		value ^= value * 0xc7afe638u;
+		value ^= value * 0x8d22f6e6u;
+		return ReverseBits(value);
+	}
+
+	// First two Sobol dimensions, van der Corput and the one built from the
+	// polynomial x + 1. Together they are a (0, 2)-sequence.
+	const std::array<uint32_t, 2> Sobol(uint32_t index) noexcept
+	{
+		std::array<uint32_t, 2> point{ ReverseBits(index), 0 };
+		for (uint32_t direction{ 0x80000000u }; index != 0; index >>= 1, direction ^= direction >> 1)
+		{
+			if (index & 1)
+			{
+				point[1] ^= direction;
+			}
+		}
+		return point;
+	}
+
+	// Void and cluster (Ulichney, "The void-and-cluster method for dither
+	// array generation") on a torus: texels are ranked by inserting each one
+	// where the pattern has its largest gap. Values are the ranks spread over
+	// [0, 1).
+	const std::vector<float> MakeBlueNoise()
+	{
+		constexpr float sigma = 1.5f;
+		constexpr int32_t wrapMask = blueNoiseSize - 1;
+
+		std::vector<float> kernel(blueNoiseTexels);
+		for (int32_t y{ 0 }; y < blueNoiseSize; ++y)
+		{
+			for (int32_t x{ 0 }; x < blueNoiseSize; ++x)
+			{
+				const float distanceX = static_cast<float>(std::min(x, blueNoiseSize - x));
+				const float distanceY = static_cast<float>(std::min(y, blueNoiseSize - y));
+				kernel[y * blueNoiseSize + x] = std::exp(-(distanceX * distanceX + distanceY * distanceY) / (2.0f * sigma * sigma));
+			}
+		}
+
+		std::vector<uint8_t> pattern(blueNoiseTexels, 0);
+		std::vector<float> energy(blueNoiseTexels, 0.0f);
+		const auto toggle = [&](uint32_t texel)
+		{
+			pattern[texel] ^= 1;
+			const float sign = pattern[texel] ? 1.0f : -1.0f;
+			const int32_t texelX = static_cast<int32_t>(texel) % blueNoiseSize;
+			const int32_t texelY = static_cast<int32_t>(texel) / blueNoiseSize;
+			for (int32_t y{ 0 }; y < blueNoiseSize; ++y)
+			{
+				for (int32_t x{ 0 }; x < blueNoiseSize; ++x)
+				{
+					energy[y * blueNoiseSize + x] += sign * kernel[((y - texelY) & wrapMask) * blueNoiseSize + ((x - texelX) & wrapMask)];
+				}
+			}
+		};
+		// Set texel in the densest cluster, or unset texel in the largest void.
+		const auto extreme = [&](uint8_t set)
+		{
+			uint32_t best{ 0 };
+			float bestEnergy = set ? -1.0f : std::numeric_limits<float>::max();
+			for (uint32_t texel{ 0 }; texel < blueNoiseTexels; ++texel)
+			{
+				if (pattern[texel] == set && (set ? energy[texel] > bestEnergy : energy[texel] < bestEnergy))
+				{
+					best = texel;
+					bestEnergy = energy[texel];
+				}
+			}
+			return best;
+		};
+
+		constexpr uint32_t initialCount = blueNoiseTexels / 10;
+		RandomGenerator random = SeedRandom(0x626c7565);
+		for (uint32_t placed{ 0 }; placed < initialCount;)
+		{
+			const uint32_t texel = NextUint(random) % blueNoiseTexels;
+			if (!pattern[texel])
+			{
+				toggle(texel);
+				++placed;
+			}
+		}
+
+		// Moves points from clusters into voids until that changes nothing.
+		while (true)
+		{
+			const uint32_t cluster = extreme(1);
+			toggle(cluster);
+			const uint32_t gap = extreme(0);
+			toggle(gap);
+			if (gap == cluster)
+			{
+				break;
+			}
+		}
+
+		const std::vector<uint8_t> prototype = pattern;
+		const std::vector<float> prototypeEnergy = energy;
+		std::vector<uint32_t> ranks(blueNoiseTexels);
+		for (uint32_t rank{ initialCount }; rank-- > 0;)
+		{
+			const uint32_t cluster = extreme(1);
+			toggle(cluster);
+			ranks[cluster] = rank;
+		}
+
+		pattern = prototype;
+		energy = prototypeEnergy;
+		for (uint32_t rank{ initialCount }; rank < blueNoiseTexels; ++rank)
+		{
+			const uint32_t gap = extreme(0);
+			toggle(gap);
+			ranks[gap] = rank;
+		}
+
+		std::vector<float> noise(blueNoiseTexels);
+		for (uint32_t texel{ 0 }; texel < blueNoiseTexels; ++texel)
+		{
+			noise[texel] = (static_cast<float>(ranks[texel]) + 0.5f) / static_cast<float>(blueNoiseTexels);
+		}
+		return noise;
+	}
+
+	const std::vector<float>& BlueNoise()
+	{
+		static const std::vector<float> noise = MakeBlueNoise();
+		return noise;
+	}
+
+	// Each dimension reads the mask at its own toroidal offset.
+	const float BlueNoiseOffset(const Sampler& sampler, uint32_t dimension) noexcept
+	{
+		const uint32_t offset = Hash(dimension + 1);
+		const uint32_t x = (static_cast<uint32_t>(sampler.x) + offset) & (blueNoiseSize - 1);
+		const uint32_t y = (static_cast<uint32_t>(sampler.y) + (offset >> 16)) & (blueNoiseSize - 1);
+		return BlueNoise()[y * blueNoiseSize + x];
+	}
+
+	const float Rotate(float value, float offset) noexcept
+	{
+		const float sum = value + offset;
+		return sum < 1.0f ? sum : sum - 1.0f;
+	}
+}
+
+const Sampler StartPixelSample(const SamplerSettings& settings, int32_t x, int32_t y, uint32_t sampleIndex) noexcept
+{
+	// Blue noise needs the same sequence in every pixel, the mask is what
+	// tells pixels apart.
+	const uint32_t pixelSeed = settings.type == SamplerType::BlueNoise ? Hash(settings.seed) : HashCombine(HashCombine(Hash(settings.seed), static_cast<uint32_t>(x)), static_cast<uint32_t>(y));
+	RandomGenerator random{};
+	if (settings.type == SamplerType::Independent || settings.type == SamplerType::Stratified)
+	{
+		random = SeedRandom(static_cast<uint64_t>(static_cast<uint32_t>(y)) << 32 | static_cast<uint32_t>(x), static_cast<uint64_t>(settings.seed) << 32 | sampleIndex);
+	}
+	return Sampler{ settings.type, sampleIndex, settings.samplesPerPixel, pixelSeed, 0, x, y, random };
+}
+
+const float NextSample1D(Sampler& sampler) noexcept
+{
+	const uint32_t dimension = sampler.dimension++;
+	const uint32_t dimensionSeed = HashCombine(sampler.seed, dimension);
+
+	switch (sampler.type)
+	{
+	case SamplerType::Stratified:
+	{
+		const uint32_t stratum = Permute(sampler.sampleIndex % sampler.sampleCount, sampler.sampleCount, dimensionSeed);
+		return (static_cast<float>(stratum) + NextFloat(sampler.random)) / static_cast<float>(sampler.sampleCount);
+	}
+	case SamplerType::Sobol:
+	{
+		const uint32_t index = NestedUniformScramble(sampler.sampleIndex, dimensionSeed);
+		return ToFloat(NestedUniformScramble(Sobol(index)[0], HashCombine(dimensionSeed, 0)));
+	}
+	case SamplerType::BlueNoise:
+	{
+		const uint32_t index = NestedUniformScramble(sampler.sampleIndex, dimensionSeed);
+		return Rotate(ToFloat(Sobol(index)[0]), BlueNoiseOffset(sampler, 2 * dimension));
+	}
+	case SamplerType::Independent:
+	default:
+		return NextFloat(sampler.random);
+	}
+}
+
+const glm::vec2 NextSample2D(Sampler& sampler) noexcept
+{
+	const uint32_t dimension = sampler.dimension++;
+	const uint32_t dimensionSeed = HashCombine(sampler.seed, dimension);
+
+	switch (sampler.type)
+	{
+	case SamplerType::Stratified:
+	{
+		// The grid closest to square that holds every sample, left over
+		// cells stay empty.
+		const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(sampler.sampleCount))));
+		const uint32_t rows = (sampler.sampleCount + columns - 1) / columns;
+		const uint32_t cell = Permute(sampler.sampleIndex % (columns * rows), columns * rows, dimensionSeed);
+		const float jitterX = NextFloat(sampler.random);
+		const float jitterY = NextFloat(sampler.random);
+		return glm::vec2{ (static_cast<float>(cell % columns) + jitterX) / static_cast<float>(columns), (static_cast<float>(cell / columns) + jitterY) / static_cast<float>(rows) };
+	}
+	case SamplerType::Sobol:
+	{
+		const std::array<uint32_t, 2> point = Sobol(NestedUniformScramble(sampler.sampleIndex, dimensionSeed));
+		return glm::vec2{ ToFloat(NestedUniformScramble(point[0], HashCombine(dimensionSeed, 0))), ToFloat(NestedUniformScramble(point[1], HashCombine(dimensionSeed, 1))) };
+	}
+	case SamplerType::BlueNoise:
+	{
+		const std::array<uint32_t, 2> point = Sobol(NestedUniformScramble(sampler.sampleIndex, dimensionSeed));
+		return glm::vec2{ Rotate(ToFloat(point[0]), BlueNoiseOffset(sampler, 2 * dimension)), Rotate(ToFloat(point[1]), BlueNoiseOffset(sampler, 2 * dimension + 1)) };
+	}
+	case SamplerType::Independent:
+	default:
+	{
+		const float u = NextFloat(sampler.random);
+		return glm::vec2{ u, NextFloat(sampler.random) };
+	}
+	}
+}
+
+const std::optional<SamplerType> ParseSamplerType(std::string_view name) noexcept
+{
+	if (name == "independent")
+	{
+		return SamplerType::Independent;
+	}
+	if (name == "stratified")
+	{
+		return SamplerType::Stratified;
+	}
+	if (name == "sobol")
+	{
+		return SamplerType::Sobol;
+	}
+	if (name == "bluenoise")
+	{
+		return SamplerType::BlueNoise;
+	}
+	return std::nullopt;
+}
+
+const char* SamplerTypeName(SamplerType type) noexcept
+{
+	switch (type)
+	{
+	case SamplerType::Stratified:
+		return "stratified";
+	case SamplerType::Sobol:
+		return "sobol";
+	case SamplerType::BlueNoise:
+		return "bluenoise";
+	case SamplerType::Independent:
+	default:
+		return "independent";
+	}
+}
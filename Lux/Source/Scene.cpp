@@ -1 +1,359 @@
 #include "Scene.h"
+#include "Profiler.h"
+#include "Texture.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+	const BvhBuildSettings sceneBvhSettings{ 1 };
+
+	const Bounds ComputeObjectBounds(const Scene& scene, size_t objectIndex) noexcept
+	{
+		const Object& object = scene.objects[objectIndex];
+		return Transform(ComputeBounds(*scene.meshes[object.meshID]), object.worldFromObject);
+	}
+
+	// Bounds at shutter open and close, grown so that interpolating them
+	// contains the object at every time in between. Translation moves each
+	// point linearly, so only rotation and scale make it leave the chord
+	// between its end positions. For a point at v(t) = mix(v0, v1, t) in the
+	// rotated frame, the distance to that chord splits into the sagitta of
+	// the arc v(t) sweeps, r (1 - cos(angle / 2)) with r bounding |v|, and
+	// t (1 - t) (R0 - R1)(v1 - v0), at most sin(angle / 2) |v1 - v0| / 2.
+	const std::array<Bounds, 2> ComputeObjectMotionBounds(const Scene& scene, size_t objectIndex) noexcept
+	{
+		const Object& object = scene.objects[objectIndex];
+		const ObjectMotion& motion = scene.motions[object.motionID];
+		const Bounds meshBounds = ComputeBounds(*scene.meshes[object.meshID]);
+		std::array<Bounds, 2> bounds{ Transform(meshBounds, ToMatrix(motion.start)), Transform(meshBounds, ToMatrix(motion.end)) };
+		if (IsEmpty(meshBounds))
+		{
+			return bounds;
+		}
+
+		// Slerp takes the shorter way round, so the angle is at most pi.
+		const float cosHalfAngle = std::min(std::abs(glm::dot(motion.start.rotation, motion.end.rotation)), 1.0f);
+		const float sinHalfAngle = std::sqrt(1.0f - cosHalfAngle * cosHalfAngle);
+
+		// Both lengths are convex in the point, so a corner of the mesh
+		// bounds reaches their maximum.
+		const glm::vec3 largestScale = glm::max(glm::abs(motion.start.scale), glm::abs(motion.end.scale));
+		const glm::vec3 scaleChange = motion.end.scale - motion.start.scale;
+		float radius{ 0.0f };
+		float scaleShift{ 0.0f };
+		for (uint32_t corner{ 0 }; corner < 8; ++corner)
+		{
+			const glm::vec3 point
+			{
+				(corner & 1) != 0 ? meshBounds.maximum.x : meshBounds.minimum.x,
+				(corner & 2) != 0 ? meshBounds.maximum.y : meshBounds.minimum.y,
+				(corner & 4) != 0 ? meshBounds.maximum.z : meshBounds.minimum.z
+			};
+			radius = std::max(radius, glm::length(largestScale * point));
+			scaleShift = std::max(scaleShift, glm::length(scaleChange * point));
+		}
+
+		// A little extra covers rounding in slerp and the transforms.
+		const float padding = radius * (1.0f - cosHalfAngle) + 0.5f * sinHalfAngle * scaleShift + 1e-5f * radius;
+		for (Bounds& end : bounds)
+		{
+			end.minimum -= glm::vec3{ padding };
+			end.maximum += glm::vec3{ padding };
+		}
+		return bounds;
+	}
+
+	const glm::mat4 ToInverseMatrix(const NodeTransform& transform) noexcept
+	{
+		return glm::scale(glm::mat4{ 1.0f }, 1.0f / transform.scale) * glm::mat4_cast(glm::conjugate(transform.rotation)) * glm::translate(glm::mat4{ 1.0f }, -transform.translation);
+	}
+
+	template <typename T>
+	const uint32_t FindOrAdd(std::vector<const T*>& table, const T& value)
+	{
+		auto it = std::find(table.begin(), table.end(), &value);
+		if (it != table.end())
+		{
+			return static_cast<uint32_t>(it - table.begin());
+		}
+
+		table.push_back(&value);
+		return static_cast<uint32_t>(table.size() - 1);
+	}
+}
+
+const uint32_t AddObject(Scene& scene, const Mesh& mesh, const Material& material, const glm::mat4& worldFromObject)
+{
+	scene.objects.push_back(Object
+	{
+		worldFromObject,
+		glm::inverse(worldFromObject),
+		FindOrAdd(scene.meshes, mesh),
+		AddMaterial(scene.materials, material)
+	});
+
+	return static_cast<uint32_t>(scene.objects.size() - 1);
+}
+
+void SetObjectTransform(Scene& scene, uint32_t objectIndex, const glm::mat4& worldFromObject) noexcept
+{
+	Object& object = scene.objects[objectIndex];
+	object.worldFromObject = worldFromObject;
+	object.objectFromWorld = glm::inverse(worldFromObject);
+	object.motionID = noMotion;
+}
+
+void SetObjectMotion(Scene& scene, uint32_t objectIndex, const NodeTransform& start, const NodeTransform& end)
+{
+	Object& object = scene.objects[objectIndex];
+	object.worldFromObject = ToMatrix(start);
+	object.objectFromWorld = ToInverseMatrix(start);
+	if (object.motionID == noMotion)
+	{
+		object.motionID = static_cast<uint32_t>(scene.motions.size());
+		scene.motions.emplace_back();
+	}
+	scene.motions[object.motionID] = ObjectMotion{ start, end };
+}
+
+const Object ObjectAtTime(const Scene& scene, uint32_t objectIndex, float time) noexcept
+{
+	Object object = scene.objects[objectIndex];
+	if (object.motionID != noMotion)
+	{
+		const ObjectMotion& motion = scene.motions[object.motionID];
+		const NodeTransform transform = InterpolateTransform(motion.start, motion.end, time);
+		object.worldFromObject = ToMatrix(transform);
+		object.objectFromWorld = ToInverseMatrix(transform);
+	}
+	return object;
+}
+
+const glm::mat4 ToMatrix(const NodeTransform& transform) noexcept
+{
+	return glm::translate(glm::mat4{ 1.0f }, transform.translation) * glm::mat4_cast(transform.rotation) * glm::scale(glm::mat4{ 1.0f }, transform.scale);
+}
+
+const NodeTransform InterpolateTransform(const NodeTransform& start, const NodeTransform& end, float time) noexcept
+{
+	return NodeTransform
+	{
+		glm::mix(start.translation, end.translation, time),
+		glm::slerp(start.rotation, end.rotation, time),
+		glm::mix(start.scale, end.scale, time)
+	};
+}
+
+void BuildAccelerationStructure(Scene& scene)
+{
+	LUX_PROFILE_ZONE("BuildAccelerationStructure");
+
+	// Objects that were stopped leave their motion behind.
+	std::vector<ObjectMotion> motions{};
+	for (Object& object : scene.objects)
+	{
+		if (object.motionID != noMotion)
+		{
+			motions.push_back(scene.motions[object.motionID]);
+			object.motionID = static_cast<uint32_t>(motions.size() - 1);
+		}
+	}
+	scene.motions = std::move(motions);
+	const bool moving = !scene.motions.empty();
+
+	std::vector<Bounds>& primitiveBounds = scene.primitiveBounds;
+	primitiveBounds.clear();
+	scene.primitives.clear();
+	scene.objectPrimitives.assign(scene.objects.size(), invalidPrimitive);
+	// Parallel to primitiveBounds when anything moves.
+	std::vector<Bounds> primitiveEndBounds{};
+
+	auto addPrimitive = [&](PrimitiveType type, size_t index, const Bounds& bounds, const Bounds& endBounds)
+	{
+		if (!IsEmpty(bounds))
+		{
+			scene.primitives.push_back(PrimitiveReference{ type, static_cast<uint32_t>(index) });
+			primitiveBounds.push_back(bounds);
+			if (moving)
+			{
+				primitiveEndBounds.push_back(endBounds);
+			}
+		}
+	};
+
+	for (size_t index{ 0 }; index < scene.objects.size(); ++index)
+	{
+		std::array<Bounds, 2> bounds{};
+		if (scene.objects[index].motionID != noMotion)
+		{
+			bounds = ComputeObjectMotionBounds(scene, index);
+		}
+		else
+		{
+			bounds.fill(ComputeObjectBounds(scene, index));
+		}
+		if (!IsEmpty(bounds[0]))
+		{
+			scene.objectPrimitives[index] = static_cast<uint32_t>(scene.primitives.size());
+		}
+		addPrimitive(PrimitiveType::Object, index, bounds[0], bounds[1]);
+	}
+	for (size_t index{ 0 }; index < scene.spheres.size(); ++index)
+	{
+		const Bounds bounds = ComputeBounds(scene.spheres[index]);
+		addPrimitive(PrimitiveType::Sphere, index, bounds, bounds);
+	}
+	for (size_t index{ 0 }; index < scene.discs.size(); ++index)
+	{
+		const Bounds bounds = ComputeBounds(scene.discs[index]);
+		addPrimitive(PrimitiveType::Disc, index, bounds, bounds);
+	}
+	for (size_t index{ 0 }; index < scene.boxes.size(); ++index)
+	{
+		const Bounds bounds = ComputeBounds(scene.boxes[index]);
+		addPrimitive(PrimitiveType::Box, index, bounds, bounds);
+	}
+
+	if (moving)
+	{
+		std::vector<Bounds> middleBounds(primitiveBounds.size());
+		for (size_t primitive{ 0 }; primitive < primitiveBounds.size(); ++primitive)
+		{
+			middleBounds[primitive] = Interpolate(primitiveBounds[primitive], primitiveEndBounds[primitive], 0.5f);
+		}
+		scene.bvh = BuildBvh(middleBounds, sceneBvhSettings);
+		RefitMotionBvh(scene.bvh, primitiveBounds, primitiveEndBounds);
+	}
+	else
+	{
+		scene.bvh = BuildBvh(primitiveBounds, sceneBvhSettings);
+	}
+	scene.bvhTopology = ComputeTopology(scene.bvh);
+	scene.refitPrimitivesSinceCheck = 0;
+
+	BuildTriangleLights(scene);
+}
+
+void BuildTriangleLights(Scene& scene)
+{
+	LUX_PROFILE_ZONE("BuildTriangleLights");
+
+	scene.triangleLights.clear();
+	scene.objectLights.assign(scene.objects.size(), invalidLight);
+	std::vector<float> powers{};
+
+	for (uint32_t objectIndex{ 0 }; objectIndex < scene.objects.size(); ++objectIndex)
+	{
+		const Object& object = scene.objects[objectIndex];
+		const MaterialShading& shading = scene.materials.shading[object.materialID];
+		if (!(shading.flags & materialEmissive))
+		{
+			continue;
+		}
+
+		const Mesh& mesh = *scene.meshes[object.meshID];
+		const glm::vec3 emissiveColor = scene.materials.extras[object.materialID].emissiveColor;
+		const Texture* emissiveTexture = shading.emissiveTexture != noTexture ? scene.materials.textures[shading.emissiveTexture] : nullptr;
+		const bool hasTexcoords = !mesh.texcoords.empty() || !mesh.packedTexcoords.empty();
+
+		scene.objectLights[objectIndex] = static_cast<uint32_t>(scene.triangleLights.size());
+		const uint32_t triangleCount = static_cast<uint32_t>(mesh.posistions.size() / 3);
+		for (uint32_t triangleIndex{ 0 }; triangleIndex < triangleCount; ++triangleIndex)
+		{
+			const glm::vec3 vertex0{ object.worldFromObject * glm::vec4{ mesh.posistions[3 * triangleIndex], 1.0f } };
+			const glm::vec3 vertex1{ object.worldFromObject * glm::vec4{ mesh.posistions[3 * triangleIndex + 1], 1.0f } };
+			const glm::vec3 vertex2{ object.worldFromObject * glm::vec4{ mesh.posistions[3 * triangleIndex + 2], 1.0f } };
+			const float area = 0.5f * glm::length(glm::cross(vertex1 - vertex0, vertex2 - vertex0));
+
+			// Averages the texture over the triangle at the mip level where it
+			// covers about one texel, from the centroid and halfway to each
+			// vertex.
+			glm::vec3 emission = emissiveColor;
+			if (emissiveTexture && hasTexcoords)
+			{
+				const glm::vec2 texcoord0 = InterpolateTexcoord(mesh, triangleIndex, 0.0f, 0.0f);
+				const glm::vec2 edge1 = InterpolateTexcoord(mesh, triangleIndex, 1.0f, 0.0f) - texcoord0;
+				const glm::vec2 edge2 = InterpolateTexcoord(mesh, triangleIndex, 0.0f, 1.0f) - texcoord0;
+				const float levelOfDetail = 0.5f * std::log2(std::abs(edge1.x * edge2.y - edge1.y * edge2.x));
+
+				constexpr std::array<glm::vec2, 4> points
+				{
+					glm::vec2{ 1.0f / 3.0f, 1.0f / 3.0f },
+					glm::vec2{ 1.0f / 6.0f, 1.0f / 6.0f },
+					glm::vec2{ 2.0f / 3.0f, 1.0f / 6.0f },
+					glm::vec2{ 1.0f / 6.0f, 2.0f / 3.0f }
+				};
+				glm::vec3 average{ 0.0f };
+				for (const glm::vec2 point : points)
+				{
+					average += glm::vec3{ SampleTexture(*emissiveTexture, texcoord0 + point.x * edge1 + point.y * edge2, levelOfDetail) };
+				}
+				emission *= 0.25f * average;
+			}
+
+			scene.triangleLights.push_back(TriangleLight{ objectIndex, triangleIndex });
+			powers.push_back(area * glm::dot(emission, glm::vec3{ 0.2126f, 0.7152f, 0.0722f }));
+		}
+	}
+
+	scene.triangleLightTable = BuildAliasTable(powers);
+}
+
+const bool UpdateAccelerationStructure(Scene& scene, gsl::span<const uint32_t> changedObjects)
+{
+	LUX_PROFILE_ZONE("UpdateAccelerationStructure");
+
+	if (scene.objectPrimitives.size() != scene.objects.size() || !scene.motions.empty() || !scene.bvh.endBounds.empty())
+	{
+		BuildAccelerationStructure(scene);
+		return true;
+	}
+
+	std::vector<uint32_t> changedPrimitives{};
+	changedPrimitives.reserve(changedObjects.size());
+
+	for (const uint32_t objectIndex : changedObjects)
+	{
+		const uint32_t primitive = scene.objectPrimitives[objectIndex];
+		const Bounds bounds = ComputeObjectBounds(scene, objectIndex);
+
+		if (primitive == invalidPrimitive || IsEmpty(bounds))
+		{
+			if (primitive == invalidPrimitive && IsEmpty(bounds))
+			{
+				continue;
+			}
+
+			BuildAccelerationStructure(scene);
+			return true;
+		}
+
+		scene.primitiveBounds[primitive] = bounds;
+		changedPrimitives.push_back(primitive);
+	}
+
+	RefitBvh(scene.bvh, scene.bvhTopology, scene.primitiveBounds, changedPrimitives);
+
+	// Measuring the tree costs a pass over all nodes, so only do it once
+	// enough has changed to pay for it.
+	scene.refitPrimitivesSinceCheck += static_cast<uint32_t>(changedPrimitives.size());
+	if (scene.refitPrimitivesSinceCheck * 8 >= scene.primitives.size())
+	{
+		scene.refitPrimitivesSinceCheck = 0;
+		if (ComputeSahCost(scene.bvh, sceneBvhSettings) > bvhRebuildThreshold * scene.bvh.builtSahCost)
+		{
+			BuildAccelerationStructure(scene);
+			return true;
+		}
+	}
+
+	return false;
+}
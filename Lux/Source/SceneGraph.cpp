@@ -0,0 +1,136 @@
+#include "SceneGraph.h"
+#include "ResourceManager.h"
+
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+
+const uint32_t AddNode(SceneGraph& graph, uint32_t parent, const NodeTransform& transform, int32_t mesh, std::string name)
+{
+	const uint32_t node = static_cast<uint32_t>(graph.parents.size());
+
+	graph.parents.push_back(parent);
+	graph.subtreeEnds.push_back(node + 1);
+	graph.localTransforms.push_back(transform);
+	graph.worldMatrices.emplace_back(1.0f);
+	graph.dirtyFlags.push_back(1);
+	graph.meshes.push_back(mesh);
+	graph.objects.push_back(invalidObject);
+	graph.names.push_back(std::move(name));
+
+	return node;
+}
+
+void CloseNode(SceneGraph& graph, uint32_t node) noexcept
+{
+	graph.subtreeEnds[node] = static_cast<uint32_t>(graph.parents.size());
+}
+
+const NodeTransform Decompose(const glm::mat4& matrix) noexcept
+{
+	// glTF matrices are restricted to translation, rotation and scale.
+	NodeTransform transform{};
+	transform.translation = glm::vec3{ matrix[3] };
+
+	glm::mat3 rotation{ matrix };
+	transform.scale = glm::vec3{ glm::length(rotation[0]), glm::length(rotation[1]), glm::length(rotation[2]) };
+	if (glm::determinant(rotation) < 0.0f)
+	{
+		transform.scale.x = -transform.scale.x;
+	}
+
+	for (int axis{ 0 }; axis < 3; ++axis)
+	{
+		rotation[axis] /= transform.scale[axis];
+	}
+	transform.rotation = glm::quat_cast(rotation);
+
+	return transform;
+}
+
+void SetLocalTransform(SceneGraph& graph, uint32_t node, const NodeTransform& transform) noexcept
+{
+	graph.localTransforms[node] = transform;
+	graph.dirtyFlags[node] = 1;
+}
+
+void AnimateSceneGraph(SceneGraph& graph, float time) noexcept
+{
+	for (const Animation& animation : graph.animations)
+	{
+		for (const AnimationChannel& channel : animation.channels)
+		{
+			NodeTransform transform = graph.localTransforms[channel.node];
+			const glm::vec4 value = SampleChannel(channel, time);
+			switch (channel.path)
+			{
+			case AnimationPath::Translation:
+				transform.translation = glm::vec3{ value };
+				break;
+			case AnimationPath::Rotation:
+				transform.rotation = glm::quat{ value.w, value.x, value.y, value.z };
+				break;
+			case AnimationPath::Scale:
+				transform.scale = glm::vec3{ value };
+				break;
+			}
+
+			const NodeTransform& current = graph.localTransforms[channel.node];
+			if (transform.translation != current.translation || transform.rotation != current.rotation || transform.scale != current.scale)
+			{
+				SetLocalTransform(graph, channel.node, transform);
+			}
+		}
+	}
+}
+
+const std::vector<uint32_t> UpdateWorldTransforms(SceneGraph& graph, Scene& scene)
+{
+	std::vector<uint32_t> movedObjects{};
+	const uint32_t nodeCount = static_cast<uint32_t>(graph.parents.size());
+
+	uint32_t node{ 0 };
+	while (node < nodeCount)
+	{
+		if (!graph.dirtyFlags[node])
+		{
+			++node;
+			continue;
+		}
+
+		// Everything below a dirty node moves with it. Parents of the range
+		// are either clean or earlier in the range, so one pass is enough.
+		const uint32_t subtreeEnd = graph.subtreeEnds[node];
+		for (uint32_t child{ node }; child < subtreeEnd; ++child)
+		{
+			const uint32_t parent = graph.parents[child];
+			const glm::mat4 local = ToMatrix(graph.localTransforms[child]);
+			graph.worldMatrices[child] = parent == invalidNode ? local : graph.worldMatrices[parent] * local;
+			graph.dirtyFlags[child] = 0;
+
+			if (graph.objects[child] != invalidObject)
+			{
+				SetObjectTransform(scene, graph.objects[child], graph.worldMatrices[child]);
+				movedObjects.push_back(graph.objects[child]);
+			}
+		}
+
+		node = subtreeEnd;
+	}
+
+	return movedObjects;
+}
+
+void InstantiateSceneGraph(SceneGraph& graph, Scene& scene, ResourceManager& resourceManager, const Material& material)
+{
+	UpdateWorldTransforms(graph, scene);
+
+	for (uint32_t node{ 0 }; node < graph.parents.size(); ++node)
+	{
+		if (graph.meshes[node] >= 0)
+		{
+			const Mesh& mesh = resourceManager.GetMeshByIndex(static_cast<size_t>(graph.meshes[node]));
+			const Material* meshMaterial = resourceManager.GetMeshMaterial(static_cast<size_t>(graph.meshes[node]));
+			graph.objects[node] = AddObject(scene, mesh, meshMaterial ? *meshMaterial : material, graph.worldMatrices[node]);
+		}
+	}
+}
@@ -0,0 +1,196 @@
+#include "Sequence.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace
+{
+	struct SceneState
+	{
+		SceneGraph graph;
+		Scene scene;
+	};
+
+	// Poses the graph at shutter close first and keeps those matrices, then
+	// at shutter open. Objects whose world matrix differs between the two
+	// get a motion, the others are left standing.
+	const std::vector<uint32_t> UpdateShutterMotion(SceneState& state, float openTime, float closeTime)
+	{
+		AnimateSceneGraph(state.graph, closeTime);
+		std::vector<uint32_t> movedObjects = UpdateWorldTransforms(state.graph, state.scene);
+		const std::vector<glm::mat4> closeMatrices = state.graph.worldMatrices;
+
+		AnimateSceneGraph(state.graph, openTime);
+		const std::vector<uint32_t> openMoved = UpdateWorldTransforms(state.graph, state.scene);
+		movedObjects.insert(movedObjects.end(), openMoved.begin(), openMoved.end());
+
+		for (size_t node{ 0 }; node < state.graph.objects.size(); ++node)
+		{
+			const uint32_t object = state.graph.objects[node];
+			if (object == invalidObject)
+			{
+				continue;
+			}
+
+			const glm::mat4& openMatrix = state.graph.worldMatrices[node];
+			if (openMatrix != closeMatrices[node])
+			{
+				SetObjectMotion(state.scene, object, Decompose(openMatrix), Decompose(closeMatrices[node]));
+				movedObjects.push_back(object);
+			}
+			else if (state.scene.objects[object].motionID != noMotion)
+			{
+				SetObjectTransform(state.scene, object, openMatrix);
+				movedObjects.push_back(object);
+			}
+		}
+
+		std::sort(movedObjects.begin(), movedObjects.end());
+		movedObjects.erase(std::unique(movedObjects.begin(), movedObjects.end()), movedObjects.end());
+		return movedObjects;
+	}
+
+	const SequenceFrame UpdateFrame(SceneState& state, const SequenceSettings& settings, uint32_t frameIndex)
+	{
+		LUX_PROFILE_ZONE("UpdateFrame");
+
+		const auto start = std::chrono::steady_clock::now();
+
+		SequenceFrame frame{ frameIndex, settings.startTime + static_cast<float>(frameIndex) / settings.framesPerSecond };
+		std::vector<uint32_t> movedObjects{};
+		if (settings.shutter > 0.0f)
+		{
+			movedObjects = UpdateShutterMotion(state, frame.time, frame.time + settings.shutter / settings.framesPerSecond);
+		}
+		else
+		{
+			AnimateSceneGraph(state.graph, frame.time);
+			movedObjects = UpdateWorldTransforms(state.graph, state.scene);
+		}
+		frame.movedObjects = movedObjects.size();
+		frame.rebuilt = !movedObjects.empty() && UpdateAccelerationStructure(state.scene, movedObjects);
+
+		frame.updateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return frame;
+	}
+
+	// One thread for the whole sequence that updates a frame of states
+	// whenever asked, so the profiler sees a single update track instead of
+	// a new thread per frame.
+	class SequenceUpdater
+	{
+	public:
+		SequenceUpdater(std::array<SceneState, 2>& states, const SequenceSettings& settings)
+			: states{ states }, settings{ settings }, thread{ &SequenceUpdater::UpdateLoop, this }
+		{
+		}
+
+		~SequenceUpdater()
+		{
+			{
+				std::lock_guard lock{ mutex };
+				stopping = true;
+			}
+			requestCondition.notify_one();
+			thread.join();
+		}
+
+		SequenceUpdater(const SequenceUpdater&) = delete;
+		SequenceUpdater& operator=(const SequenceUpdater&) = delete;
+
+		// Starts updating the state of frameIndex, the one before it must
+		// have been collected by Wait.
+		void Start(uint32_t frameIndex)
+		{
+			{
+				std::lock_guard lock{ mutex };
+				requestedFrame = frameIndex;
+			}
+			requestCondition.notify_one();
+		}
+
+		const SequenceFrame Wait()
+		{
+			std::unique_lock lock{ mutex };
+			doneCondition.wait(lock, [this] { return updatedFrame.has_value(); });
+			const SequenceFrame frame = *updatedFrame;
+			updatedFrame.reset();
+			return frame;
+		}
+
+	private:
+		void UpdateLoop()
+		{
+			LUX_PROFILE_THREAD_NAME("Sequence update");
+
+			while (true)
+			{
+				uint32_t frameIndex{ 0 };
+				{
+					std::unique_lock lock{ mutex };
+					requestCondition.wait(lock, [this] { return stopping || requestedFrame.has_value(); });
+					if (stopping)
+					{
+						return;
+					}
+					frameIndex = *requestedFrame;
+					requestedFrame.reset();
+				}
+
+				const SequenceFrame frame = UpdateFrame(states[frameIndex % 2], settings, frameIndex);
+				{
+					std::lock_guard lock{ mutex };
+					updatedFrame = frame;
+				}
+				doneCondition.notify_one();
+			}
+		}
+
+		std::array<SceneState, 2>& states;
+		const SequenceSettings& settings;
+		std::mutex mutex;
+		std::condition_variable requestCondition;
+		std::condition_variable doneCondition;
+		std::optional<uint32_t> requestedFrame{};
+		std::optional<SequenceFrame> updatedFrame{};
+		bool stopping{ false };
+		// Last, so everything it uses exists before it starts.
+		std::thread thread;
+	};
+}
+
+void RenderSequence(const SceneGraph& graph, const Scene& scene, std::vector<View>& views, ThreadPool& threadPool, const SequenceSettings& settings, const SequenceFrameCallback& onFrame)
+{
+	LUX_PROFILE_ZONE("RenderSequence");
+
+	std::array<SceneState, 2> states{ SceneState{ graph, scene }, SceneState{ graph, scene } };
+	SequenceFrame frame = UpdateFrame(states[0], settings, 0);
+	SequenceUpdater updater{ states, settings };
+
+	for (uint32_t frameIndex{ 0 }; frameIndex < settings.frameCount; ++frameIndex)
+	{
+		SceneState& current = states[frameIndex % 2];
+
+		// Tracing only reads current, so the other state can be updated
+		// meanwhile. It still holds the frame before this one, which is done.
+		const bool hasNext = frameIndex + 1 < settings.frameCount;
+		if (hasNext)
+		{
+			updater.Start(frameIndex + 1);
+		}
+
+		const auto renderStart = std::chrono::steady_clock::now();
+		RenderViews(current.scene, views, threadPool, settings.sampling);
+		frame.renderMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart).count();
+
+		const SequenceFrame updated = hasNext ? updater.Wait() : SequenceFrame{};
+		onFrame(frame, views);
+		frame = updated;
+	}
+}
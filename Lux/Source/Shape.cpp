@@ -0,0 +1,139 @@
+#include "Shape.h"
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr float miss = std::numeric_limits<float>::infinity();
+
+	const float IntersectPlane(glm::vec3 normal, float distance, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept
+	{
+		float denominator = glm::dot(normal, direction);
+		if (denominator == 0.0f)
+		{
+			return miss;
+		}
+
+		float t = (distance - glm::dot(normal, origin)) / denominator;
+		return t > minDistance && t < maxDistance ? t : miss;
+	}
+}
+
+const Bounds ComputeBounds(const Sphere& sphere) noexcept
+{
+	return Bounds{ sphere.center - glm::vec3{ sphere.radius }, sphere.center + glm::vec3{ sphere.radius } };
+}
+
+const Bounds ComputeBounds(const Disc& disc) noexcept
+{
+	// Extent of a disc along each axis is radius * sqrt(1 - n_axis^2).
+	glm::vec3 normalSquared = disc.normal * disc.normal;
+	glm::vec3 extent = disc.radius * glm::sqrt(glm::max(glm::vec3{ 1.0f } - normalSquared, glm::vec3{ 0.0f }));
+	return Bounds{ disc.center - extent, disc.center + extent };
+}
+
+const Bounds ComputeBounds(const Box& box) noexcept
+{
+	return Bounds{ box.minimum, box.maximum };
+}
+
+const float Intersect(const Sphere& sphere, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept
+{
+	glm::vec3 oc = origin - sphere.center;
+	float a = glm::dot(direction, direction);
+	float halfB = glm::dot(oc, direction);
+	float c = glm::dot(oc, oc) - sphere.radius * sphere.radius;
+	float discriminant = halfB * halfB - a * c;
+
+	if (discriminant < 0.0f)
+	{
+		return miss;
+	}
+
+	float root = std::sqrt(discriminant);
+	float t = (-halfB - root) / a;
+	if (t <= minDistance)
+	{
+		t = (-halfB + root) / a;
+	}
+
+	return t > minDistance && t < maxDistance ? t : miss;
+}
+
+const float Intersect(const Plane& plane, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept
+{
+	return IntersectPlane(plane.normal, plane.distance, origin, direction, minDistance, maxDistance);
+}
+
+const float Intersect(const Disc& disc, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept
+{
+	float t = IntersectPlane(disc.normal, glm::dot(disc.normal, disc.center), origin, direction, minDistance, maxDistance);
+	if (t == miss)
+	{
+		return miss;
+	}
+
+	glm::vec3 offset = origin + t * direction - disc.center;
+	return glm::dot(offset, offset) <= disc.radius * disc.radius ? t : miss;
+}
+
+const float Intersect(const Box& box, glm::vec3 origin, glm::vec3 direction, float minDistance, float maxDistance) noexcept
+{
+	glm::vec3 inverseDirection = 1.0f / direction;
+	glm::vec3 t0 = (box.minimum - origin) * inverseDirection;
+	glm::vec3 t1 = (box.maximum - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+
+	float entry = std::max(std::max(tNear.x, tNear.y), tNear.z);
+	float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+
+	if (entry > exit)
+	{
+		return miss;
+	}
+
+	// Rays starting inside the box hit its far side.
+	float t = entry > minDistance ? entry : exit;
+	return t > minDistance && t < maxDistance ? t : miss;
+}
+
+const glm::vec3 NormalAt(const Sphere& sphere, glm::vec3 point) noexcept
+{
+	return (point - sphere.center) / sphere.radius;
+}
+
+const glm::vec3 NormalAt(const Plane& plane, glm::vec3) noexcept
+{
+	return plane.normal;
+}
+
+const glm::vec3 NormalAt(const Disc& disc, glm::vec3) noexcept
+{
+	return disc.normal;
+}
+
+const glm::vec3 NormalAt(const Box& box, glm::vec3 point) noexcept
+{
+	// The face that was hit is the one whose plane the point is closest to.
+	// Distances rather than ratios to the box size keep flat boxes, walls
+	// written as a Box, from dividing by a zero extent.
+	glm::vec3 center = 0.5f * (box.minimum + box.maximum);
+	glm::vec3 halfExtent = 0.5f * (box.maximum - box.minimum);
+	glm::vec3 local = point - center;
+	glm::vec3 distance = glm::abs(halfExtent - glm::abs(local));
+
+	if (distance.x <= distance.y && distance.x <= distance.z)
+	{
+		return glm::vec3{ local.x > 0.0f ? 1.0f : -1.0f, 0.0f, 0.0f };
+	}
+	if (distance.y <= distance.z)
+	{
+		return glm::vec3{ 0.0f, local.y > 0.0f ? 1.0f : -1.0f, 0.0f };
+	}
+	return glm::vec3{ 0.0f, 0.0f, local.z > 0.0f ? 1.0f : -1.0f };
+}
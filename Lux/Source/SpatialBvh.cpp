@@ -0,0 +1,392 @@
+#include "Bvh.h"
+#include "Profiler.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+	// A primitive, or the part of it that lies inside a node after spatial splits.
+	struct Reference
+	{
+		Bounds bounds;
+		uint32_t primitiveIndex;
+	};
+
+	struct ObjectBin
+	{
+		Bounds bounds;
+		uint32_t count{ 0 };
+	};
+
+	struct SpatialBin
+	{
+		Bounds bounds;
+		uint32_t entries{ 0 };
+		uint32_t exits{ 0 };
+	};
+
+	struct Split
+	{
+		float cost{ std::numeric_limits<float>::max() };
+		int axis{ -1 };
+		uint32_t bin{ 0 };
+		bool spatial{ false };
+		Bounds leftBounds;
+		Bounds rightBounds;
+	};
+
+	struct SpatialBuildContext
+	{
+		gsl::span<const glm::vec3> trianglePositions;
+		const BvhBuildSettings& settings;
+		Bvh& bvh;
+		float minimumOverlapArea;
+		size_t remainingSplits;
+	};
+
+	const Bounds ComputeReferenceBounds(const std::vector<Reference>& references) noexcept
+	{
+		Bounds bounds{};
+		for (const Reference& reference : references)
+		{
+			Grow(bounds, reference.bounds);
+		}
+		return bounds;
+	}
+
+	// Clips the reference against the plane at position along axis.
+	const std::pair<Bounds, Bounds> SplitReference(const SpatialBuildContext& context, const Reference& reference, int axis, float position) noexcept
+	{
+		Bounds left{};
+		Bounds right{};
+
+		if (context.trianglePositions.empty())
+		{
+			left = reference.bounds;
+			right = reference.bounds;
+		}
+		else
+		{
+			const glm::vec3* corners = &context.trianglePositions[3 * static_cast<size_t>(reference.primitiveIndex)];
+			for (uint32_t i{ 0 }; i < 3; ++i)
+			{
+				const glm::vec3 start = corners[i];
+				const glm::vec3 end = corners[(i + 1) % 3];
+
+				if (start[axis] <= position)
+				{
+					Grow(left, start);
+				}
+				if (start[axis] >= position)
+				{
+					Grow(right, start);
+				}
+				if ((start[axis] < position && end[axis] > position) || (start[axis] > position && end[axis] < position))
+				{
+					glm::vec3 crossing = glm::mix(start, end, (position - start[axis]) / (end[axis] - start[axis]));
+					crossing[axis] = position;
+					Grow(left, crossing);
+					Grow(right, crossing);
+				}
+			}
+
+			left = Intersection(left, reference.bounds);
+			right = Intersection(right, reference.bounds);
+		}
+
+		left.maximum[axis] = std::min(left.maximum[axis], position);
+		right.minimum[axis] = std::max(right.minimum[axis], position);
+
+		// Clipping can leave inverted boxes, which would grow other bounds.
+		return { IsEmpty(left) ? Bounds{} : left, IsEmpty(right) ? Bounds{} : right };
+	}
+
+	const Split FindObjectSplit(const SpatialBuildContext& context, const std::vector<Reference>& references)
+	{
+		const uint32_t count = static_cast<uint32_t>(references.size());
+		const uint32_t binCount = context.settings.binCount;
+
+		Bounds centroidBounds{};
+		for (const Reference& reference : references)
+		{
+			Grow(centroidBounds, Centroid(reference.bounds));
+		}
+
+		std::vector<ObjectBin> bins(binCount);
+		std::vector<Bounds> rightBounds(binCount);
+		std::vector<float> rightCosts(binCount);
+		Split best{};
+
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			const float extent = centroidBounds.maximum[axis] - centroidBounds.minimum[axis];
+			if (extent <= 0.0f)
+			{
+				continue;
+			}
+
+			const float binScale = static_cast<float>(binCount) / extent;
+			std::fill(bins.begin(), bins.end(), ObjectBin{});
+			for (const Reference& reference : references)
+			{
+				const uint32_t binIndex = std::min(binCount - 1, static_cast<uint32_t>((Centroid(reference.bounds)[axis] - centroidBounds.minimum[axis]) * binScale));
+				Grow(bins[binIndex].bounds, reference.bounds);
+				++bins[binIndex].count;
+			}
+
+			Bounds right{};
+			uint32_t rightCount{ 0 };
+			for (uint32_t split{ binCount - 1 }; split > 0; --split)
+			{
+				Grow(right, bins[split].bounds);
+				rightCount += bins[split].count;
+				rightBounds[split] = right;
+				rightCosts[split] = static_cast<float>(rightCount) * SurfaceArea(right);
+			}
+
+			Bounds left{};
+			uint32_t leftCount{ 0 };
+			for (uint32_t split{ 1 }; split < binCount; ++split)
+			{
+				Grow(left, bins[split - 1].bounds);
+				leftCount += bins[split - 1].count;
+
+				const float cost = static_cast<float>(leftCount) * SurfaceArea(left) + rightCosts[split];
+				if (leftCount > 0 && leftCount < count && cost < best.cost)
+				{
+					best = Split{ cost, axis, split, false, left, rightBounds[split] };
+				}
+			}
+		}
+
+		return best;
+	}
+
+	const Split FindSpatialSplit(const SpatialBuildContext& context, const std::vector<Reference>& references, const Bounds& nodeBounds)
+	{
+		const uint32_t count = static_cast<uint32_t>(references.size());
+		const uint32_t binCount = context.settings.binCount;
+
+		std::vector<SpatialBin> bins(binCount);
+		std::vector<Bounds> rightBounds(binCount);
+		std::vector<uint32_t> rightCounts(binCount);
+		Split best{};
+
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			const float origin = nodeBounds.minimum[axis];
+			const float binWidth = (nodeBounds.maximum[axis] - origin) / static_cast<float>(binCount);
+			if (binWidth <= 0.0f)
+			{
+				continue;
+			}
+
+			const auto binIndex = [&](float position)
+			{
+				return std::min(binCount - 1, static_cast<uint32_t>(std::max(0.0f, (position - origin) / binWidth)));
+			};
+
+			std::fill(bins.begin(), bins.end(), SpatialBin{});
+			for (const Reference& reference : references)
+			{
+				const uint32_t firstBin = binIndex(reference.bounds.minimum[axis]);
+				const uint32_t lastBin = binIndex(reference.bounds.maximum[axis]);
+
+				Reference remainder = reference;
+				for (uint32_t bin{ firstBin }; bin < lastBin; ++bin)
+				{
+					const auto [left, right] = SplitReference(context, remainder, axis, origin + static_cast<float>(bin + 1) * binWidth);
+					Grow(bins[bin].bounds, left);
+					remainder.bounds = right;
+				}
+				Grow(bins[lastBin].bounds, remainder.bounds);
+
+				++bins[firstBin].entries;
+				++bins[lastBin].exits;
+			}
+
+			Bounds right{};
+			uint32_t rightCount{ 0 };
+			for (uint32_t split{ binCount - 1 }; split > 0; --split)
+			{
+				Grow(right, bins[split].bounds);
+				rightCount += bins[split].exits;
+				rightBounds[split] = right;
+				rightCounts[split] = rightCount;
+			}
+
+			Bounds left{};
+			uint32_t leftCount{ 0 };
+			for (uint32_t split{ 1 }; split < binCount; ++split)
+			{
+				Grow(left, bins[split - 1].bounds);
+				leftCount += bins[split - 1].entries;
+
+				const uint32_t duplicates = leftCount + rightCounts[split] - count;
+				if (leftCount == 0 || rightCounts[split] == 0 || duplicates > context.remainingSplits)
+				{
+					continue;
+				}
+
+				const float cost = static_cast<float>(leftCount) * SurfaceArea(left) + static_cast<float>(rightCounts[split]) * SurfaceArea(rightBounds[split]);
+				if (cost < best.cost)
+				{
+					best = Split{ cost, axis, split, true, left, rightBounds[split] };
+				}
+			}
+		}
+
+		return best;
+	}
+
+	void MakeLeaf(SpatialBuildContext& context, uint32_t nodeIndex, const std::vector<Reference>& references)
+	{
+		BvhNode& node = context.bvh.nodes[nodeIndex];
+		node.offset = static_cast<uint32_t>(context.bvh.primitiveIndices.size());
+		node.primitiveCount = static_cast<uint32_t>(references.size());
+
+		for (const Reference& reference : references)
+		{
+			context.bvh.primitiveIndices.push_back(reference.primitiveIndex);
+		}
+	}
+
+	void Subdivide(SpatialBuildContext& context, uint32_t nodeIndex, std::vector<Reference> references, uint32_t depth)
+	{
+		const uint32_t count = static_cast<uint32_t>(references.size());
+		const Bounds nodeBounds = context.bvh.nodes[nodeIndex].bounds;
+
+		if (count <= context.settings.maxLeafSize || depth + 1 >= bvhMaxDepth)
+		{
+			MakeLeaf(context, nodeIndex, references);
+			return;
+		}
+
+		Split best = FindObjectSplit(context, references);
+		if (context.remainingSplits > 0 && (best.axis == -1 || SurfaceArea(Intersection(best.leftBounds, best.rightBounds)) > context.minimumOverlapArea))
+		{
+			const Split spatialSplit = FindSpatialSplit(context, references, nodeBounds);
+			if (spatialSplit.cost < best.cost)
+			{
+				best = spatialSplit;
+			}
+		}
+
+		const float nodeArea = std::max(SurfaceArea(nodeBounds), std::numeric_limits<float>::min());
+		const float splitCost = context.settings.traversalCost + context.settings.intersectionCost * best.cost / nodeArea;
+		const float leafCost = context.settings.intersectionCost * static_cast<float>(count);
+		if (best.axis == -1 || splitCost >= leafCost)
+		{
+			MakeLeaf(context, nodeIndex, references);
+			return;
+		}
+
+		const uint32_t binCount = context.settings.binCount;
+		std::vector<Reference> leftReferences;
+		std::vector<Reference> rightReferences;
+
+		if (best.spatial)
+		{
+			const float origin = nodeBounds.minimum[best.axis];
+			const float binWidth = (nodeBounds.maximum[best.axis] - origin) / static_cast<float>(binCount);
+			const float position = origin + static_cast<float>(best.bin) * binWidth;
+			const auto binIndex = [&](float coordinate)
+			{
+				return std::min(binCount - 1, static_cast<uint32_t>(std::max(0.0f, (coordinate - origin) / binWidth)));
+			};
+
+			for (const Reference& reference : references)
+			{
+				if (binIndex(reference.bounds.maximum[best.axis]) < best.bin)
+				{
+					leftReferences.push_back(reference);
+				}
+				else if (binIndex(reference.bounds.minimum[best.axis]) >= best.bin)
+				{
+					rightReferences.push_back(reference);
+				}
+				else
+				{
+					const auto [left, right] = SplitReference(context, reference, best.axis, position);
+					if (!IsEmpty(left))
+					{
+						leftReferences.push_back(Reference{ left, reference.primitiveIndex });
+					}
+					if (!IsEmpty(right))
+					{
+						rightReferences.push_back(Reference{ right, reference.primitiveIndex });
+					}
+				}
+			}
+
+			const size_t duplicates = leftReferences.size() + rightReferences.size() - references.size();
+			context.remainingSplits -= std::min(context.remainingSplits, duplicates);
+		}
+		else
+		{
+			Bounds centroidBounds{};
+			for (const Reference& reference : references)
+			{
+				Grow(centroidBounds, Centroid(reference.bounds));
+			}
+
+			const float binScale = static_cast<float>(binCount) / (centroidBounds.maximum[best.axis] - centroidBounds.minimum[best.axis]);
+			for (const Reference& reference : references)
+			{
+				const uint32_t binIndex = std::min(binCount - 1, static_cast<uint32_t>((Centroid(reference.bounds)[best.axis] - centroidBounds.minimum[best.axis]) * binScale));
+				(binIndex < best.bin ? leftReferences : rightReferences).push_back(reference);
+			}
+		}
+
+		if (leftReferences.empty() || rightReferences.empty())
+		{
+			MakeLeaf(context, nodeIndex, references);
+			return;
+		}
+		references = {};
+
+		const uint32_t leftChild = static_cast<uint32_t>(context.bvh.nodes.size());
+		context.bvh.nodes.push_back(BvhNode{ ComputeReferenceBounds(leftReferences), 0, 0 });
+		context.bvh.nodes.push_back(BvhNode{ ComputeReferenceBounds(rightReferences), 0, 0 });
+
+		BvhNode& node = context.bvh.nodes[nodeIndex];
+		node.offset = leftChild;
+		node.primitiveCount = 0;
+
+		Subdivide(context, leftChild, std::move(leftReferences), depth + 1);
+		Subdivide(context, leftChild + 1, std::move(rightReferences), depth + 1);
+	}
+}
+
+const Bvh BuildSpatialBvh(gsl::span<const Bounds> primitiveBounds, gsl::span<const glm::vec3> trianglePositions, const BvhBuildSettings& settings)
+{
+	LUX_PROFILE_ZONE("BuildSpatialBvh");
+
+	Bvh bvh{};
+	if (primitiveBounds.empty())
+	{
+		return bvh;
+	}
+
+	std::vector<Reference> references;
+	references.reserve(primitiveBounds.size());
+	for (uint32_t primitiveIndex{ 0 }; primitiveIndex < primitiveBounds.size(); ++primitiveIndex)
+	{
+		references.push_back(Reference{ primitiveBounds[primitiveIndex], primitiveIndex });
+	}
+
+	const Bounds rootBounds = ComputeReferenceBounds(references);
+	const size_t splitBudget = static_cast<size_t>(settings.spatialSplitBudget * static_cast<float>(primitiveBounds.size()));
+	bvh.primitiveIndices.reserve(primitiveBounds.size() + splitBudget);
+	bvh.nodes.reserve(2 * (primitiveBounds.size() + splitBudget));
+	bvh.nodes.push_back(BvhNode{ rootBounds, 0, 0 });
+
+	SpatialBuildContext context{ trianglePositions, settings, bvh, settings.spatialSplitAlpha * SurfaceArea(rootBounds), splitBudget };
+	Subdivide(context, 0, std::move(references), 0);
+	bvh.builtSahCost = ComputeSahCost(bvh, settings);
+
+	return bvh;
+}
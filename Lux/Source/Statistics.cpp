@@ -0,0 +1,66 @@
+#include "Statistics.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+RayStatistics& ThreadStatistics() noexcept
+{
+	thread_local RayStatistics statistics{};
+	return statistics;
+}
+
+const PixelStatistics Difference(const RayStatistics& after, const RayStatistics& before) noexcept
+{
+	PixelStatistics difference{};
+	for (size_t counter{ 0 }; counter < statisticCounterCount; ++counter)
+	{
+		difference.counters[counter] = static_cast<uint32_t>(after.counters[counter] - before.counters[counter]);
+	}
+	return difference;
+}
+
+const glm::vec3 Heatmap(uint32_t value, uint32_t maximum) noexcept
+{
+	constexpr std::array<glm::vec3, 5> ramp
+	{
+		glm::vec3{ 0.0f, 0.0f, 0.0f },
+		glm::vec3{ 0.0f, 0.0f, 1.0f },
+		glm::vec3{ 0.0f, 1.0f, 0.0f },
+		glm::vec3{ 1.0f, 1.0f, 0.0f },
+		glm::vec3{ 1.0f, 0.0f, 0.0f }
+	};
+
+	if (maximum == 0)
+	{
+		return ramp[0];
+	}
+
+	float t = std::log2(1.0f + static_cast<float>(value)) / std::log2(1.0f + static_cast<float>(maximum));
+	float position = glm::clamp(t, 0.0f, 1.0f) * static_cast<float>(ramp.size() - 1);
+	size_t index = std::min(static_cast<size_t>(position), ramp.size() - 2);
+
+	return glm::mix(ramp[index], ramp[index + 1], position - static_cast<float>(index));
+}
+
+void PrintStatistics(const RayStatistics& totals, double renderSeconds, uint64_t frameCount) noexcept
+{
+	auto counter = [&totals](StatisticCounter counter)
+	{
+		return static_cast<double>(totals.counters[static_cast<size_t>(counter)]);
+	};
+
+	const double primaryRays = counter(StatisticCounter::PrimaryRays);
+	const double totalRays = primaryRays + counter(StatisticCounter::ShadowRays) + counter(StatisticCounter::BounceRays);
+	const double perPrimary = primaryRays > 0.0 ? 1.0 / primaryRays : 0.0;
+
+	std::printf("Frames rendered:     %llu in %.3f s\n", static_cast<unsigned long long>(frameCount), renderSeconds);
+	std::printf("Rays/second:         %.3f M\n", renderSeconds > 0.0 ? totalRays / renderSeconds * 1e-6 : 0.0);
+	std::printf("Primary rays:        %.0f\n", primaryRays);
+	std::printf("Shadow rays:         %.0f (%.2f per primary)\n", counter(StatisticCounter::ShadowRays), counter(StatisticCounter::ShadowRays) * perPrimary);
+	std::printf("Bounce rays:         %.0f (%.2f per primary)\n", counter(StatisticCounter::BounceRays), counter(StatisticCounter::BounceRays) * perPrimary);
+	std::printf("Triangle tests:      %.0f (%.2f per ray)\n", counter(StatisticCounter::TriangleTests), totalRays > 0.0 ? counter(StatisticCounter::TriangleTests) / totalRays : 0.0);
+	std::printf("Node visits:         %.0f (%.2f per ray)\n", counter(StatisticCounter::NodeVisits), totalRays > 0.0 ? counter(StatisticCounter::NodeVisits) / totalRays : 0.0);
+}
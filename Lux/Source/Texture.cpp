@@ -0,0 +1,200 @@
+#include "Texture.h"
+#include "Image.h"
+#include "Profiler.h"
+#include "TextureCache.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+	const std::array<float, 256> srgbToLinear = []
+	{
+		std::array<float, 256> table{};
+		for (uint32_t value{ 0 }; value < table.size(); ++value)
+		{
+			const float encoded = static_cast<float>(value) / 255.0f;
+			table[value] = encoded <= 0.04045f ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+		}
+		return table;
+	}();
+
+	const uint8_t LinearToSrgb(float linear) noexcept
+	{
+		const float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::clamp(encoded, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	const glm::vec4 DecodeTexel(uint32_t texel, bool srgb) noexcept
+	{
+		const float alpha = static_cast<float>(texel >> 24) / 255.0f;
+		if (srgb)
+		{
+			return glm::vec4{ srgbToLinear[texel & 0xff], srgbToLinear[(texel >> 8) & 0xff], srgbToLinear[(texel >> 16) & 0xff], alpha };
+		}
+		return glm::vec4{ static_cast<float>(texel & 0xff) / 255.0f, static_cast<float>((texel >> 8) & 0xff) / 255.0f, static_cast<float>((texel >> 16) & 0xff) / 255.0f, alpha };
+	}
+
+	const TextureLevel TileLevel(const std::vector<uint32_t>& texels, uint32_t width, uint32_t height)
+	{
+		TextureLevel level{ width, height, (width + textureTileSize - 1) / textureTileSize };
+		const uint32_t tileCountY = (height + textureTileSize - 1) / textureTileSize;
+		level.texels.resize(static_cast<size_t>(level.tileCountX) * tileCountY * textureTileSize * textureTileSize);
+
+		for (uint32_t y{ 0 }; y < height; ++y)
+		{
+			for (uint32_t x{ 0 }; x < width; ++x)
+			{
+				level.texels[TexelIndex(level, x, y)] = texels[static_cast<size_t>(y) * width + x];
+			}
+		}
+		return level;
+	}
+
+	const int32_t Wrap(int32_t coordinate, int32_t size, TextureWrap wrap) noexcept
+	{
+		switch (wrap)
+		{
+		case TextureWrap::ClampToEdge:
+			return std::clamp(coordinate, 0, size - 1);
+		case TextureWrap::MirroredRepeat:
+		{
+			const int32_t period = ((coordinate % (2 * size)) + 2 * size) % (2 * size);
+			return period < size ? period : 2 * size - 1 - period;
+		}
+		default:
+			return ((coordinate % size) + size) % size;
+		}
+	}
+
+	const glm::vec4 SampleBilinear(const Texture& texture, uint32_t levelIndex, glm::vec2 texcoord) noexcept
+	{
+		const TextureLevel& level = texture.levels[levelIndex];
+		const float x = texcoord.x * static_cast<float>(level.width) - 0.5f;
+		const float y = texcoord.y * static_cast<float>(level.height) - 0.5f;
+		const float x0 = std::floor(x);
+		const float y0 = std::floor(y);
+		const float fractionX = x - x0;
+		const float fractionY = y - y0;
+
+		const int32_t width = static_cast<int32_t>(level.width);
+		const int32_t height = static_cast<int32_t>(level.height);
+		const uint32_t left = static_cast<uint32_t>(Wrap(static_cast<int32_t>(x0), width, texture.wrapS));
+		const uint32_t right = static_cast<uint32_t>(Wrap(static_cast<int32_t>(x0) + 1, width, texture.wrapS));
+		const uint32_t top = static_cast<uint32_t>(Wrap(static_cast<int32_t>(y0), height, texture.wrapT));
+		const uint32_t bottom = static_cast<uint32_t>(Wrap(static_cast<int32_t>(y0) + 1, height, texture.wrapT));
+
+		std::array<uint32_t, 4> texels;
+		if (texture.cache)
+		{
+			texels = texture.cache->FetchQuad(texture.cacheID, levelIndex, { left, right }, { top, bottom });
+		}
+		else
+		{
+			texels = { level.texels[TexelIndex(level, left, top)], level.texels[TexelIndex(level, right, top)], level.texels[TexelIndex(level, left, bottom)], level.texels[TexelIndex(level, right, bottom)] };
+		}
+
+		const auto decode = [&](uint32_t corner)
+		{
+			return DecodeTexel(texels[corner], texture.srgb);
+		};
+
+		return glm::mix(glm::mix(decode(0), decode(1), fractionX), glm::mix(decode(2), decode(3), fractionX), fractionY);
+	}
+}
+
+const Texture MakeTexture(const Rgba8Image& image, bool srgb, TextureWrap wrapS, TextureWrap wrapT)
+{
+	LUX_PROFILE_ZONE("MakeTexture");
+
+	Texture texture{ {}, srgb, wrapS, wrapT };
+
+	uint32_t width = static_cast<uint32_t>(image.width);
+	uint32_t height = static_cast<uint32_t>(image.height);
+	std::vector<uint32_t> texels(static_cast<size_t>(width) * height);
+	for (size_t texel{ 0 }; texel < texels.size(); ++texel)
+	{
+		const uint8_t* pixel = &image.pixels[4 * texel];
+		texels[texel] = static_cast<uint32_t>(pixel[0]) | static_cast<uint32_t>(pixel[1]) << 8 | static_cast<uint32_t>(pixel[2]) << 16 | static_cast<uint32_t>(pixel[3]) << 24;
+	}
+
+	while (true)
+	{
+		texture.levels.push_back(TileLevel(texels, width, height));
+		if (width == 1 && height == 1)
+		{
+			break;
+		}
+
+		// Odd sizes drop their last row or column.
+		const uint32_t nextWidth = std::max(width / 2, 1u);
+		const uint32_t nextHeight = std::max(height / 2, 1u);
+		std::vector<uint32_t> nextTexels(static_cast<size_t>(nextWidth) * nextHeight);
+
+		for (uint32_t y{ 0 }; y < nextHeight; ++y)
+		{
+			for (uint32_t x{ 0 }; x < nextWidth; ++x)
+			{
+				glm::vec4 sum{ 0.0f };
+				for (uint32_t corner{ 0 }; corner < 4; ++corner)
+				{
+					const uint32_t sourceX = std::min(2 * x + (corner & 1), width - 1);
+					const uint32_t sourceY = std::min(2 * y + (corner >> 1), height - 1);
+					sum += DecodeTexel(texels[static_cast<size_t>(sourceY) * width + sourceX], srgb);
+				}
+
+				const glm::vec4 average = 0.25f * sum;
+				const auto encode = [&](float value)
+				{
+					return srgb ? LinearToSrgb(value) : static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+				};
+				const uint8_t alpha = static_cast<uint8_t>(std::clamp(average.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+				nextTexels[static_cast<size_t>(y) * nextWidth + x] = static_cast<uint32_t>(encode(average.x)) | static_cast<uint32_t>(encode(average.y)) << 8 | static_cast<uint32_t>(encode(average.z)) << 16 | static_cast<uint32_t>(alpha) << 24;
+			}
+		}
+
+		texels = std::move(nextTexels);
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	return texture;
+}
+
+const std::optional<Texture> LoadTexture(const std::filesystem::path& filePath, bool srgb, TextureWrap wrapS, TextureWrap wrapT)
+{
+	const std::optional<Rgba8Image> image = ReadPng(filePath);
+	if (!image)
+	{
+		return std::nullopt;
+	}
+	return MakeTexture(*image, srgb, wrapS, wrapT);
+}
+
+const float ConeLevelOfDetail(float coneWidth, float cosine, float texcoordArea, float worldArea) noexcept
+{
+	return std::log2(coneWidth / std::abs(cosine)) + 0.5f * std::log2(texcoordArea / worldArea);
+}
+
+const glm::vec4 SampleTexture(const Texture& texture, glm::vec2 texcoord, float levelOfDetail) noexcept
+{
+	const TextureLevel& base = texture.levels.front();
+	const float maximumLevel = static_cast<float>(texture.levels.size() - 1);
+
+	// Degenerate triangles and zero width cones make NaN or -infinity, both
+	// end up at the full resolution.
+	float level = levelOfDetail + 0.5f * std::log2(static_cast<float>(base.width) * static_cast<float>(base.height));
+	level = level > 0.0f ? std::min(level, maximumLevel) : 0.0f;
+
+	const uint32_t lowerLevel = static_cast<uint32_t>(level);
+	const float fraction = level - static_cast<float>(lowerLevel);
+	const glm::vec4 lower = SampleBilinear(texture, lowerLevel, texcoord);
+	if (fraction == 0.0f)
+	{
+		return lower;
+	}
+	return glm::mix(lower, SampleBilinear(texture, lowerLevel + 1, texcoord), fraction);
+}
@@ -0,0 +1,381 @@
+#include "TextureCache.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	constexpr std::array<char, 4> tiledTextureMagic{ 'L', 'X', 'T', 'X' };
+	constexpr uint32_t tiledTextureVersion = 2;
+	constexpr size_t tiledTextureHeaderSize = 4096;
+	constexpr size_t texturePageBytes = texturePageTexels * sizeof(uint32_t);
+	// Every thread pins at most one page at a time, so a few more slots than
+	// threads mostly leave one to evict. Misses that find none bypass the
+	// cache.
+	constexpr size_t minimumCapacityPages = 64;
+
+	struct TiledTextureHeader
+	{
+		std::array<char, 4> magic;
+		uint32_t version;
+		uint32_t levelCount;
+		uint8_t srgb;
+		uint8_t wrapS;
+		uint8_t wrapT;
+		uint8_t padding;
+	};
+
+	const uint32_t PageCount(uint32_t size) noexcept
+	{
+		return (size + texturePageSize - 1) / texturePageSize;
+	}
+
+	const uint32_t PageTexelIndex(uint32_t x, uint32_t y) noexcept
+	{
+		return SpreadBits(x % texturePageSize) | SpreadBits(y % texturePageSize) << 1;
+	}
+
+	const uint32_t LookupCounterIndex() noexcept
+	{
+		static std::atomic<uint32_t> nextThread{ 0 };
+		thread_local const uint32_t thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+		return thread;
+	}
+}
+
+const bool WriteTiledTexture(const Texture& texture, const CacheKey& key, const std::filesystem::path& filePath)
+{
+	LUX_PROFILE_ZONE("WriteTiledTexture");
+
+	const size_t keyOffset = sizeof(TiledTextureHeader) + texture.levels.size() * 2 * sizeof(uint32_t);
+	if (keyOffset + sizeof(key.sourceSize) + sizeof(key.sourceWriteTime) + sizeof(uint32_t) + key.identity.size() > tiledTextureHeaderSize)
+	{
+		return false;
+	}
+
+	std::ofstream file{ filePath, std::ios::binary };
+	if (!file)
+	{
+		return false;
+	}
+
+	std::vector<char> header(tiledTextureHeaderSize, 0);
+	const TiledTextureHeader fixed
+	{
+		tiledTextureMagic,
+		tiledTextureVersion,
+		static_cast<uint32_t>(texture.levels.size()),
+		static_cast<uint8_t>(texture.srgb),
+		static_cast<uint8_t>(texture.wrapS),
+		static_cast<uint8_t>(texture.wrapT)
+	};
+	std::memcpy(header.data(), &fixed, sizeof(fixed));
+	for (size_t level{ 0 }; level < texture.levels.size(); ++level)
+	{
+		const std::array<uint32_t, 2> size{ texture.levels[level].width, texture.levels[level].height };
+		std::memcpy(header.data() + sizeof(fixed) + level * sizeof(size), size.data(), sizeof(size));
+	}
+	file.write(header.data(), static_cast<std::streamsize>(keyOffset));
+	WriteCacheKey(file, key);
+	file.write(header.data() + keyOffset, static_cast<std::streamsize>(tiledTextureHeaderSize) - file.tellp());
+
+	std::vector<uint32_t> page(texturePageTexels);
+	for (const TextureLevel& level : texture.levels)
+	{
+		for (uint32_t pageY{ 0 }; pageY < PageCount(level.height); ++pageY)
+		{
+			for (uint32_t pageX{ 0 }; pageX < PageCount(level.width); ++pageX)
+			{
+				std::fill(page.begin(), page.end(), 0u);
+				const uint32_t endX = std::min((pageX + 1) * texturePageSize, level.width);
+				const uint32_t endY = std::min((pageY + 1) * texturePageSize, level.height);
+				for (uint32_t y{ pageY * texturePageSize }; y < endY; ++y)
+				{
+					for (uint32_t x{ pageX * texturePageSize }; x < endX; ++x)
+					{
+						page[PageTexelIndex(x, y)] = level.texels[TexelIndex(level, x, y)];
+					}
+				}
+				file.write(reinterpret_cast<const char*>(page.data()), static_cast<std::streamsize>(texturePageBytes));
+			}
+		}
+	}
+
+	return static_cast<bool>(file);
+}
+
+TextureCache::TextureCache(size_t budgetBytes)
+	: capacity{ std::max(budgetBytes / texturePageBytes, minimumCapacityPages) }
+	, slots{ std::make_unique<Slot[]>(capacity) }
+	, texels(capacity * texturePageTexels)
+{
+}
+
+const std::optional<Texture> TextureCache::Open(const std::filesystem::path& filePath, const CacheKey& key)
+{
+	std::ifstream file{ filePath, std::ios::binary };
+	std::vector<char> header(tiledTextureHeaderSize);
+	if (!file.read(header.data(), static_cast<std::streamsize>(header.size())))
+	{
+		return std::nullopt;
+	}
+
+	TiledTextureHeader fixed{};
+	std::memcpy(&fixed, header.data(), sizeof(fixed));
+	constexpr size_t maximumLevelCount = (tiledTextureHeaderSize - sizeof(fixed)) / (2 * sizeof(uint32_t));
+	if (fixed.magic != tiledTextureMagic || fixed.version != tiledTextureVersion || fixed.levelCount == 0 || fixed.levelCount > maximumLevelCount)
+	{
+		return std::nullopt;
+	}
+
+	file.seekg(static_cast<std::streamoff>(sizeof(fixed) + fixed.levelCount * 2 * sizeof(uint32_t)));
+	if (ReadCacheKey(file) != key)
+	{
+		return std::nullopt;
+	}
+
+	Texture texture{ {}, fixed.srgb != 0, static_cast<TextureWrap>(fixed.wrapS), static_cast<TextureWrap>(fixed.wrapT), this, static_cast<uint32_t>(textures.size()) };
+	CachedTexture cached{ std::move(file), std::make_unique<std::mutex>() };
+
+	uint32_t pageCount{ 0 };
+	for (uint32_t level{ 0 }; level < fixed.levelCount; ++level)
+	{
+		std::array<uint32_t, 2> size{};
+		std::memcpy(size.data(), header.data() + sizeof(fixed) + level * sizeof(size), sizeof(size));
+		texture.levels.push_back(TextureLevel{ size[0], size[1], (size[0] + textureTileSize - 1) / textureTileSize });
+
+		cached.levelPageOffsets.push_back(pageCount);
+		cached.levelPageCountsX.push_back(PageCount(size[0]));
+		pageCount += PageCount(size[0]) * PageCount(size[1]);
+	}
+
+	std::error_code error{};
+	const uintmax_t fileSize = std::filesystem::file_size(filePath, error);
+	if (error || fileSize < tiledTextureHeaderSize + static_cast<uintmax_t>(pageCount) * texturePageBytes)
+	{
+		return std::nullopt;
+	}
+
+	cached.pageSlots = std::make_unique<std::atomic<uint32_t>[]>(pageCount);
+	for (uint32_t page{ 0 }; page < pageCount; ++page)
+	{
+		cached.pageSlots[page].store(noSlot, std::memory_order_relaxed);
+	}
+
+	textures.push_back(std::move(cached));
+	return texture;
+}
+
+const std::array<uint32_t, 4> TextureCache::FetchQuad(uint32_t textureID, uint32_t level, std::array<uint32_t, 2> xs, std::array<uint32_t, 2> ys)
+{
+	const CachedTexture& texture = textures[textureID];
+	std::array<uint32_t, 4> quad;
+
+	// The corners mostly share a page, which is then pinned once.
+	uint32_t pinnedPage{ noSlot };
+	PinnedPage pinned{ noSlot, nullptr };
+	for (uint32_t corner{ 0 }; corner < 4; ++corner)
+	{
+		const uint32_t x = xs[corner & 1];
+		const uint32_t y = ys[corner >> 1];
+		const uint32_t page = texture.levelPageOffsets[level] + (y / texturePageSize) * texture.levelPageCountsX[level] + x / texturePageSize;
+		if (page != pinnedPage)
+		{
+			if (pinned.slot != noSlot)
+			{
+				Unpin(pinned.slot);
+			}
+			pinned = AcquirePage(textureID, page);
+			pinnedPage = page;
+		}
+		quad[corner] = pinned.texels[PageTexelIndex(x, y)];
+	}
+	if (pinned.slot != noSlot)
+	{
+		Unpin(pinned.slot);
+	}
+
+	return quad;
+}
+
+const TextureCacheReport TextureCache::Report() const noexcept
+{
+	TextureCacheReport report{};
+	for (const LookupCounter& counter : lookupCounters)
+	{
+		report.lookups += counter.lookups.load(std::memory_order_relaxed);
+	}
+
+	const std::lock_guard lock{ missMutex };
+	report.misses = misses;
+	report.bytesLoaded = bytesLoaded;
+	report.evictions = evictions;
+	report.uncachedLoads = uncachedLoads;
+	report.readErrors = readErrors.load(std::memory_order_relaxed);
+	report.residentPages = residentPages;
+	report.capacityPages = capacity;
+	return report;
+}
+
+const TextureCache::PinnedPage TextureCache::AcquirePage(uint32_t textureID, uint32_t page)
+{
+	lookupCounters[LookupCounterIndex() % lookupCounterCount].lookups.fetch_add(1, std::memory_order_relaxed);
+
+	const uint64_t key = static_cast<uint64_t>(textureID) << 32 | page;
+	const uint32_t slot = textures[textureID].pageSlots[page].load(std::memory_order_acquire);
+	if (slot != noSlot && TryPin(slot, key))
+	{
+		// Only writes when the bit changes, so hot pages stay shared between
+		// the caches of all cores.
+		if (slots[slot].referenced.load(std::memory_order_relaxed) == 0)
+		{
+			slots[slot].referenced.store(1, std::memory_order_relaxed);
+		}
+		WaitUntilLoaded(slot);
+		return PinnedPage{ slot, &texels[static_cast<size_t>(slot) * texturePageTexels] };
+	}
+
+	return LoadPage(textureID, page);
+}
+
+const TextureCache::PinnedPage TextureCache::LoadPage(uint32_t textureID, uint32_t page)
+{
+	LUX_PROFILE_ZONE("LoadTexturePage");
+
+	std::unique_lock lock{ missMutex };
+	CachedTexture& texture = textures[textureID];
+	const uint64_t key = static_cast<uint64_t>(textureID) << 32 | page;
+
+	// Another thread may have loaded it, or started to, while this one
+	// waited.
+	const uint32_t loaded = texture.pageSlots[page].load(std::memory_order_acquire);
+	if (loaded != noSlot && TryPin(loaded, key))
+	{
+		lock.unlock();
+		WaitUntilLoaded(loaded);
+		return PinnedPage{ loaded, &texels[static_cast<size_t>(loaded) * texturePageTexels] };
+	}
+
+	++misses;
+	bytesLoaded += texturePageBytes;
+
+	const uint32_t slot = EvictSlot();
+	if (slot == noSlot)
+	{
+		++uncachedLoads;
+		lock.unlock();
+		thread_local std::vector<uint32_t> scratch(texturePageTexels);
+		ReadPage(textureID, page, scratch.data());
+		return PinnedPage{ noSlot, scratch.data() };
+	}
+
+	// Pinned before it is published, the slot stays this thread's until
+	// FetchQuad is done with it.
+	Slot& loading = slots[slot];
+	loading.loaded.store(0, std::memory_order_relaxed);
+	loading.pins.fetch_add(1);
+	loading.referenced.store(1, std::memory_order_relaxed);
+	loading.page.store(key);
+	texture.pageSlots[page].store(slot, std::memory_order_release);
+	lock.unlock();
+
+	uint32_t* destination = &texels[static_cast<size_t>(slot) * texturePageTexels];
+	ReadPage(textureID, page, destination);
+	loading.loaded.store(1, std::memory_order_release);
+	loading.loaded.notify_all();
+	return PinnedPage{ slot, destination };
+}
+
+// Open checked the file size, a short read means the file was changed or
+// failed since. Its texels read as zero.
+void TextureCache::ReadPage(uint32_t textureID, uint32_t page, uint32_t* destination)
+{
+	CachedTexture& texture = textures[textureID];
+	const std::lock_guard lock{ *texture.fileMutex };
+	texture.file.clear();
+	texture.file.seekg(static_cast<std::streamoff>(tiledTextureHeaderSize + static_cast<size_t>(page) * texturePageBytes));
+	if (!texture.file.read(reinterpret_cast<char*>(destination), static_cast<std::streamsize>(texturePageBytes)))
+	{
+		std::fill(destination, destination + texturePageTexels, 0u);
+		if (readErrors.fetch_add(1, std::memory_order_relaxed) == 0)
+		{
+			std::printf("Failed to read page %u of cached texture %u\n", page, textureID);
+		}
+	}
+}
+
+// A reader pins the slot before it checks the page, eviction clears the page
+// before it checks the pins. Sequentially consistent, one of them sees the
+// other, so texels are never replaced while being read.
+const bool TextureCache::TryPin(uint32_t slot, uint64_t page) noexcept
+{
+	slots[slot].pins.fetch_add(1);
+	if (slots[slot].page.load() == page)
+	{
+		return true;
+	}
+	Unpin(slot);
+	return false;
+}
+
+void TextureCache::WaitUntilLoaded(uint32_t slot) noexcept
+{
+	slots[slot].loaded.wait(0, std::memory_order_acquire);
+}
+
+void TextureCache::Unpin(uint32_t slot) noexcept
+{
+	slots[slot].pins.fetch_sub(1, std::memory_order_release);
+}
+
+// Two turns of the hand, the first may only clear referenced bits. Returns
+// noSlot when every slot stayed pinned meanwhile.
+const uint32_t TextureCache::EvictSlot()
+{
+	for (size_t step{ 0 }; step < 2 * capacity; ++step)
+	{
+		const uint32_t slot = static_cast<uint32_t>(clockHand);
+		clockHand = (clockHand + 1) % capacity;
+
+		Slot& candidate = slots[slot];
+		const uint64_t page = candidate.page.load();
+		if (page == noPage)
+		{
+			++residentPages;
+			return slot;
+		}
+
+		// Pages used since the hand last passed get another round.
+		if (candidate.pins.load() != 0 || candidate.referenced.exchange(0, std::memory_order_relaxed) != 0)
+		{
+			continue;
+		}
+
+		candidate.page.store(noPage);
+		if (candidate.pins.load() != 0)
+		{
+			candidate.page.store(page);
+			continue;
+		}
+
+		textures[page >> 32].pageSlots[page & 0xffffffff].store(noSlot, std::memory_order_relaxed);
+		++evictions;
+		return slot;
+	}
+	return noSlot;
+}
+
+void PrintTextureCacheReport(const TextureCacheReport& report) noexcept
+{
+	const double hitRate = report.lookups > 0 ? 1.0 - static_cast<double>(report.misses) / static_cast<double>(report.lookups) : 0.0;
+
+	std::printf("Texture cache:       %llu lookups, %.2f%% hits\n", static_cast<unsigned long long>(report.lookups), 100.0 * hitRate);
+	std::printf("Texture bytes read:  %.3f MiB in %llu pages, %llu evicted\n", static_cast<double>(report.bytesLoaded) / (1024.0 * 1024.0), static_cast<unsigned long long>(report.misses), static_cast<unsigned long long>(report.evictions));
+	std::printf("Texture pages:       %zu of %zu resident, %llu loaded past a full cache\n", report.residentPages, report.capacityPages, static_cast<unsigned long long>(report.uncachedLoads));
+	if (report.readErrors > 0)
+	{
+		std::printf("Texture read errors: %llu pages\n", static_cast<unsigned long long>(report.readErrors));
+	}
+}
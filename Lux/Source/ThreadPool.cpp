@@ -0,0 +1,93 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <string>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+	workers.reserve(threadCount);
+
+	for (uint32_t workerIndex{ 0 }; workerIndex < threadCount; ++workerIndex)
+	{
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, workerIndex);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock{ mutex };
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(uint32_t jobCount, const Job& job)
+{
+	if (jobCount == 0)
+	{
+		return;
+	}
+
+	std::unique_lock lock{ mutex };
+	currentJob = &job;
+	currentJobCount = jobCount;
+	nextJobIndex.store(0, std::memory_order_relaxed);
+	activeWorkers = static_cast<uint32_t>(workers.size());
+	++generation;
+	wakeCondition.notify_all();
+
+	doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+	currentJob = nullptr;
+}
+
+uint32_t ThreadPool::WorkerCount() const noexcept
+{
+	return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::WorkerLoop(uint32_t workerIndex)
+{
+	LUX_PROFILE_THREAD_NAME("Worker " + std::to_string(workerIndex));
+
+	uint64_t seenGeneration{ 0 };
+
+	while (true)
+	{
+		const Job* job{ nullptr };
+		uint32_t jobCount{ 0 };
+		{
+			std::unique_lock lock{ mutex };
+			wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+
+			if (stopping)
+			{
+				return;
+			}
+
+			seenGeneration = generation;
+			job = currentJob;
+			jobCount = currentJobCount;
+		}
+
+		for (uint32_t jobIndex = nextJobIndex.fetch_add(1, std::memory_order_relaxed); jobIndex < jobCount; jobIndex = nextJobIndex.fetch_add(1, std::memory_order_relaxed))
+		{
+			(*job)(jobIndex, workerIndex);
+		}
+
+		{
+			std::lock_guard lock{ mutex };
+			if (--activeWorkers == 0)
+			{
+				doneCondition.notify_one();
+			}
+		}
+	}
+}
@@ -0,0 +1,275 @@
+#include "WideBvh.h"
+#include "Profiler.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+
+namespace
+{
+	// Smallest power of two exponent that spreads extent over 255 steps.
+	const int8_t QuantizationExponent(float extent) noexcept
+	{
+		const int exponent = extent > 0.0f ? static_cast<int>(std::ceil(std::log2(extent / 255.0f))) : -126;
+		return static_cast<int8_t>(std::clamp(exponent, -126, 127));
+	}
+
+	const uint8_t QuantizeMinimum(float value, float origin, float scale) noexcept
+	{
+		int quantized = std::clamp(static_cast<int>(std::floor((value - origin) / scale)), 0, 255);
+		while (quantized > 0 && origin + static_cast<float>(quantized) * scale > value)
+		{
+			--quantized;
+		}
+		return static_cast<uint8_t>(quantized);
+	}
+
+	const uint8_t QuantizeMaximum(float value, float origin, float scale) noexcept
+	{
+		int quantized = std::clamp(static_cast<int>(std::ceil((value - origin) / scale)), 0, 255);
+		while (quantized < 255 && origin + static_cast<float>(quantized) * scale < value)
+		{
+			++quantized;
+		}
+		return static_cast<uint8_t>(quantized);
+	}
+
+	const uint32_t CollapseNode(const Bvh& bvh, uint32_t binaryNode, WideBvh& wideBvh)
+	{
+		std::array<uint32_t, wideBvhWidth> binaryChildren;
+		uint32_t childCount{ 0 };
+
+		if (bvh.nodes[binaryNode].primitiveCount > 0)
+		{
+			binaryChildren[childCount++] = binaryNode;
+		}
+		else
+		{
+			binaryChildren[childCount++] = bvh.nodes[binaryNode].offset;
+			binaryChildren[childCount++] = bvh.nodes[binaryNode].offset + 1;
+		}
+
+		while (childCount < wideBvhWidth)
+		{
+			int largest{ -1 };
+			float largestArea{ -1.0f };
+			for (uint32_t child{ 0 }; child < childCount; ++child)
+			{
+				const BvhNode& node = bvh.nodes[binaryChildren[child]];
+				if (node.primitiveCount == 0 && SurfaceArea(node.bounds) > largestArea)
+				{
+					largest = static_cast<int>(child);
+					largestArea = SurfaceArea(node.bounds);
+				}
+			}
+
+			if (largest == -1)
+			{
+				break;
+			}
+
+			const uint32_t opened = binaryChildren[largest];
+			binaryChildren[largest] = bvh.nodes[opened].offset;
+			binaryChildren[childCount++] = bvh.nodes[opened].offset + 1;
+		}
+
+		Bounds nodeBounds{};
+		for (uint32_t child{ 0 }; child < childCount; ++child)
+		{
+			Grow(nodeBounds, bvh.nodes[binaryChildren[child]].bounds);
+		}
+
+		const uint32_t wideIndex = static_cast<uint32_t>(wideBvh.nodes.size());
+		WideBvhNode wideNode{};
+		wideNode.origin = nodeBounds.minimum;
+		wideNode.childCount = static_cast<uint8_t>(childCount);
+
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			wideNode.exponents[axis] = QuantizationExponent(nodeBounds.maximum[axis] - nodeBounds.minimum[axis]);
+			while (wideNode.exponents[axis] < 127 && wideNode.origin[axis] + 255.0f * ExponentScale(wideNode.exponents[axis]) < nodeBounds.maximum[axis])
+			{
+				++wideNode.exponents[axis];
+			}
+			const float scale = ExponentScale(wideNode.exponents[axis]);
+
+			// Empty slots get inverted boxes.
+			wideNode.quantizedMinimum[axis].fill(255);
+			wideNode.quantizedMaximum[axis].fill(0);
+
+			for (uint32_t child{ 0 }; child < childCount; ++child)
+			{
+				const Bounds& childBounds = bvh.nodes[binaryChildren[child]].bounds;
+				wideNode.quantizedMinimum[axis][child] = QuantizeMinimum(childBounds.minimum[axis], wideNode.origin[axis], scale);
+				wideNode.quantizedMaximum[axis][child] = QuantizeMaximum(childBounds.maximum[axis], wideNode.origin[axis], scale);
+			}
+		}
+		wideBvh.nodes.push_back(wideNode);
+
+		for (uint32_t child{ 0 }; child < childCount; ++child)
+		{
+			const BvhNode& node = bvh.nodes[binaryChildren[child]];
+			const uint32_t target = node.primitiveCount > 0 ? node.offset : CollapseNode(bvh, binaryChildren[child], wideBvh);
+			wideBvh.nodes[wideIndex].children[child] = target;
+			wideBvh.nodes[wideIndex].primitiveCounts[child] = node.primitiveCount;
+		}
+
+		return wideIndex;
+	}
+
+	const float NodeArea(const WideBvhNode& node) noexcept
+	{
+		Bounds bounds{};
+		for (uint32_t child{ 0 }; child < node.childCount; ++child)
+		{
+			Grow(bounds, ChildBounds(node, child));
+		}
+		return SurfaceArea(bounds);
+	}
+
+	// Node indices in the order layout stores them, starting with the root.
+	const std::vector<uint32_t> LayoutOrder(const WideBvh& wideBvh, WideBvhLayout layout)
+	{
+		std::vector<uint32_t> order;
+		order.reserve(wideBvh.nodes.size());
+
+		const auto forEachInteriorChild = [&](uint32_t nodeIndex, auto&& function)
+		{
+			const WideBvhNode& node = wideBvh.nodes[nodeIndex];
+			for (uint32_t child{ 0 }; child < node.childCount; ++child)
+			{
+				if (node.primitiveCounts[child] == 0)
+				{
+					function(node.children[child]);
+				}
+			}
+		};
+
+		switch (layout)
+		{
+		case WideBvhLayout::DepthFirst:
+		{
+			std::vector<uint32_t> stack{ 0 };
+			while (!stack.empty())
+			{
+				const uint32_t nodeIndex = stack.back();
+				stack.pop_back();
+				order.push_back(nodeIndex);
+
+				const size_t firstChild = stack.size();
+				forEachInteriorChild(nodeIndex, [&](uint32_t child) { stack.push_back(child); });
+				std::reverse(stack.begin() + firstChild, stack.end());
+			}
+			break;
+		}
+		case WideBvhLayout::BreadthFirst:
+		{
+			order.push_back(0);
+			for (size_t i{ 0 }; i < order.size(); ++i)
+			{
+				forEachInteriorChild(order[i], [&](uint32_t child) { order.push_back(child); });
+			}
+			break;
+		}
+		case WideBvhLayout::Treelets:
+		{
+			std::deque<uint32_t> treeletRoots{ 0 };
+			std::vector<std::pair<float, uint32_t>> candidates;
+
+			while (!treeletRoots.empty())
+			{
+				candidates.assign(1, { NodeArea(wideBvh.nodes[treeletRoots.front()]), treeletRoots.front() });
+				treeletRoots.pop_front();
+
+				for (uint32_t treeletSize{ 0 }; treeletSize < wideBvhTreeletSize && !candidates.empty(); ++treeletSize)
+				{
+					std::pop_heap(candidates.begin(), candidates.end());
+					const uint32_t nodeIndex = candidates.back().second;
+					candidates.pop_back();
+					order.push_back(nodeIndex);
+
+					forEachInteriorChild(nodeIndex, [&](uint32_t child)
+					{
+						candidates.emplace_back(NodeArea(wideBvh.nodes[child]), child);
+						std::push_heap(candidates.begin(), candidates.end());
+					});
+				}
+
+				for (const auto& [area, nodeIndex] : candidates)
+				{
+					treeletRoots.push_back(nodeIndex);
+				}
+			}
+			break;
+		}
+		}
+
+		return order;
+	}
+
+	void ReorderNodes(WideBvh& wideBvh, WideBvhLayout layout)
+	{
+		const std::vector<uint32_t> order = LayoutOrder(wideBvh, layout);
+
+		std::vector<uint32_t> newIndices(wideBvh.nodes.size());
+		for (uint32_t i{ 0 }; i < order.size(); ++i)
+		{
+			newIndices[order[i]] = i;
+		}
+
+		std::vector<WideBvhNode> nodes(wideBvh.nodes.size());
+		for (uint32_t i{ 0 }; i < order.size(); ++i)
+		{
+			WideBvhNode& node = nodes[i];
+			node = wideBvh.nodes[order[i]];
+			for (uint32_t child{ 0 }; child < node.childCount; ++child)
+			{
+				if (node.primitiveCounts[child] == 0)
+				{
+					node.children[child] = newIndices[node.children[child]];
+				}
+			}
+		}
+
+		wideBvh.nodes = std::move(nodes);
+		wideBvh.layout = layout;
+	}
+}
+
+const WideBvh CollapseBvh(const Bvh& bvh, WideBvhLayout layout)
+{
+	LUX_PROFILE_ZONE("CollapseBvh");
+
+	WideBvh wideBvh{};
+	if (bvh.nodes.empty())
+	{
+		return wideBvh;
+	}
+
+	wideBvh.nodes.reserve(bvh.nodes.size() / 4 + 1);
+	wideBvh.primitiveIndices = bvh.primitiveIndices;
+	CollapseNode(bvh, 0, wideBvh);
+
+	// Collapsing already emits depth first order.
+	if (layout != WideBvhLayout::DepthFirst)
+	{
+		ReorderNodes(wideBvh, layout);
+	}
+
+	return wideBvh;
+}
+
+const Bounds ChildBounds(const WideBvhNode& node, uint32_t child) noexcept
+{
+	Bounds bounds{};
+	for (int axis{ 0 }; axis < 3; ++axis)
+	{
+		const float scale = ExponentScale(node.exponents[axis]);
+		bounds.minimum[axis] = node.origin[axis] + static_cast<float>(node.quantizedMinimum[axis][child]) * scale;
+		bounds.maximum[axis] = node.origin[axis] + static_cast<float>(node.quantizedMaximum[axis][child]) * scale;
+	}
+	return bounds;
+}
@@ -0,0 +1,231 @@
+#include "Test.h"
+
+#include "Mesh.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include "Triangle.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	constexpr float infinity = std::numeric_limits<float>::infinity();
+
+	const glm::vec3 NextPoint(RandomGenerator& random, float extent) noexcept
+	{
+		return extent * (2.0f * glm::vec3{ NextFloat(random), NextFloat(random), NextFloat(random) } - 1.0f);
+	}
+
+	// Small triangles scattered through a box, with a long sliver across
+	// all of it every sliverInterval triangles.
+	Mesh MakeScatteredMesh(uint32_t triangleCount, uint64_t seed, uint32_t sliverInterval = 16)
+	{
+		RandomGenerator random = SeedRandom(seed);
+		Mesh mesh;
+		for (uint32_t triangleIndex{ 0 }; triangleIndex < triangleCount; ++triangleIndex)
+		{
+			const bool sliver = sliverInterval > 0 && triangleIndex % sliverInterval == 0;
+			const glm::vec3 center = NextPoint(random, 10.0f);
+			for (uint32_t corner{ 0 }; corner < 3; ++corner)
+			{
+				mesh.posistions.push_back(sliver ? NextPoint(random, 10.0f) : center + NextPoint(random, 1.0f));
+			}
+		}
+		return mesh;
+	}
+
+	const Bounds TriangleBounds(const Mesh& mesh, uint32_t triangleIndex) noexcept
+	{
+		Bounds bounds{};
+		for (uint32_t corner{ 0 }; corner < 3; ++corner)
+		{
+			Grow(bounds, mesh.posistions[3 * triangleIndex + corner]);
+		}
+		return bounds;
+	}
+
+	const bool Contains(const Bounds& outer, const Bounds& inner) noexcept
+	{
+		return glm::min(outer.minimum, inner.minimum) == outer.minimum && glm::max(outer.maximum, inner.maximum) == outer.maximum;
+	}
+
+	// Every node contains its children and a leaf the whole triangles it
+	// references. Leaves of spatial builds only bound the parts of their
+	// triangles left after clipping, wholeTriangles skips them.
+	const bool NodesContainTriangles(const Mesh& mesh, bool wholeTriangles = true) noexcept
+	{
+		for (const BvhNode& node : mesh.bvh.nodes)
+		{
+			if (node.primitiveCount > 0)
+			{
+				if (!wholeTriangles)
+				{
+					continue;
+				}
+				for (uint32_t i{ 0 }; i < node.primitiveCount; ++i)
+				{
+					if (!Contains(node.bounds, TriangleBounds(mesh, mesh.bvh.primitiveIndices[node.offset + i])))
+					{
+						return false;
+					}
+				}
+			}
+			else if (!Contains(node.bounds, mesh.bvh.nodes[node.offset].bounds) || !Contains(node.bounds, mesh.bvh.nodes[node.offset + 1].bounds))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Every triangle is referenced by at least one leaf.
+	const bool AllTrianglesReachable(const Mesh& mesh)
+	{
+		std::vector<bool> reached(mesh.posistions.size() / 3, false);
+		for (const BvhNode& node : mesh.bvh.nodes)
+		{
+			for (uint32_t i{ 0 }; i < node.primitiveCount; ++i)
+			{
+				reached[mesh.bvh.primitiveIndices[node.offset + i]] = true;
+			}
+		}
+		return std::find(reached.begin(), reached.end(), false) == reached.end();
+	}
+
+	const float ClosestHitBruteForce(const Mesh& mesh, glm::vec3 origin, glm::vec3 direction) noexcept
+	{
+		const TriangleRay triangleRay = PrepareTriangleRay(origin, direction);
+		float closest = infinity;
+		for (uint32_t triangleIndex{ 0 }; 3 * triangleIndex < mesh.posistions.size(); ++triangleIndex)
+		{
+			closest = std::min(closest, IntersectTriangle(triangleRay, mesh.posistions[3 * triangleIndex], mesh.posistions[3 * triangleIndex + 1], mesh.posistions[3 * triangleIndex + 2], 0.0f, closest).distance);
+		}
+		return closest;
+	}
+
+	// Through the wide hierarchy tracing uses, or through the binary one it
+	// was collapsed from.
+	const float ClosestHit(const Mesh& mesh, glm::vec3 origin, glm::vec3 direction, bool wide) noexcept
+	{
+		const TriangleRay triangleRay = PrepareTriangleRay(origin, direction);
+		float closest = infinity;
+		const auto intersect = [&](uint32_t triangleIndex, float& maxDistance)
+		{
+			maxDistance = std::min(maxDistance, IntersectTriangle(triangleRay, mesh.posistions[3 * triangleIndex], mesh.posistions[3 * triangleIndex + 1], mesh.posistions[3 * triangleIndex + 2], 0.0f, maxDistance).distance);
+			return false;
+		};
+		if (wide)
+		{
+			TraverseWideBvh(mesh.wideBvh, origin, direction, closest, intersect);
+		}
+		else
+		{
+			TraverseBvh(mesh.bvh, origin, direction, closest, intersect);
+		}
+		return closest;
+	}
+
+	// Rays from around the mesh aimed into it, whose closest hits through
+	// both hierarchies of mesh differ from those through reference, or from
+	// testing every triangle when there is no reference.
+	const uint32_t CountMismatchedRays(const Mesh& mesh, const Mesh* reference = nullptr)
+	{
+		RandomGenerator random = SeedRandom(7);
+		uint32_t mismatches{ 0 };
+		for (uint32_t rayIndex{ 0 }; rayIndex < 1024; ++rayIndex)
+		{
+			const glm::vec3 origin = NextPoint(random, 15.0f);
+			const glm::vec3 direction = glm::normalize(NextPoint(random, 10.0f) - origin);
+			const float expected = reference ? ClosestHit(*reference, origin, direction, true) : ClosestHitBruteForce(mesh, origin, direction);
+			if (ClosestHit(mesh, origin, direction, true) != expected || ClosestHit(mesh, origin, direction, false) != expected)
+			{
+				++mismatches;
+			}
+		}
+		return mismatches;
+	}
+}
+
+LUX_TEST(MeshRefit)
+{
+	for (const BvhBuildMode mode : { BvhBuildMode::Sah, BvhBuildMode::Linear, BvhBuildMode::Spatial })
+	{
+		BvhBuildSettings settings{};
+		settings.mode = mode;
+		// Refitting a spatial tree bounds whole slivers where it had split
+		// them, which costs more than a rebuild.
+		Mesh mesh = MakeScatteredMesh(1000, 1, mode == BvhBuildMode::Spatial ? 0 : 16);
+		BuildMeshBvh(mesh, settings);
+		// Some triangles still straddle a spatial split and sit in two leaves.
+		LUX_CHECK(mode != BvhBuildMode::Spatial || mesh.bvh.primitiveIndices.size() > mesh.posistions.size() / 3);
+
+		// Wobbling in place keeps the tree good enough to refit.
+		RandomGenerator random = SeedRandom(2);
+		for (glm::vec3& position : mesh.posistions)
+		{
+			position += NextPoint(random, 0.1f);
+		}
+		LUX_CHECK(!RefitMeshBvh(mesh));
+		LUX_CHECK(NodesContainTriangles(mesh));
+		Mesh fresh;
+		fresh.posistions = mesh.posistions;
+		BuildMeshBvh(fresh, settings);
+		LUX_CHECK(CountMismatchedRays(mesh, &fresh) == 0);
+		LUX_CHECK(CountMismatchedRays(mesh) == 0);
+
+		// Corners thrown across the whole box stretch every triangle, the
+		// old tree is no longer worth keeping.
+		for (glm::vec3& position : mesh.posistions)
+		{
+			position = NextPoint(random, 10.0f);
+		}
+		LUX_CHECK(RefitMeshBvh(mesh));
+		LUX_CHECK(NodesContainTriangles(mesh, mode != BvhBuildMode::Spatial));
+		LUX_CHECK(CountMismatchedRays(mesh) == 0);
+	}
+}
+
+LUX_TEST(LinearBvhClosestHits)
+{
+	// Copies of some triangles give equal Morton codes, which only the
+	// index bits tell apart.
+	Mesh mesh = MakeScatteredMesh(4000, 3);
+	mesh.posistions.insert(mesh.posistions.end(), mesh.posistions.begin(), mesh.posistions.begin() + 3 * 96);
+
+	ThreadPool threadPool{ 4 };
+	for (const uint32_t mortonBits : { 30u, 63u })
+	{
+		for (ThreadPool* pool : { static_cast<ThreadPool*>(nullptr), &threadPool })
+		{
+			BvhBuildSettings settings{};
+			settings.mode = BvhBuildMode::Linear;
+			settings.mortonBits = mortonBits;
+			settings.threadPool = pool;
+			BuildMeshBvh(mesh, settings);
+			LUX_CHECK(mesh.bvh.primitiveIndices.size() == mesh.posistions.size() / 3);
+			LUX_CHECK(AllTrianglesReachable(mesh));
+			LUX_CHECK(NodesContainTriangles(mesh));
+			LUX_CHECK(CountMismatchedRays(mesh) == 0);
+		}
+	}
+}
+
+LUX_TEST(SpatialBvhClosestHits)
+{
+	Mesh mesh = MakeScatteredMesh(4000, 4);
+	BvhBuildSettings settings{};
+	settings.mode = BvhBuildMode::Spatial;
+	BuildMeshBvh(mesh, settings);
+
+	// The slivers must have been split, or this tests a plain SAH tree.
+	LUX_CHECK(mesh.bvh.primitiveIndices.size() > mesh.posistions.size() / 3);
+	LUX_CHECK(AllTrianglesReachable(mesh));
+	LUX_CHECK(NodesContainTriangles(mesh, false));
+	LUX_CHECK(CountMismatchedRays(mesh) == 0);
+}
@@ -0,0 +1,42 @@
+#include "Test.h"
+
+#include "CacheKey.h"
+
+#include <fstream>
+#include <sstream>
+
+LUX_TEST(CacheKeySource)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "LuxCacheKeySource";
+	std::filesystem::create_directories(directory / "Nested");
+	const std::filesystem::path sourcePath = directory / "Source.bin";
+	std::ofstream{ sourcePath, std::ios::binary } << "four";
+
+	// The same file named two ways shares its key, and with it its cached
+	// file.
+	const std::optional<CacheKey> key = MakeCacheKey(sourcePath, "#0");
+	const std::optional<CacheKey> indirectKey = MakeCacheKey(directory / "Nested" / ".." / "Source.bin", "#0");
+	LUX_CHECK(key && indirectKey);
+	if (!key || !indirectKey)
+	{
+		return;
+	}
+	LUX_CHECK(*key == *indirectKey);
+	LUX_CHECK(key->sourceSize == 4);
+	LUX_CHECK(CachePath(directory, *key, ".luxtex") == CachePath(directory, *indirectKey, ".luxtex"));
+	LUX_CHECK(MakeCacheKey(sourcePath, "#1") != key);
+	LUX_CHECK(!MakeCacheKey(directory / "Missing.bin"));
+
+	std::ofstream{ sourcePath, std::ios::binary } << "five!";
+	LUX_CHECK(MakeCacheKey(sourcePath, "#0") != key);
+
+	std::stringstream stream{};
+	WriteCacheKey(stream, *key);
+	LUX_CHECK(ReadCacheKey(stream) == key);
+
+	// Cut short.
+	std::stringstream truncated{ stream.str().substr(0, stream.str().size() - 1) };
+	LUX_CHECK(!ReadCacheKey(truncated));
+
+	std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,24 @@
+#include "Test.h"
+
+#include "Environment.h"
+
+LUX_TEST(EnvironmentCacheKeyMismatch)
+{
+	const CacheKey key{ "LuxTests#environment", 1, 2 };
+	std::vector<glm::vec3> radiance(8 * 4);
+	for (size_t pixel{ 0 }; pixel < radiance.size(); ++pixel)
+	{
+		radiance[pixel] = glm::vec3{ static_cast<float>(pixel) };
+	}
+	const EnvironmentMap environment = MakeEnvironmentMap(8, 4, std::move(radiance));
+
+	const std::filesystem::path filePath = std::filesystem::temp_directory_path() / "LuxEnvironmentCacheKeyMismatch.luxenv";
+	LUX_CHECK(WriteEnvironmentCache(environment, key, filePath));
+
+	const std::optional<EnvironmentMap> cached = ReadEnvironmentCache(filePath, key);
+	LUX_CHECK(cached && cached->radiance == environment.radiance && cached->conditionalCdfs == environment.conditionalCdfs);
+	LUX_CHECK(!ReadEnvironmentCache(filePath, CacheKey{ key.identity, key.sourceSize + 1, key.sourceWriteTime }));
+	LUX_CHECK(!ReadEnvironmentCache(filePath, CacheKey{ key.identity, key.sourceSize, key.sourceWriteTime + 1 }));
+	LUX_CHECK(!ReadEnvironmentCache(filePath, CacheKey{ "LuxTests#other", key.sourceSize, key.sourceWriteTime }));
+	std::filesystem::remove(filePath);
+}
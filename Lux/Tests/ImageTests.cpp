@@ -0,0 +1,357 @@
+#include "Test.h"
+
+#include "Image.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+	struct PngFormat
+	{
+		uint8_t colorType;
+		uint8_t bitDepth;
+	};
+
+	constexpr std::array<PngFormat, 15> validFormats
+	{
+		PngFormat{ 0, 1 }, PngFormat{ 0, 2 }, PngFormat{ 0, 4 }, PngFormat{ 0, 8 }, PngFormat{ 0, 16 },
+		PngFormat{ 2, 8 }, PngFormat{ 2, 16 },
+		PngFormat{ 3, 1 }, PngFormat{ 3, 2 }, PngFormat{ 3, 4 }, PngFormat{ 3, 8 },
+		PngFormat{ 4, 8 }, PngFormat{ 4, 16 },
+		PngFormat{ 6, 8 }, PngFormat{ 6, 16 }
+	};
+
+	const uint32_t ChannelCount(uint8_t colorType) noexcept
+	{
+		switch (colorType)
+		{
+		case 2:
+			return 3;
+		case 4:
+			return 2;
+		case 6:
+			return 4;
+		default:
+			return 1;
+		}
+	}
+
+	void AppendBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		for (const uint32_t shift : { 24u, 16u, 8u, 0u })
+		{
+			bytes.push_back(static_cast<uint8_t>(value >> shift));
+		}
+	}
+
+	void AppendChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data)
+	{
+		AppendBigEndian(png, static_cast<uint32_t>(data.size()));
+		const size_t typeStart = png.size();
+		png.insert(png.end(), type, type + 4);
+		png.insert(png.end(), data.begin(), data.end());
+
+		uint32_t crc{ 0xffffffff };
+		for (size_t i{ typeStart }; i < png.size(); ++i)
+		{
+			crc ^= png[i];
+			for (int bit{ 0 }; bit < 8; ++bit)
+			{
+				crc = crc & 1 ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+			}
+		}
+		AppendBigEndian(png, crc ^ 0xffffffff);
+	}
+
+	// zlib stream of stored deflate blocks.
+	const std::vector<uint8_t> Store(const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> stream{ 0x78, 0x01 };
+		size_t position{ 0 };
+		do
+		{
+			const size_t length = std::min<size_t>(data.size() - position, 0xffff);
+			stream.push_back(position + length == data.size() ? 1 : 0);
+			stream.push_back(static_cast<uint8_t>(length));
+			stream.push_back(static_cast<uint8_t>(length >> 8));
+			stream.push_back(static_cast<uint8_t>(~length));
+			stream.push_back(static_cast<uint8_t>(~length >> 8));
+			stream.insert(stream.end(), data.begin() + position, data.begin() + position + length);
+			position += length;
+		} while (position < data.size());
+
+		uint32_t a{ 1 };
+		uint32_t b{ 0 };
+		for (const uint8_t byte : data)
+		{
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		AppendBigEndian(stream, b << 16 | a);
+		return stream;
+	}
+
+	const std::vector<uint8_t> MakePng(uint32_t width, uint32_t height, PngFormat format, const std::vector<uint8_t>& stream, const std::vector<uint8_t>& palette = {}, const std::vector<uint8_t>& paletteAlpha = {})
+	{
+		std::vector<uint8_t> png{ 137, 80, 78, 71, 13, 10, 26, 10 };
+		std::vector<uint8_t> header;
+		AppendBigEndian(header, width);
+		AppendBigEndian(header, height);
+		header.insert(header.end(), { format.bitDepth, format.colorType, 0, 0, 0 });
+		AppendChunk(png, "IHDR", header);
+		if (!palette.empty())
+		{
+			AppendChunk(png, "PLTE", palette);
+		}
+		if (!paletteAlpha.empty())
+		{
+			AppendChunk(png, "tRNS", paletteAlpha);
+		}
+		AppendChunk(png, "IDAT", stream);
+		AppendChunk(png, "IEND", {});
+		return png;
+	}
+
+	const uint8_t Paeth(uint8_t left, uint8_t up, uint8_t upLeft) noexcept
+	{
+		const int32_t estimate = static_cast<int32_t>(left) + up - upLeft;
+		const int32_t leftDistance = std::abs(estimate - left);
+		const int32_t upDistance = std::abs(estimate - up);
+		const int32_t upLeftDistance = std::abs(estimate - upLeft);
+		if (leftDistance <= upDistance && leftDistance <= upLeftDistance)
+		{
+			return left;
+		}
+		return upDistance <= upLeftDistance ? up : upLeft;
+	}
+
+	// Prefixes every row with its filter type and filters it, with filter
+	// 5 standing for all five types in turn.
+	const std::vector<uint8_t> FilterRows(const std::vector<uint8_t>& rows, size_t rowBytes, size_t bytesPerPixel, uint8_t filter)
+	{
+		std::vector<uint8_t> filtered;
+		for (size_t row{ 0 }; row * rowBytes < rows.size(); ++row)
+		{
+			const uint8_t rowFilter = filter == 5 ? static_cast<uint8_t>(row % 5) : filter;
+			filtered.push_back(rowFilter);
+			for (size_t i{ 0 }; i < rowBytes; ++i)
+			{
+				const size_t index = row * rowBytes + i;
+				const uint8_t left = i >= bytesPerPixel ? rows[index - bytesPerPixel] : 0;
+				const uint8_t up = row > 0 ? rows[index - rowBytes] : 0;
+				const uint8_t upLeft = row > 0 && i >= bytesPerPixel ? rows[index - rowBytes - bytesPerPixel] : 0;
+
+				const uint8_t predictions[5]{ 0, left, up, static_cast<uint8_t>((left + up) / 2), Paeth(left, up, upLeft) };
+				filtered.push_back(static_cast<uint8_t>(rows[index] - predictions[rowFilter]));
+			}
+		}
+		return filtered;
+	}
+
+	struct TestImage
+	{
+		std::vector<uint8_t> png;
+		// What DecodePng should return.
+		Rgba8Image expected;
+	};
+
+	// Every sample is random, palette images index a palette with as many
+	// entries as the bit depth can address, half of them translucent.
+	const TestImage MakeTestImage(uint32_t width, uint32_t height, PngFormat format, uint8_t filter)
+	{
+		std::mt19937 random{ 7u * format.colorType + format.bitDepth };
+		const uint32_t channelCount = ChannelCount(format.colorType);
+		const uint32_t maximumSample = (1u << format.bitDepth) - 1;
+		const size_t rowBytes = (static_cast<size_t>(width) * channelCount * format.bitDepth + 7) / 8;
+
+		std::vector<uint8_t> palette;
+		std::vector<uint8_t> paletteAlpha;
+		if (format.colorType == 3)
+		{
+			for (uint32_t entry{ 0 }; entry <= maximumSample; ++entry)
+			{
+				palette.insert(palette.end(), { static_cast<uint8_t>(entry * 3), static_cast<uint8_t>(entry * 5 + 1), static_cast<uint8_t>(entry * 7 + 2) });
+			}
+			for (uint32_t entry{ 0 }; entry <= maximumSample / 2; ++entry)
+			{
+				paletteAlpha.push_back(static_cast<uint8_t>(entry * 11));
+			}
+		}
+
+		TestImage image{ {}, Rgba8Image{ static_cast<int32_t>(width), static_cast<int32_t>(height) } };
+		image.expected.pixels.resize(static_cast<size_t>(width) * height * 4);
+		std::vector<uint8_t> rows(rowBytes * height, 0);
+		for (uint32_t y{ 0 }; y < height; ++y)
+		{
+			for (uint32_t x{ 0 }; x < width; ++x)
+			{
+				std::array<uint32_t, 4> samples{};
+				for (uint32_t channel{ 0 }; channel < channelCount; ++channel)
+				{
+					const uint32_t sample = random() & maximumSample;
+					samples[channel] = sample;
+
+					const size_t bit = y * rowBytes * 8 + (static_cast<size_t>(x) * channelCount + channel) * format.bitDepth;
+					if (format.bitDepth == 16)
+					{
+						rows[bit / 8] = static_cast<uint8_t>(sample >> 8);
+						rows[bit / 8 + 1] = static_cast<uint8_t>(sample);
+					}
+					else
+					{
+						rows[bit / 8] |= static_cast<uint8_t>(sample << (8 - format.bitDepth - bit % 8));
+					}
+				}
+
+				uint8_t* pixel = &image.expected.pixels[(static_cast<size_t>(y) * width + x) * 4];
+				if (format.colorType == 3)
+				{
+					std::copy_n(&palette[3 * samples[0]], 3, pixel);
+					pixel[3] = samples[0] < paletteAlpha.size() ? paletteAlpha[samples[0]] : 255;
+					continue;
+				}
+
+				const auto scaled = [&](uint32_t sample) { return static_cast<uint8_t>(format.bitDepth == 16 ? sample >> 8 : sample * 255 / maximumSample); };
+				const bool gray = channelCount < 3;
+				for (uint32_t channel{ 0 }; channel < 3; ++channel)
+				{
+					pixel[channel] = scaled(samples[gray ? 0 : channel]);
+				}
+				pixel[3] = channelCount % 2 == 0 ? scaled(samples[channelCount - 1]) : 255;
+			}
+		}
+
+		const size_t bytesPerPixel = std::max<size_t>(channelCount * format.bitDepth / 8, 1);
+		image.png = MakePng(width, height, format, Store(FilterRows(rows, rowBytes, bytesPerPixel, filter)), palette, paletteAlpha);
+		return image;
+	}
+
+	// Fixed and dynamic Huffman blocks written by zlib, of a 16 x 16 RGBA
+	// image of 4 x 4 blocks with unfiltered rows.
+	const std::vector<uint8_t> fixedStream
+	{
+		0x78, 0x01, 0x63, 0x60, 0x60, 0x68, 0xf8, 0x8f, 0x8c, 0x1d, 0xd0, 0x70, 0x03, 0x1a, 0x3e, 0x80, 0x86, 0x19, 0x86, 0x83, 0x01, 0x0e, 0x40, 0x02,
+		0x09, 0x3b, 0xa0, 0xe1, 0x06, 0x34, 0x7c, 0x00, 0x0d, 0x0f, 0x0b, 0x03, 0x1a, 0x80, 0x04, 0x12, 0x76, 0x40, 0xc3, 0x0d, 0x68, 0xf8, 0x00, 0x1a,
+		0x1e, 0x16, 0x06, 0x1c, 0x00, 0x12, 0x48, 0xd8, 0x01, 0x0d, 0x37, 0xa0, 0xe1, 0x03, 0x68, 0x78, 0x18, 0x18, 0x00, 0x00, 0xfc, 0xd8, 0x3f, 0x1f
+	};
+	const std::vector<uint8_t> dynamicStream
+	{
+		0x78, 0xda, 0xdd, 0xcc, 0x31, 0x11, 0x00, 0x30, 0x0c, 0xc3, 0xc0, 0x40, 0x33, 0x34, 0x43, 0x33, 0xb3, 0x36, 0xa3, 0x4f, 0x10, 0x32, 0xbc, 0x46,
+		0xcd, 0x8c, 0x5f, 0x13, 0x18, 0x02, 0x73, 0x61, 0xa0, 0x4d, 0x11, 0x18, 0x02, 0x27, 0x06, 0xde, 0x14, 0x81, 0x21, 0x70, 0x62, 0x90, 0x4d, 0x11,
+		0x18, 0x02, 0x07, 0x06, 0x1f, 0xfc, 0xd8, 0x3f, 0x1f
+	};
+
+	const bool Matches(const std::optional<Rgba8Image>& image, const Rgba8Image& expected)
+	{
+		return image && image->width == expected.width && image->height == expected.height && image->pixels == expected.pixels;
+	}
+}
+
+// Odd sizes leave partly used bytes at the end of low bit depth rows.
+LUX_TEST(PngFormatsAndFilters)
+{
+	for (const PngFormat format : validFormats)
+	{
+		for (uint8_t filter{ 0 }; filter <= 5; ++filter)
+		{
+			const TestImage image = MakeTestImage(13, 7, format, filter);
+			LUX_CHECK(Matches(DecodePng(image.png), image.expected));
+		}
+	}
+}
+
+LUX_TEST(PngCompressedBlocks)
+{
+	Rgba8Image expected{ 16, 16 };
+	for (int32_t y{ 0 }; y < 16; ++y)
+	{
+		for (int32_t x{ 0 }; x < 16; ++x)
+		{
+			expected.pixels.insert(expected.pixels.end(), { static_cast<uint8_t>(x / 4 * 64), static_cast<uint8_t>(y / 4 * 64), 128, 255 });
+		}
+	}
+
+	LUX_CHECK(Matches(DecodePng(MakePng(16, 16, PngFormat{ 6, 8 }, fixedStream)), expected));
+	LUX_CHECK(Matches(DecodePng(MakePng(16, 16, PngFormat{ 6, 8 }, dynamicStream)), expected));
+
+	// Decoding stops after the last row, whatever follows in the stream.
+	std::vector<uint8_t> rows = FilterRows(std::vector<uint8_t>(15 * 3, 0), 15, 3, 0);
+	rows.resize(rows.size() + 100000, 0);
+	const std::optional<Rgba8Image> decoded = DecodePng(MakePng(5, 3, PngFormat{ 2, 8 }, Store(rows)));
+	LUX_CHECK(decoded && decoded->pixels.size() == 5 * 3 * 4);
+}
+
+LUX_TEST(PngInvalidBitDepths)
+{
+	for (uint8_t colorType{ 0 }; colorType <= 7; ++colorType)
+	{
+		for (uint8_t bitDepth{ 0 }; bitDepth <= 17; ++bitDepth)
+		{
+			const bool valid = std::any_of(validFormats.begin(), validFormats.end(), [&](PngFormat format) { return format.colorType == colorType && format.bitDepth == bitDepth; });
+			if (valid)
+			{
+				continue;
+			}
+
+			// Enough data and a palette for any depth, only the header is wrong.
+			const std::vector<uint8_t> rows(4 * (1 + 4 * 4 * 2), 0);
+			const std::vector<uint8_t> palette(3 * 256, 0);
+			LUX_CHECK(!DecodePng(MakePng(4, 4, PngFormat{ colorType, bitDepth }, Store(rows), palette)));
+		}
+	}
+}
+
+LUX_TEST(PngTruncated)
+{
+	const TestImage image = MakeTestImage(9, 6, PngFormat{ 6, 16 }, 5);
+	// Without its IEND chunk the file still holds the whole image.
+	const size_t imageEnd = image.png.size() - 12;
+	for (size_t size{ 0 }; size < image.png.size(); ++size)
+	{
+		const std::vector<uint8_t> truncated{ image.png.begin(), image.png.begin() + size };
+		const std::optional<Rgba8Image> decoded = DecodePng(truncated);
+		LUX_CHECK(size < imageEnd ? !decoded : Matches(decoded, image.expected));
+	}
+
+	// A complete IDAT chunk holding only part of the stream.
+	std::vector<uint8_t> rows = FilterRows(std::vector<uint8_t>(9 * 8 * 6, 0), 9 * 8, 8, 0);
+	rows.resize(rows.size() / 2);
+	LUX_CHECK(!DecodePng(MakePng(9, 6, PngFormat{ 6, 16 }, Store(rows))));
+}
+
+LUX_TEST(PngCorrupt)
+{
+	const TestImage image = MakeTestImage(8, 8, PngFormat{ 2, 8 }, 0);
+	std::vector<uint8_t> badHeader = image.png;
+	// First byte of the zlib stream, after signature, IHDR and the IDAT
+	// length and type.
+	badHeader[8 + 25 + 8] = 0x79;
+	LUX_CHECK(!DecodePng(badHeader));
+
+	// Filter type 5 does not exist.
+	const std::vector<uint8_t> rows(8 * (1 + 8 * 3), 5);
+	LUX_CHECK(!DecodePng(MakePng(8, 8, PngFormat{ 2, 8 }, Store(rows))));
+
+	// Deflate block type 3 is reserved.
+	LUX_CHECK(!DecodePng(MakePng(8, 8, PngFormat{ 2, 8 }, { 0x78, 0x01, 0x07, 0x00 })));
+
+	// Palette images need a palette.
+	LUX_CHECK(!DecodePng(MakePng(8, 8, PngFormat{ 3, 8 }, Store(std::vector<uint8_t>(8 * 9, 0)))));
+
+	// Random damage may still decode, but only to an image of the right size.
+	std::mt19937 random{ 1 };
+	const std::vector<uint8_t> compressed = MakePng(16, 16, PngFormat{ 6, 8 }, dynamicStream);
+	for (uint32_t trial{ 0 }; trial < 2000; ++trial)
+	{
+		std::vector<uint8_t> damaged = trial % 2 == 0 ? image.png : compressed;
+		for (uint32_t flip{ 0 }; flip < 1 + trial % 4; ++flip)
+		{
+			damaged[8 + random() % (damaged.size() - 8)] ^= static_cast<uint8_t>(1u << random() % 8);
+		}
+		const std::optional<Rgba8Image> decoded = DecodePng(damaged);
+		LUX_CHECK(!decoded || decoded->pixels.size() == static_cast<size_t>(decoded->width) * decoded->height * 4);
+	}
+}
@@ -0,0 +1,46 @@
+#include "Test.h"
+
+#include "Mesh.h"
+
+#include <glm/geometric.hpp>
+
+#include <cmath>
+
+namespace
+{
+	// One triangle whose corners all carry the given normal and tangent.
+	Mesh MakeTriangle(glm::vec3 normal, glm::vec4 tangent)
+	{
+		Mesh mesh;
+		mesh.posistions = { glm::vec3{ 0.0f }, glm::vec3{ 1.0f, 0.0f, 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f } };
+		mesh.normals.assign(3, normal);
+		mesh.tangents.assign(3, tangent);
+		return mesh;
+	}
+}
+
+LUX_TEST(PackedZeroDirections)
+{
+	Mesh zero = MakeTriangle(glm::vec3{ 0.0f }, glm::vec4{ 0.0f, 0.0f, 0.0f, -1.0f });
+	QuantizeAttributes(zero);
+	const glm::vec3 normal = InterpolateNormal(zero, 0, 0.25f, 0.25f);
+	const glm::vec4 tangent = InterpolateTangent(zero, 0, 0.25f, 0.25f);
+	LUX_CHECK(normal == glm::vec3{ 0.0f });
+	LUX_CHECK(glm::vec3{ tangent } == glm::vec3{ 0.0f });
+	LUX_CHECK(tangent.w == -1.0f);
+
+	// Directions next to the reserved code still come back as themselves.
+	for (const glm::vec3 direction : { glm::vec3{ -1.0f, 0.0f, 0.0f }, glm::vec3{ -1.0f, 0.0f, -1e-4f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.3f, -0.5f, 0.8f } })
+	{
+		const glm::vec3 unit = glm::normalize(direction);
+		Mesh mesh = MakeTriangle(unit, glm::vec4{ unit, 1.0f });
+		QuantizeAttributes(mesh);
+		LUX_CHECK(glm::distance(InterpolateNormal(mesh, 0, 0.25f, 0.25f), unit) < 1e-3f);
+		LUX_CHECK(glm::distance(glm::vec3{ InterpolateTangent(mesh, 0, 0.25f, 0.25f) }, unit) < 1e-3f);
+	}
+
+	Mesh notANumber = MakeTriangle(glm::vec3{ std::nanf("") }, glm::vec4{ std::nanf(""), 0.0f, 0.0f, 1.0f });
+	QuantizeAttributes(notANumber);
+	LUX_CHECK(InterpolateNormal(notANumber, 0, 0.25f, 0.25f) == glm::vec3{ 0.0f });
+	LUX_CHECK(glm::vec3{ InterpolateTangent(notANumber, 0, 0.25f, 0.25f) } == glm::vec3{ 0.0f });
+}
@@ -0,0 +1,81 @@
+#include "Test.h"
+
+#include "ResourceManager.h"
+#include "Ray.h"
+#include "Scene.h"
+#include "SceneGraph.h"
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+LUX_TEST(GltfMaterialsPerPrimitive)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "LuxGltfMaterialsPerPrimitive";
+	std::filesystem::create_directories(directory);
+
+	// Three triangles side by side along x, the outer two red and the
+	// middle one green, each in its own primitive of a single mesh.
+	std::array<glm::vec3, 9> positions{};
+	for (size_t triangle{ 0 }; triangle < 3; ++triangle)
+	{
+		const float x = 2.0f * static_cast<float>(triangle);
+		positions[3 * triangle] = glm::vec3{ x, 0.0f, 0.0f };
+		positions[3 * triangle + 1] = glm::vec3{ x + 1.0f, 0.0f, 0.0f };
+		positions[3 * triangle + 2] = glm::vec3{ x, 1.0f, 0.0f };
+	}
+	std::ofstream{ directory / "Pair.bin", std::ios::binary }.write(reinterpret_cast<const char*>(positions.data()), sizeof(positions));
+	std::ofstream{ directory / "Pair.gltf" } << R"({
+	"asset": { "version": "2.0" },
+	"buffers": [ { "uri": "Pair.bin", "byteLength": 108 } ],
+	"bufferViews": [ { "buffer": 0, "byteOffset": 0, "byteLength": 108 } ],
+	"accessors": [
+		{ "bufferView": 0, "byteOffset": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [ 0, 0, 0 ], "max": [ 1, 1, 0 ] },
+		{ "bufferView": 0, "byteOffset": 36, "componentType": 5126, "count": 3, "type": "VEC3", "min": [ 2, 0, 0 ], "max": [ 3, 1, 0 ] },
+		{ "bufferView": 0, "byteOffset": 72, "componentType": 5126, "count": 3, "type": "VEC3", "min": [ 4, 0, 0 ], "max": [ 5, 1, 0 ] }
+	],
+	"materials": [
+		{ "name": "Red", "pbrMetallicRoughness": { "baseColorFactor": [ 1, 0, 0, 1 ], "metallicFactor": 0 } },
+		{ "name": "Green", "pbrMetallicRoughness": { "baseColorFactor": [ 0, 1, 0, 1 ], "metallicFactor": 0 } }
+	],
+	"meshes": [ { "name": "Pair", "primitives": [
+		{ "attributes": { "POSITION": 0 }, "material": 0 },
+		{ "attributes": { "POSITION": 1 }, "material": 1 },
+		{ "attributes": { "POSITION": 2 }, "material": 0 }
+	] } ],
+	"nodes": [ { "name": "Pair", "mesh": 0 } ],
+	"scenes": [ { "nodes": [ 0 ] } ],
+	"scene": 0
+})";
+
+	ResourceManager resourceManager{};
+	SceneGraph graph = resourceManager.ImportFromGltf(directory / "Pair.gltf");
+	Scene scene{};
+	InstantiateSceneGraph(graph, scene, resourceManager, Material{ glm::vec3{ 1.0f }, 0.0f });
+	BuildAccelerationStructure(scene);
+
+	// The primitives sharing red make one mesh, green another.
+	LUX_CHECK(resourceManager.GetMeshCount() == 2);
+	LUX_CHECK(scene.objects.size() == 2);
+	if (resourceManager.GetMeshCount() == 2)
+	{
+		LUX_CHECK(resourceManager.GetMeshByIndex(0).posistions.size() == 6);
+		LUX_CHECK(resourceManager.GetMeshByIndex(1).posistions.size() == 3);
+	}
+
+	const std::array<glm::vec3, 3> expectedColors{ glm::vec3{ 1.0f, 0.0f, 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }, glm::vec3{ 1.0f, 0.0f, 0.0f } };
+	for (size_t triangle{ 0 }; triangle < expectedColors.size(); ++triangle)
+	{
+		const Ray ray{ glm::vec3{ 2.0f * static_cast<float>(triangle) + 0.25f, 0.25f, 1.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f } };
+		const std::optional<Hit> hit = ClosestIntersection(scene, ray);
+		LUX_CHECK(hit);
+		if (hit)
+		{
+			const HitRecord record = ComputeHitAttributes(scene, ray, *hit);
+			LUX_CHECK(scene.materials.sources[record.material]->albedoColor == expectedColors[triangle]);
+		}
+	}
+
+	std::filesystem::remove_all(directory);
+}
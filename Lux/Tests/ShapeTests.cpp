@@ -0,0 +1,31 @@
+#include "Test.h"
+
+#include "Shape.h"
+
+#include <glm/geometric.hpp>
+
+#include <cmath>
+#include <limits>
+
+LUX_TEST(BoxFaceNormals)
+{
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	const Box cube{ glm::vec3{ -1.0f }, glm::vec3{ 1.0f }, 0 };
+	LUX_CHECK(NormalAt(cube, glm::vec3{ 1.0f, 0.2f, -0.5f }) == glm::vec3(1.0f, 0.0f, 0.0f));
+	LUX_CHECK(NormalAt(cube, glm::vec3{ 0.9f, -1.0f, 0.3f }) == glm::vec3(0.0f, -1.0f, 0.0f));
+
+	// Near the end of a long face, the short axis is still further from
+	// its plane.
+	const Box beam{ glm::vec3{ -5.0f, -0.5f, -0.5f }, glm::vec3{ 5.0f, 0.5f, 0.5f }, 0 };
+	LUX_CHECK(NormalAt(beam, glm::vec3{ 4.8f, 0.5f, 0.1f }) == glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// A wall without thickness, hit on its flat face.
+	const Box wall{ glm::vec3{ -1.0f, 0.0f, -1.0f }, glm::vec3{ 1.0f, 0.0f, 1.0f }, 0 };
+	const glm::vec3 origin{ 0.3f, 2.0f, -0.4f };
+	const glm::vec3 direction{ 0.0f, -1.0f, 0.0f };
+	const float distance = Intersect(wall, origin, direction, 0.0f, infinity);
+	LUX_CHECK(distance == 2.0f);
+	const glm::vec3 normal = NormalAt(wall, origin + distance * direction);
+	LUX_CHECK(std::abs(normal.y) == 1.0f && normal.x == 0.0f && normal.z == 0.0f);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+// Registers a test under its name, LuxTests runs the one named on the
+// command line or all of them.
+#define LUX_TEST(name) \
+	static void name(); \
+	static const TestRegistration name##Registration{ #name, name }; \
+	static void name()
+
+// Reports a failed check and lets the test go on, so one run shows every
+// check that fails.
+#define LUX_CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			ReportFailure(#condition, __FILE__, __LINE__); \
+		} \
+	} while (false)
+
+struct TestCase
+{
+	const char* name;
+	void (*run)();
+};
+
+std::vector<TestCase>& RegisteredTests();
+void ReportFailure(const char* condition, const char* file, int line);
+
+struct TestRegistration
+{
+	TestRegistration(const char* name, void (*run)())
+	{
+		RegisteredTests().push_back(TestCase{ name, run });
+	}
+};
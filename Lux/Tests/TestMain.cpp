@@ -0,0 +1,45 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <string_view>
+
+namespace
+{
+	int failureCount{ 0 };
+}
+
+std::vector<TestCase>& RegisteredTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void ReportFailure(const char* condition, const char* file, int line)
+{
+	std::printf("%s:%d: check failed: %s\n", file, line, condition);
+	++failureCount;
+}
+
+int main(int argc, char** argv)
+{
+	bool found{ false };
+	for (const TestCase& test : RegisteredTests())
+	{
+		if (argc > 1 && std::string_view{ argv[1] } != test.name)
+		{
+			continue;
+		}
+
+		found = true;
+		const int failuresBefore = failureCount;
+		test.run();
+		std::printf("%s %s\n", failureCount == failuresBefore ? "Passed" : "Failed", test.name);
+	}
+
+	if (!found)
+	{
+		std::printf("No test named %s\n", argv[1]);
+		return 1;
+	}
+	return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#include "Test.h"
+
+#include "Image.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+namespace
+{
+	const CacheKey testKey{ "LuxTests#texture", 1, 2 };
+
+	// 512x512 texels and their mip chain, more pages than the smallest
+	// cache holds.
+	const Texture MakeNoiseTexture()
+	{
+		std::mt19937 random{ 3 };
+		Rgba8Image image{ 512, 512 };
+		image.pixels.resize(512 * 512 * 4);
+		std::generate(image.pixels.begin(), image.pixels.end(), [&] { return static_cast<uint8_t>(random()); });
+		return MakeTexture(image, false);
+	}
+
+	const std::filesystem::path WriteTestTexture(const Texture& texture, const char* name)
+	{
+		const std::filesystem::path filePath = std::filesystem::temp_directory_path() / name;
+		return WriteTiledTexture(texture, testKey, filePath) ? filePath : std::filesystem::path{};
+	}
+
+	const bool FetchMatches(TextureCache& cache, const Texture& cached, const Texture& texture, uint32_t level, uint32_t x, uint32_t y)
+	{
+		const TextureLevel& expected = texture.levels[level];
+		const uint32_t right = std::min(x + 1, expected.width - 1);
+		const uint32_t bottom = std::min(y + 1, expected.height - 1);
+		const std::array<uint32_t, 4> quad = cache.FetchQuad(cached.cacheID, level, { x, right }, { y, bottom });
+		return quad[0] == expected.texels[TexelIndex(expected, x, y)] && quad[1] == expected.texels[TexelIndex(expected, right, y)]
+			&& quad[2] == expected.texels[TexelIndex(expected, x, bottom)] && quad[3] == expected.texels[TexelIndex(expected, right, bottom)];
+	}
+}
+
+LUX_TEST(TextureCacheEviction)
+{
+	const Texture texture = MakeNoiseTexture();
+	const std::filesystem::path filePath = WriteTestTexture(texture, "LuxTextureCacheEviction.luxtex");
+	TextureCache cache{ 0 };
+	const std::optional<Texture> cached = cache.Open(filePath, testKey);
+	LUX_CHECK(cached);
+	if (!cached)
+	{
+		return;
+	}
+
+	bool matches{ true };
+	for (uint32_t level{ 0 }; level < texture.levels.size(); ++level)
+	{
+		for (uint32_t y{ 0 }; y < texture.levels[level].height; ++y)
+		{
+			for (uint32_t x{ 0 }; x < texture.levels[level].width; ++x)
+			{
+				matches = matches && FetchMatches(cache, *cached, texture, level, x, y);
+			}
+		}
+	}
+	LUX_CHECK(matches);
+
+	const TextureCacheReport report = cache.Report();
+	LUX_CHECK(report.evictions > 0);
+	LUX_CHECK(report.residentPages == report.capacityPages);
+	LUX_CHECK(report.uncachedLoads == 0);
+	LUX_CHECK(report.readErrors == 0);
+	std::filesystem::remove(filePath);
+}
+
+// Threads fetching random texels keep evicting each other's pages, pinning
+// keeps every page in place while its texels are read.
+LUX_TEST(TextureCachePinning)
+{
+	const Texture texture = MakeNoiseTexture();
+	const std::filesystem::path filePath = WriteTestTexture(texture, "LuxTextureCachePinning.luxtex");
+	TextureCache cache{ 0 };
+	const std::optional<Texture> cached = cache.Open(filePath, testKey);
+	LUX_CHECK(cached);
+	if (!cached)
+	{
+		return;
+	}
+
+	std::atomic<uint32_t> mismatches{ 0 };
+	std::vector<std::thread> threads;
+	for (uint32_t thread{ 0 }; thread < 8; ++thread)
+	{
+		threads.emplace_back([&, thread]
+		{
+			std::mt19937 random{ thread };
+			for (uint32_t fetch{ 0 }; fetch < 100000; ++fetch)
+			{
+				const uint32_t level = random() % 3;
+				const uint32_t x = random() % texture.levels[level].width;
+				const uint32_t y = random() % texture.levels[level].height;
+				if (!FetchMatches(cache, *cached, texture, level, x, y))
+				{
+					mismatches.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	LUX_CHECK(mismatches.load() == 0);
+	LUX_CHECK(cache.Report().evictions > 0);
+	std::filesystem::remove(filePath);
+}
+
+// A working set that fits is read once, every later lookup hits.
+LUX_TEST(TextureCacheHitRate)
+{
+	const Texture texture = MakeNoiseTexture();
+	const std::filesystem::path filePath = WriteTestTexture(texture, "LuxTextureCacheHitRate.luxtex");
+	TextureCache cache{ 0 };
+	const std::optional<Texture> cached = cache.Open(filePath, testKey);
+	LUX_CHECK(cached);
+	if (!cached)
+	{
+		return;
+	}
+
+	// 4x4 pages, corners of the last texels reach into the next ones.
+	constexpr uint32_t size = 4 * texturePageSize - 1;
+	for (uint32_t pass{ 0 }; pass < 10; ++pass)
+	{
+		for (uint32_t y{ 0 }; y < size; ++y)
+		{
+			for (uint32_t x{ 0 }; x < size; ++x)
+			{
+				cache.FetchQuad(cached->cacheID, 0, { x, x + 1 }, { y, y + 1 });
+			}
+		}
+	}
+
+	const TextureCacheReport report = cache.Report();
+	LUX_CHECK(report.misses == 16);
+	LUX_CHECK(report.evictions == 0);
+	LUX_CHECK(report.residentPages == 16);
+	LUX_CHECK(report.lookups > 10 * size * size);
+	std::filesystem::remove(filePath);
+}
+
+LUX_TEST(TextureCacheShortFile)
+{
+	const Texture texture = MakeNoiseTexture();
+	const std::filesystem::path filePath = WriteTestTexture(texture, "LuxTextureCacheShortFile.luxtex");
+	std::filesystem::resize_file(filePath, std::filesystem::file_size(filePath) - 1);
+	TextureCache cache{ 0 };
+	LUX_CHECK(!cache.Open(filePath, testKey));
+	std::filesystem::remove(filePath);
+}
+
+LUX_TEST(TextureCacheKeyMismatch)
+{
+	const Texture texture = MakeNoiseTexture();
+	const std::filesystem::path filePath = WriteTestTexture(texture, "LuxTextureCacheKeyMismatch.luxtex");
+	TextureCache cache{ 0 };
+	LUX_CHECK(cache.Open(filePath, testKey));
+	LUX_CHECK(!cache.Open(filePath, CacheKey{ testKey.identity, testKey.sourceSize + 1, testKey.sourceWriteTime }));
+	LUX_CHECK(!cache.Open(filePath, CacheKey{ testKey.identity, testKey.sourceSize, testKey.sourceWriteTime + 1 }));
+	LUX_CHECK(!cache.Open(filePath, CacheKey{ "LuxTests#other", testKey.sourceSize, testKey.sourceWriteTime }));
+	std::filesystem::remove(filePath);
+}